@@ -0,0 +1,476 @@
+/**
+ * @file eddy_bench.c
+ * @author Rafał Kędzierski (rafal.kedzierski@gmail.com)
+ * @brief Keystroke throughput benchmark.
+ * @version 0.1
+ * @date 2023-04-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * Runs fixed editing scenarios and prints one line of key=value pairs per
+ * scenario and line length:
+ *
+ *     scenario=insert_mid line_max=4096 line_len=256 keys=128000 ns_per_key=226.5
+ *         calls_per_key=2.00 bytes_per_key=135.00 allocs=0
+ *
+ * Only keys of the measured part are counted, line preparation and
+ * cleanup is done outside of it. Each key is passed with one put_chars call,
+ * the same way as terminal read returns it.
+ */
+#include "eddy.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_REPEATS		2000	/**< Repeats of measured part of scenario. */
+#define BENCH_BURST			64		/**< Keys in measured part of storm scenarios. */
+#define BENCH_COMMANDS		256		/**< Registered commands in exec_table scenario. */
+#define BENCH_CANDIDATES	4096	/**< Completion candidates in tab_complete scenario. */
+
+#define BENCH_KEY_LEFT		"\x1b[D"
+#define BENCH_KEY_RIGHT		"\x1b[C"
+#define BENCH_KEY_DELETE	"\x1b[3~"
+#define BENCH_KEY_F5		"\x1b[15~"
+#define BENCH_KEY_BS		"\x7f"
+
+/**
+ * @brief Counters of one scenario.
+ */
+typedef struct bench_stats_s {
+	double ns;				/**< Time of measured parts. */
+	unsigned long keys;		/**< Keys passed in measured parts. */
+	unsigned long calls;	/**< Print callback calls in measured parts. */
+	unsigned long bytes;	/**< Bytes printed in measured parts. */
+	unsigned long allocs;	/**< Allocations in measured parts. */
+	double start_ns;		/**< Start of current measured part. */
+	unsigned long start_calls;
+	unsigned long start_bytes;
+	unsigned long start_allocs;
+} bench_stats_t;
+
+static unsigned long bench_calls;
+static unsigned long bench_bytes;
+static unsigned long bench_allocs;
+
+/**
+ * @brief Counting replacement of library allocator.
+ */
+void* eddy_malloc(eddy_size_t size)
+{
+	bench_allocs++;
+	return malloc(size);
+}
+
+/**
+ * @brief Replacement of library allocator paired with eddy_malloc.
+ */
+void eddy_free(void* ptr)
+{
+	free(ptr);
+}
+
+static void bench_print(const char* string)
+{
+	bench_calls++;
+	bench_bytes += strlen(string);
+}
+
+static eddy_retv_t bench_exec(const char* cmd_line)
+{
+	(void)cmd_line;
+	return EDDY_RETV_OK;
+}
+
+static void bench_hint(char* cmd_line)
+{
+	if(strcmp(cmd_line, "sh") == 0) {
+		strcpy(cmd_line, "show ");
+	}
+}
+
+static double bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void bench_begin(bench_stats_t* stats)
+{
+	stats->start_calls = bench_calls;
+	stats->start_bytes = bench_bytes;
+	stats->start_allocs = bench_allocs;
+	stats->start_ns = bench_now_ns();
+}
+
+static void bench_end(bench_stats_t* stats, unsigned long keys)
+{
+	stats->ns += bench_now_ns() - stats->start_ns;
+	stats->keys += keys;
+	stats->calls += bench_calls - stats->start_calls;
+	stats->bytes += bench_bytes - stats->start_bytes;
+	stats->allocs += bench_allocs - stats->start_allocs;
+}
+
+static void bench_report(const char* scenario, unsigned int line_len, const bench_stats_t* stats)
+{
+	printf("scenario=%s line_max=%u line_len=%u keys=%lu ns_per_key=%.1f "
+		"calls_per_key=%.2f bytes_per_key=%.2f allocs=%lu\n",
+		scenario, (unsigned int)EDDY_MAX_LINE_BUFF_LEN, line_len, stats->keys,
+		stats->ns / stats->keys, (double)stats->calls / stats->keys,
+		(double)stats->bytes / stats->keys, stats->allocs);
+}
+
+static void bench_key(eddy_p eddy, const char* key)
+{
+	eddy->put_chars(eddy, key, strlen(key));
+}
+
+/**
+ * @brief Initialize context with line buffer of EDDY_MAX_LINE_BUFF_LEN, lines do not grow.
+ */
+static void bench_init(eddy_p eddy)
+{
+	static char line[EDDY_MAX_LINE_BUFF_LEN];
+
+	init_eddy(eddy);
+	eddy->set_line_buff(eddy, line, sizeof(line));
+	eddy->set_cli_print_clbk(eddy, bench_print);
+	eddy->set_exec_cmd_clbk(eddy, bench_exec);
+	eddy->set_check_hint_clbk(eddy, bench_hint);
+	eddy->set_hint_quiet(eddy, 1);
+}
+
+/**
+ * @brief Fill line with len characters and move cursor back by left positions.
+ */
+static void bench_prepare(eddy_p eddy, unsigned int len, unsigned int left)
+{
+	static char fill[EDDY_MAX_LINE_BUFF_LEN];
+	unsigned int idx;
+
+	memset(fill, 'x', len);
+	eddy->put_chars(eddy, fill, len);
+
+	for(idx = 0; idx < left; idx++) {
+		bench_key(eddy, BENCH_KEY_LEFT);
+	}
+}
+
+/**
+ * @brief Typing at the end of line, line is executed every BENCH_BURST keys.
+ */
+static void bench_type_eol(void)
+{
+	bench_stats_t stats = { 0 };
+	eddy_t eddy;
+	int rep;
+	int idx;
+
+	bench_init(&eddy);
+
+	for(rep = 0; rep < BENCH_REPEATS; rep++) {
+		bench_begin(&stats);
+		for(idx = 0; idx < BENCH_BURST; idx++) {
+			bench_key(&eddy, "a");
+		}
+		bench_end(&stats, BENCH_BURST);
+
+		bench_key(&eddy, "\r");
+	}
+
+	bench_report("type_eol", 0, &stats);
+	eddy.destroy(&eddy);
+}
+
+/**
+ * @brief Key storm in the middle or at the end of line.
+ *
+ * Line is filled with fill characters before storm. It has len characters
+ * before inserting and after deleting storm, so its length stays between
+ * len and len + BURST in both cases.
+ */
+static void bench_storm(const char* scenario, const char* key, unsigned int len, unsigned int fill, unsigned int left)
+{
+	bench_stats_t stats = { 0 };
+	eddy_t eddy;
+	int rep;
+	int idx;
+
+	bench_init(&eddy);
+
+	for(rep = 0; rep < BENCH_REPEATS; rep++) {
+		bench_prepare(&eddy, fill, left);
+
+		bench_begin(&stats);
+		for(idx = 0; idx < BENCH_BURST; idx++) {
+			bench_key(&eddy, key);
+		}
+		bench_end(&stats, BENCH_BURST);
+
+		bench_key(&eddy, "\r");
+	}
+
+	bench_report(scenario, len, &stats);
+	eddy.destroy(&eddy);
+}
+
+/**
+ * @brief Cursor keys and keys without handler on short line.
+ */
+static void bench_esc_flood(void)
+{
+	static const char* const keys[] = { BENCH_KEY_LEFT, BENCH_KEY_RIGHT, BENCH_KEY_F5 };
+	bench_stats_t stats = { 0 };
+	eddy_t eddy;
+	int rep;
+	int idx;
+
+	bench_init(&eddy);
+	bench_prepare(&eddy, BENCH_BURST, BENCH_BURST / 2);
+
+	for(rep = 0; rep < BENCH_REPEATS; rep++) {
+		bench_begin(&stats);
+		for(idx = 0; idx < BENCH_BURST; idx++) {
+			bench_key(&eddy, keys[idx % 3]);
+		}
+		bench_end(&stats, BENCH_BURST);
+	}
+
+	bench_report("esc_flood", BENCH_BURST, &stats);
+	eddy.destroy(&eddy);
+}
+
+/**
+ * @brief Hint key completing short command.
+ */
+static void bench_tab_hint(void)
+{
+	bench_stats_t stats = { 0 };
+	eddy_t eddy;
+	int rep;
+
+	bench_init(&eddy);
+
+	for(rep = 0; rep < BENCH_REPEATS; rep++) {
+		bench_key(&eddy, "s");
+		bench_key(&eddy, "h");
+
+		bench_begin(&stats);
+		bench_key(&eddy, "\t");
+		bench_end(&stats, 1);
+
+		bench_key(&eddy, "\r");
+	}
+
+	bench_report("tab_hint", 2, &stats);
+	eddy.destroy(&eddy);
+}
+
+/**
+ * @brief Typing and executing whole short command.
+ */
+static void bench_exec_cmd(void)
+{
+	static const char cmd[] = "set led 1\r";
+	bench_stats_t stats = { 0 };
+	eddy_t eddy;
+	char key[2] = { 0 };
+	int rep;
+	int idx;
+
+	bench_init(&eddy);
+
+	for(rep = 0; rep < BENCH_REPEATS; rep++) {
+		bench_begin(&stats);
+		for(idx = 0; cmd[idx] != '\0'; idx++) {
+			key[0] = cmd[idx];
+			bench_key(&eddy, key);
+		}
+		bench_end(&stats, sizeof(cmd) - 1);
+	}
+
+	bench_report("exec_cmd", sizeof(cmd) - 2, &stats);
+	eddy.destroy(&eddy);
+}
+
+/**
+ * @brief Block of BENCH_BURST command lines passed with one put_chars, as
+ * read from pipe, in interactive or batch mode.
+ */
+static void bench_script(const char* scenario, int batch)
+{
+	static const char cmd[] = "set led 1\n";
+	static char script[BENCH_BURST * (sizeof(cmd) - 1)];
+	bench_stats_t stats = { 0 };
+	eddy_t eddy;
+	int rep;
+	int idx;
+
+	for(idx = 0; idx < BENCH_BURST; idx++) {
+		memcpy(script + idx * (sizeof(cmd) - 1), cmd, sizeof(cmd) - 1);
+	}
+
+	bench_init(&eddy);
+	eddy.set_batch_mode(&eddy, batch);
+
+	for(rep = 0; rep < BENCH_REPEATS; rep++) {
+		bench_begin(&stats);
+		eddy.put_chars(&eddy, script, sizeof(script));
+		bench_end(&stats, sizeof(script));
+	}
+
+	bench_report(scenario, sizeof(cmd) - 2, &stats);
+	eddy.destroy(&eddy);
+}
+
+static eddy_retv_t bench_cmd(eddy_p self, int argc, char* argv[])
+{
+	(void)self;
+	(void)argc;
+	(void)argv;
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Typing and executing command found among registered commands.
+ */
+static void bench_exec_table(void)
+{
+	static char names[BENCH_COMMANDS][8];
+	static eddy_cmd_t cmds[BENCH_COMMANDS];
+	static const char cmd[] = "cmd171 led \"on\"\r";
+	bench_stats_t stats = { 0 };
+	eddy_t eddy;
+	char key[2] = { 0 };
+	int rep;
+	int idx;
+
+	for(idx = 0; idx < BENCH_COMMANDS; idx++) {
+		snprintf(names[idx], sizeof(names[idx]), "cmd%03d", (idx * 97) % BENCH_COMMANDS);
+		cmds[idx].name = names[idx];
+		cmds[idx].handler = bench_cmd;
+		cmds[idx].max_args = 4;
+	}
+
+	bench_init(&eddy);
+	eddy.set_cmd_table(&eddy, cmds, BENCH_COMMANDS);
+
+	for(rep = 0; rep < BENCH_REPEATS; rep++) {
+		bench_begin(&stats);
+		for(idx = 0; cmd[idx] != '\0'; idx++) {
+			key[0] = cmd[idx];
+			bench_key(&eddy, key);
+		}
+		bench_end(&stats, sizeof(cmd) - 1);
+	}
+
+	bench_report("exec_table", sizeof(cmd) - 2, &stats);
+	eddy.destroy(&eddy);
+}
+
+/**
+ * @brief Completion key with many candidates sharing prefixes.
+ */
+static void bench_tab_complete(void)
+{
+	static char names[BENCH_CANDIDATES][16];
+	static const char* words[BENCH_CANDIDATES];
+	static eddy_trie_node_t nodes[BENCH_CANDIDATES * 9];
+	bench_stats_t stats = { 0 };
+	eddy_trie_t trie;
+	eddy_t eddy;
+	int rep;
+	int idx;
+
+	for(idx = 0; idx < BENCH_CANDIDATES; idx++) {
+		snprintf(names[idx], sizeof(names[idx]), "if%04d-status", idx);
+		words[idx] = names[idx];
+	}
+
+	if(eddy_trie_build(&trie, nodes, sizeof(nodes) / sizeof(nodes[0]), words, BENCH_CANDIDATES) != EDDY_RETV_OK) {
+		return;
+	}
+
+	bench_init(&eddy);
+	eddy.set_completion(&eddy, &trie);
+
+	for(rep = 0; rep < BENCH_REPEATS; rep++) {
+		bench_key(&eddy, "if2718");
+
+		bench_begin(&stats);
+		bench_key(&eddy, "\t");
+		bench_end(&stats, 1);
+
+		bench_key(&eddy, "\r");
+	}
+
+	bench_report("tab_complete", 6, &stats);
+	eddy.destroy(&eddy);
+}
+
+#ifdef EDDY_USE_LOG_QUEUE
+/**
+ * @brief Log messages printed above half typed line, queue is drained when full.
+ */
+static void bench_log_storm(void)
+{
+	bench_stats_t stats = { 0 };
+	eddy_t eddy;
+	int rep;
+	int idx;
+
+	bench_init(&eddy);
+	bench_prepare(&eddy, 64, 32);
+
+	for(rep = 0; rep < BENCH_REPEATS; rep++) {
+		bench_begin(&stats);
+		for(idx = 0; idx < EDDY_LOG_SLOTS; idx++) {
+			eddy.put_log(&eddy, "eth0: link up, 1000 Mbps full duplex");
+		}
+		eddy.drain_logs(&eddy);
+		bench_end(&stats, EDDY_LOG_SLOTS);
+	}
+
+	bench_report("log_storm", 64, &stats);
+	eddy.destroy(&eddy);
+}
+#endif
+
+int main(void)
+{
+	static const unsigned int lens[] = { 64, 256, 1024, 4000 };
+	unsigned int len;
+	unsigned int idx;
+
+	bench_type_eol();
+
+	for(idx = 0; idx < sizeof(lens) / sizeof(lens[0]); idx++) {
+		if(lens[idx] + BENCH_BURST >= EDDY_MAX_LINE_BUFF_LEN) {
+			continue;
+		}
+
+		len = lens[idx] + BENCH_BURST;
+
+		bench_storm("insert_mid", "i", lens[idx], lens[idx], lens[idx] / 2);
+		bench_storm("backspace_eol", BENCH_KEY_BS, lens[idx], len, 0);
+		bench_storm("backspace_mid", BENCH_KEY_BS, lens[idx], len, len / 2);
+		bench_storm("delete_mid", BENCH_KEY_DELETE, lens[idx], len, len / 2);
+	}
+
+	bench_esc_flood();
+	bench_tab_hint();
+	bench_tab_complete();
+	bench_exec_cmd();
+	bench_script("script_interactive", 0);
+	bench_script("script_batch", 1);
+	bench_exec_table();
+#ifdef EDDY_USE_LOG_QUEUE
+	bench_log_storm();
+#endif
+
+	return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file eddy_line_bench.c
+ * @author Rafał Kędzierski (rafal.kedzierski@gmail.com)
+ * @brief Line storage microbenchmark.
+ * @version 0.1
+ * @date 2023-04-22
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ * Measures cost of edits in the middle of a long line. The same source
+ * is built with memmove line storage and with EDDY_USE_GAP_BUFFER, so
+ * results of both executables can be compared line by line.
+ */
+#include "eddy.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef EDDY_USE_GAP_BUFFER
+#define BENCH_STORAGE	"gap"
+#else
+#define BENCH_STORAGE	"memmove"
+#endif
+
+#define BENCH_ITERATIONS	2000	/**< Edits measured per line length. */
+#define BENCH_PASTE_LEN		64		/**< Characters pasted with single put_chars call. */
+
+static unsigned long bench_out_bytes;
+
+static void bench_print(const char* string)
+{
+	bench_out_bytes += strlen(string);
+}
+
+static eddy_retv_t bench_exec(const char* cmd_line)
+{
+	(void)cmd_line;
+	return EDDY_RETV_OK;
+}
+
+static double bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Fill line with len characters and put cursor in the middle.
+ */
+static void bench_prepare(eddy_p eddy, unsigned int len)
+{
+	static const char left[] = "\x1b[D";
+	unsigned int idx;
+
+	for(idx = 0; idx < len; idx++) {
+		eddy->put_chars(eddy, "x", 1);
+	}
+
+	for(idx = 0; idx < len / 2; idx++) {
+		eddy->put_chars(eddy, left, sizeof(left) - 1);
+	}
+}
+
+static void bench_line_len(unsigned int len)
+{
+	char paste[BENCH_PASTE_LEN];
+	char erase[BENCH_PASTE_LEN];
+	double start;
+	double paste_ns = 0;
+	double key_ns = 0;
+	eddy_t eddy;
+	int idx;
+
+	init_eddy(&eddy);
+	eddy.set_cli_print_clbk(&eddy, bench_print);
+	eddy.set_exec_cmd_clbk(&eddy, bench_exec);
+
+	memset(paste, 'p', sizeof(paste));
+	memset(erase, 0x7F, sizeof(erase));
+
+	bench_prepare(&eddy, len);
+
+	for(idx = 0; idx < BENCH_ITERATIONS; idx++) {
+		start = bench_now_ns();
+		eddy.put_chars(&eddy, paste, sizeof(paste));
+		paste_ns += bench_now_ns() - start;
+
+		eddy.put_chars(&eddy, erase, sizeof(erase));
+	}
+
+	for(idx = 0; idx < BENCH_ITERATIONS; idx++) {
+		start = bench_now_ns();
+		eddy.put_char(&eddy, 'k');
+		eddy.put_char(&eddy, 0x7F);
+		key_ns += bench_now_ns() - start;
+	}
+
+	printf("storage=%s line_len=%u paste_ns_per_char=%.1f key_ns_per_edit=%.1f\n",
+		BENCH_STORAGE, len,
+		paste_ns / ((double)BENCH_ITERATIONS * BENCH_PASTE_LEN),
+		key_ns / ((double)BENCH_ITERATIONS * 2));
+
+	eddy.destroy(&eddy);
+}
+
+int main(void)
+{
+	static const unsigned int lens[] = { 64, 256, 1024, 4096, 8192 };
+	unsigned int idx;
+
+	for(idx = 0; idx < sizeof(lens) / sizeof(lens[0]); idx++) {
+		if(lens[idx] + BENCH_PASTE_LEN < EDDY_MAX_LINE_BUFF_LEN) {
+			bench_line_len(lens[idx]);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file eddy_mem_report.c
+ * @author Rafał Kędzierski (rafal.kedzierski@gmail.com)
+ * @brief Memory used by one session.
+ * @version 0.1
+ * @date 2023-04-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * Prints one line of key=value pairs for library configuration it was
+ * built with:
+ *
+ *     ops=shared line_store=64 line_buff=256 eddy_t=16 ctx_heap=1135
+ *         pool_block=1600 session=1616 sessions=10000 total_kib=15781
+ *
+ * eddy_t is memory kept by application, ctx_heap is context allocated by
+ * init_eddy and pool_block is context with history taken by init_eddy_pool.
+ * Session is eddy_t with pool block, as in eddy_server.
+ */
+#include "eddy.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define REPORT_SESSIONS		10000	/**< Number of sessions in total. */
+#define REPORT_HIST_LEN		512		/**< History buffer of each session. */
+
+static eddy_size_t report_alloc;
+
+/**
+ * @brief Replacement of library allocator remembering allocated size.
+ */
+void* eddy_malloc(eddy_size_t size)
+{
+	report_alloc += size;
+	return malloc(size);
+}
+
+/**
+ * @brief Replacement of library allocator paired with eddy_malloc.
+ */
+void eddy_free(void* ptr)
+{
+	free(ptr);
+}
+
+int main(void)
+{
+	unsigned long session;
+	eddy_t eddy;
+
+	if(init_eddy(&eddy) != EDDY_RETV_OK) {
+		return 1;
+	}
+
+	eddy.ops->destroy(&eddy);
+
+	session = sizeof(eddy_t) + eddy_pool_block_size(REPORT_HIST_LEN);
+
+	printf("ops=%s line_store=%u line_buff=%u eddy_t=%lu ctx_heap=%lu pool_block=%lu session=%lu sessions=%u total_kib=%lu\n",
+#ifdef EDDY_USE_SHARED_OPS
+		"shared",
+#else
+		"per_context",
+#endif
+		(unsigned int)EDDY_LINE_STORE_LEN, (unsigned int)EDDY_MAX_LINE_BUFF_LEN, (unsigned long)sizeof(eddy_t), (unsigned long)report_alloc,
+		(unsigned long)eddy_pool_block_size(REPORT_HIST_LEN), session, REPORT_SESSIONS,
+		session * REPORT_SESSIONS / 1024);
+
+	return 0;
+}
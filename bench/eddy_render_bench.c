@@ -0,0 +1,179 @@
+/**
+ * @file eddy_render_bench.c
+ * @author Rafał Kędzierski (rafal.kedzierski@gmail.com)
+ * @brief Redraw cost benchmark on VT100 screen model.
+ * @version 0.1
+ * @date 2023-04-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * Runs scripted keystroke scenarios on narrow terminal, so lines wrap,
+ * and prints one line of key=value pairs per scenario:
+ *
+ *     scenario=insert_wrap cols=20 keys=5 bytes_per_key=45.00
+ *         moves_per_key=4.00 prints_per_key=1.00 screen=ok
+ *
+ * Output is interpreted by vt_screen, final screen and cursor are compared
+ * with expected line. Program fails if any screen does not match, so
+ * redraw optimizations can be checked for both cost and correctness.
+ */
+#include "eddy.h"
+#include "vt_screen.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define RENDER_COLS		20	/**< Terminal width, short enough to wrap the lines. */
+#define RENDER_ROWS		64	/**< Terminal height. */
+
+#define RENDER_LINE		"the quick brown fox jumps over the lazy dog"
+
+/**
+ * @brief Scripted scenario.
+ */
+typedef struct render_scenario_s {
+	const char* name;		/**< Scenario name. */
+	const char* prepare;	/**< Keys passed at once before measurement. */
+	const char* keys;		/**< Measured keys, each passed with one put_chars call. */
+	const char* line;		/**< Expected line after scenario. */
+	unsigned int cursor;	/**< Expected cursor position in line. */
+} render_scenario_t;
+
+static const render_scenario_t render_scenarios[] = {
+	{ "type_wrap", "", RENDER_LINE, RENDER_LINE, 43 },
+	{ "insert_wrap", RENDER_LINE "\x01\x1b" "f", " very",
+		"the very quick brown fox jumps over the lazy dog", 8 },
+	{ "delete_wrap", RENDER_LINE "\x01\x1b" "f", "\x1b[3~\x1b[3~\x1b[3~\x1b[3~\x1b[3~\x1b[3~",
+		"the brown fox jumps over the lazy dog", 3 },
+	{ "cursor_walk", RENDER_LINE, "\x01\x05\x01\x05\x1b" "b\x1b" "b\x1b" "b"
+		"\x1b[D\x1b[D\x1b[D\x1b[D\x1b[D\x1b[C\x1b[C\x1b[C\x1b[C\x1b[C", RENDER_LINE, 31 },
+	{ "kill_yank", RENDER_LINE, "\x17\x17\x01\x19\x0b\x19",
+		"lazy the quick brown fox jumps over the ", 40 },
+	{ "history_recall", RENDER_LINE "\rshow\r", "\x1b[A\x1b[A\x1b[B", "show", 4 },
+};
+
+static eddy_retv_t render_exec(const char* cmd_line)
+{
+	(void)cmd_line;
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Get length of key at the beginning of keys, escape sequence is one key.
+ */
+static unsigned int render_key_len(const char* keys)
+{
+	unsigned int len;
+
+	if(keys[0] != '\x1b') {
+		return 1;
+	}
+
+	if(keys[1] != '[' && keys[1] != 'O') {
+		return (keys[1] != '\0') ? 2 : 1;
+	}
+
+	for(len = 2; keys[len] != '\0'; len++) {
+		if((unsigned char)keys[len] >= 0x40 && (unsigned char)keys[len] <= 0x7E) {
+			return len + 1;
+		}
+	}
+
+	return len;
+}
+
+/**
+ * @brief Compare screen with prompt and expected line, cursor included.
+ */
+static int render_check(vt_screen_t* screen, const char* line, unsigned int cursor)
+{
+	char expected[RENDER_COLS + 1];
+	char text[RENDER_COLS * 8];
+	unsigned int cells;
+	unsigned int row;
+	unsigned int len;
+	unsigned int idx;
+
+	snprintf(text, sizeof(text), ">%s", line);
+	cells = (unsigned int)strlen(text);
+
+	if(screen->row < (cursor + 1) / RENDER_COLS || screen->col != (cursor + 1) % RENDER_COLS) {
+		return 0;
+	}
+
+	row = screen->row - (cursor + 1) / RENDER_COLS;
+
+	for(idx = 0; idx <= cells / RENDER_COLS + 1 && row + idx < screen->rows; idx++) {
+		len = (cells > idx * RENDER_COLS) ? cells - idx * RENDER_COLS : 0;
+		len = (len > RENDER_COLS) ? RENDER_COLS : len;
+
+		memcpy(expected, text + ((len > 0) ? idx * RENDER_COLS : 0), len);
+
+		while(len > 0 && expected[len - 1] == ' ') {
+			len--;
+		}
+
+		expected[len] = '\0';
+
+		if(strcmp(expected, vt_screen_row(screen, row + idx)) != 0) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * @brief Run one scenario and report its cost.
+ */
+static int render_run(const render_scenario_t* scenario)
+{
+	static vt_screen_t screen;
+	static char history[1024];
+	unsigned long keys = 0;
+	const char* key;
+	unsigned int len;
+	eddy_t eddy;
+	int ok;
+
+	vt_screen_init(&screen, RENDER_COLS, RENDER_ROWS);
+	vt_screen_attach(&screen);
+
+	init_eddy(&eddy);
+	eddy.set_cli_print_clbk(&eddy, vt_screen_print);
+	eddy.set_exec_cmd_clbk(&eddy, render_exec);
+	eddy.set_history_buff(&eddy, history, sizeof(history));
+	eddy.set_term_width(&eddy, RENDER_COLS);
+	eddy.show_prompt(&eddy);
+	eddy.put_chars(&eddy, scenario->prepare, strlen(scenario->prepare));
+
+	vt_screen_reset_counters(&screen);
+
+	for(key = scenario->keys; *key != '\0'; key += len) {
+		len = render_key_len(key);
+		eddy.put_chars(&eddy, key, len);
+		keys++;
+	}
+
+	ok = render_check(&screen, scenario->line, scenario->cursor) && screen.unknown == 0;
+
+	printf("scenario=%s cols=%u keys=%lu bytes_per_key=%.2f moves_per_key=%.2f prints_per_key=%.2f screen=%s\n",
+		scenario->name, RENDER_COLS, keys, (double)screen.bytes / keys, (double)screen.move_bytes / keys,
+		(double)screen.prints / keys, ok ? "ok" : "bad");
+
+	eddy.destroy(&eddy);
+
+	return ok;
+}
+
+int main(void)
+{
+	unsigned int idx;
+	int ok = 1;
+
+	for(idx = 0; idx < sizeof(render_scenarios) / sizeof(render_scenarios[0]); idx++) {
+		ok &= render_run(&render_scenarios[idx]);
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+/**
+ * @file eddy_loadgen.c
+ * @author Rafał Kędzierski (rafal.kedzierski@gmail.com)
+ * @brief Local client simulator for eddy_server.
+ * @version 0.1
+ * @date 2023-04-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * Usage: eddy_loadgen (-t port | -u path) [-c clients] [-i idle] [-n keys]
+ *
+ * Every active client waits for prompt, then types short commands one key
+ * at a time. Next key is sent when echo of previous one arrives, time from
+ * send to echo is recorded. Idle clients only keep connections open.
+ * Results are printed as key=value pairs.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define LOADGEN_LINE	"show status\r"	/**< Command typed repeatedly. */
+#define LOADGEN_PROMPT	'>'				/**< Last character of prompt. */
+#define LOADGEN_EVENTS	64				/**< Maximal number of events handled at once. */
+
+/**
+ * @brief Simulated client.
+ */
+typedef struct loadgen_client_s {
+	int fd;							/**< Connected socket. */
+	int ready;						/**< Prompt was received. */
+	unsigned long sent;				/**< Number of sent keys. */
+	unsigned long long send_ns;		/**< Time of sending last key. */
+} loadgen_client_t;
+
+static unsigned long long loadgen_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int loadgen_cmp(const void* a, const void* b)
+{
+	unsigned long long x = *(const unsigned long long*)a;
+	unsigned long long y = *(const unsigned long long*)b;
+
+	return (x > y) - (x < y);
+}
+
+static int loadgen_connect(int port, const char* path)
+{
+	struct sockaddr_in in_addr;
+	struct sockaddr_un un_addr;
+	int on = 1;
+	int fd;
+
+	if(path != NULL) {
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		memset(&un_addr, 0, sizeof(un_addr));
+		un_addr.sun_family = AF_UNIX;
+		strncpy(un_addr.sun_path, path, sizeof(un_addr.sun_path) - 1);
+
+		if(fd < 0 || connect(fd, (struct sockaddr*)&un_addr, sizeof(un_addr)) < 0) {
+			return -1;
+		}
+	} else {
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		memset(&in_addr, 0, sizeof(in_addr));
+		in_addr.sin_family = AF_INET;
+		in_addr.sin_port = htons(port);
+		in_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		if(fd < 0 || connect(fd, (struct sockaddr*)&in_addr, sizeof(in_addr)) < 0) {
+			return -1;
+		}
+
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+	}
+
+	return fd;
+}
+
+static void loadgen_send(loadgen_client_t* client)
+{
+	const char* line = LOADGEN_LINE;
+	char key = line[client->sent % (sizeof(LOADGEN_LINE) - 1)];
+
+	client->send_ns = loadgen_now_ns();
+	client->sent++;
+
+	if(write(client->fd, &key, 1) != 1) {
+		perror("write");
+		exit(1);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	struct epoll_event events[LOADGEN_EVENTS];
+	struct epoll_event event;
+	loadgen_client_t* clients;
+	loadgen_client_t* client;
+	unsigned long long* samples;
+	unsigned long long start_ns;
+	unsigned long long elapsed_ns;
+	unsigned long clients_cnt = 100;
+	unsigned long idle_cnt = 0;
+	unsigned long keys = 1000;
+	unsigned long samples_cnt = 0;
+	unsigned long done = 0;
+	unsigned long idx;
+	const char* path = NULL;
+	char buffer[512];
+	ssize_t len;
+	int port = -1;
+	int epfd;
+	int cnt;
+	int opt;
+	int ev;
+
+	while((opt = getopt(argc, argv, "t:u:c:i:n:")) != -1) {
+		switch(opt) {
+		case 't':
+			port = atoi(optarg);
+			break;
+		case 'u':
+			path = optarg;
+			break;
+		case 'c':
+			clients_cnt = strtoul(optarg, NULL, 0);
+			break;
+		case 'i':
+			idle_cnt = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			keys = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			port = -1;
+			path = NULL;
+			break;
+		}
+	}
+
+	if((port < 0 && path == NULL) || clients_cnt == 0 || keys == 0) {
+		fprintf(stderr, "usage: %s (-t port | -u path) [-c clients] [-i idle] [-n keys]\n", argv[0]);
+		return 1;
+	}
+
+	clients = calloc(clients_cnt + idle_cnt, sizeof(*clients));
+	samples = malloc(clients_cnt * keys * sizeof(*samples));
+	epfd = epoll_create1(0);
+
+	if(clients == NULL || samples == NULL || epfd < 0) {
+		perror("init");
+		return 1;
+	}
+
+	for(idx = 0; idx < clients_cnt + idle_cnt; idx++) {
+		clients[idx].fd = loadgen_connect(port, path);
+
+		if(clients[idx].fd < 0) {
+			fprintf(stderr, "connect failed after %lu clients: %s\n", idx, strerror(errno));
+			return 1;
+		}
+
+		if(idx < clients_cnt) {
+			event.events = EPOLLIN;
+			event.data.ptr = &clients[idx];
+			epoll_ctl(epfd, EPOLL_CTL_ADD, clients[idx].fd, &event);
+		}
+	}
+
+	start_ns = loadgen_now_ns();
+
+	while(done < clients_cnt) {
+		cnt = epoll_wait(epfd, events, LOADGEN_EVENTS, 5000);
+
+		if(cnt <= 0) {
+			fprintf(stderr, "server does not respond\n");
+			return 1;
+		}
+
+		for(ev = 0; ev < cnt; ev++) {
+			client = events[ev].data.ptr;
+			len = read(client->fd, buffer, sizeof(buffer));
+
+			if(len <= 0) {
+				fprintf(stderr, "connection closed by server\n");
+				return 1;
+			}
+
+			if(!client->ready) {
+				/* wait for the end of prompt, skipping telnet negotiation */
+				if(buffer[len - 1] != LOADGEN_PROMPT) {
+					continue;
+				}
+
+				client->ready = 1;
+			} else {
+				/* enter is answered with new line and prompt, other keys with echo */
+				if(LOADGEN_LINE[(client->sent - 1) % (sizeof(LOADGEN_LINE) - 1)] == '\r'
+					&& buffer[len - 1] != LOADGEN_PROMPT) {
+					continue;
+				}
+
+				samples[samples_cnt++] = loadgen_now_ns() - client->send_ns;
+			}
+
+			if(client->sent < keys) {
+				loadgen_send(client);
+			} else {
+				done++;
+			}
+		}
+	}
+
+	elapsed_ns = loadgen_now_ns() - start_ns;
+
+	qsort(samples, samples_cnt, sizeof(*samples), loadgen_cmp);
+
+	printf("clients=%lu idle=%lu keys=%lu elapsed_ms=%.1f keys_per_s=%.0f "
+		"p50_us=%.1f p90_us=%.1f p99_us=%.1f p999_us=%.1f max_us=%.1f\n",
+		clients_cnt, idle_cnt, samples_cnt, elapsed_ns / 1e6, samples_cnt / (elapsed_ns / 1e9),
+		samples[samples_cnt * 50 / 100] / 1e3, samples[samples_cnt * 90 / 100] / 1e3,
+		samples[samples_cnt * 99 / 100] / 1e3, samples[samples_cnt * 999 / 1000] / 1e3,
+		samples[samples_cnt - 1] / 1e3);
+
+	for(idx = 0; idx < clients_cnt + idle_cnt; idx++) {
+		close(clients[idx].fd);
+	}
+
+	free(samples);
+	free(clients);
+	close(epfd);
+
+	return 0;
+}
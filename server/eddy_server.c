@@ -0,0 +1,747 @@
+/**
+ * @file eddy_server.c
+ * @author Rafał Kędzierski (rafal.kedzierski@gmail.com)
+ * @brief Event-driven multi-session server front-end for eddy.
+ * @version 0.1
+ * @date 2023-04-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#define _GNU_SOURCE
+#include "eddy_server.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#define EDDY_NULL 0
+
+/**
+ * @{ \name Kinds of epoll handles.
+ */
+#define EDDY_SERVER_LISTENER	0	/**< Listening socket. */
+#define EDDY_SERVER_SESSION		1	/**< Connected session. */
+#define EDDY_SERVER_UNUSED		2	/**< Session not connected. */
+/**
+ * @}
+ */
+
+/**
+ * @{ \name Telnet protocol codes.
+ */
+#define TELNET_SE		240	/**< End of subnegotiation. */
+#define TELNET_SB		250	/**< Start of subnegotiation. */
+#define TELNET_WILL		251	/**< Sender wants to enable option. */
+#define TELNET_WONT		252	/**< Sender refuses option. */
+#define TELNET_DO		253	/**< Sender wants receiver to enable option. */
+#define TELNET_DONT		254	/**< Sender wants receiver to disable option. */
+#define TELNET_IAC		255	/**< Interpret as command. */
+#define TELNET_ECHO		1	/**< Echo option. */
+#define TELNET_SGA		3	/**< Suppress go ahead option. */
+/**
+ * @}
+ */
+
+/**
+ * @{ \name Telnet input parser states.
+ */
+#define TELNET_STATE_DATA		0	/**< Plain data. */
+#define TELNET_STATE_IAC		1	/**< After IAC. */
+#define TELNET_STATE_OPT		2	/**< After WILL, WONT, DO or DONT. */
+#define TELNET_STATE_SB			3	/**< Inside subnegotiation. */
+#define TELNET_STATE_SB_IAC		4	/**< After IAC inside subnegotiation. */
+/**
+ * @}
+ */
+
+/**
+ * @brief Negotiation sent on new telnet connection: server echoes and works in character mode.
+ */
+static const char telnet_greeting[] = {
+	(char)TELNET_IAC, (char)TELNET_WILL, TELNET_ECHO,
+	(char)TELNET_IAC, (char)TELNET_WILL, TELNET_SGA,
+	(char)TELNET_IAC, (char)TELNET_DO, TELNET_SGA,
+};
+
+/**
+ * @brief Session which input is processed now.
+ */
+static eddy_server_session_p eddy_server_active;
+
+/**
+ * @{ \name Private functions declarations.
+ */
+static void eddy_server_write(eddy_p self, const eddy_segment_t* segments, eddy_size_t count);
+static eddy_retv_t eddy_server_listen(eddy_server_p server, int fd, unsigned char telnet);
+static void eddy_server_accept(eddy_server_p server, eddy_server_handle_t* listener);
+static void eddy_server_read(eddy_server_session_p session);
+static void eddy_server_drain(eddy_server_session_p session);
+static void eddy_server_update(eddy_server_session_p session);
+static void eddy_server_release(eddy_server_session_p session);
+static eddy_size_t eddy_server_filter(eddy_server_session_p session, char* buffer, eddy_size_t len);
+/**
+ * @}
+ */
+
+eddy_retv_t eddy_server_init(eddy_server_p server, eddy_size_t max_sessions)
+{
+	eddy_size_t block_size;
+	eddy_size_t idx;
+
+	if(server == EDDY_NULL || max_sessions == 0) {
+		return EDDY_RETV_ERR;
+	}
+
+	memset(server, 0, sizeof(*server));
+
+	server->epfd = epoll_create1(EPOLL_CLOEXEC);
+
+	if(server->epfd < 0) {
+		return EDDY_RETV_ERR;
+	}
+
+	server->max_sessions = max_sessions;
+	server->sessions = eddy_malloc(max_sessions * sizeof(eddy_server_session_t));
+	block_size = eddy_pool_block_size(EDDY_SERVER_HIST_LEN);
+	server->slab = eddy_malloc(max_sessions * block_size + EDDY_CACHE_LINE - 1);
+
+	if(server->sessions == EDDY_NULL || server->slab == EDDY_NULL) {
+		eddy_server_destroy(server);
+		return EDDY_RETV_ERR;
+	}
+
+	eddy_pool_init(&server->pool, server->slab, max_sessions * block_size + EDDY_CACHE_LINE - 1, EDDY_SERVER_HIST_LEN);
+
+	for(idx = max_sessions; idx > 0; idx--) {
+		server->sessions[idx - 1].handle.kind = EDDY_SERVER_UNUSED;
+		server->sessions[idx - 1].next_free = server->free_sessions;
+		server->free_sessions = &server->sessions[idx - 1];
+	}
+
+	return EDDY_RETV_OK;
+}
+
+eddy_retv_t eddy_server_listen_tcp(eddy_server_p server, unsigned short port)
+{
+	struct sockaddr_in addr;
+	int on = 1;
+	int fd;
+
+	if(server == EDDY_NULL || server->listeners_cnt >= EDDY_SERVER_MAX_LISTENERS) {
+		return EDDY_RETV_ERR;
+	}
+
+	fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+	if(fd < 0) {
+		return EDDY_RETV_ERR;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+	if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+		close(fd);
+		return EDDY_RETV_ERR;
+	}
+
+	return eddy_server_listen(server, fd, 1);
+}
+
+eddy_retv_t eddy_server_listen_unix(eddy_server_p server, const char* path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	if(server == EDDY_NULL || path == EDDY_NULL || strlen(path) >= sizeof(addr.sun_path)
+		|| server->listeners_cnt >= EDDY_SERVER_MAX_LISTENERS) {
+		return EDDY_RETV_ERR;
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+	if(fd < 0) {
+		return EDDY_RETV_ERR;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	unlink(path);
+
+	if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+		close(fd);
+		return EDDY_RETV_ERR;
+	}
+
+	return eddy_server_listen(server, fd, 0);
+}
+
+eddy_retv_t eddy_server_set_exec_cmd_clbk(eddy_server_p server, eddy_exec_cmd_clbk exec_cmd_clbk)
+{
+	if(server == EDDY_NULL || exec_cmd_clbk == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	server->exec_cmd_clbk = exec_cmd_clbk;
+
+	return EDDY_RETV_OK;
+}
+
+eddy_retv_t eddy_server_set_cmd_table(eddy_server_p server, eddy_cmd_t* table, eddy_size_t count)
+{
+	if(server == EDDY_NULL || table == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	server->cmd_table = table;
+	server->cmd_cnt = count;
+
+	return EDDY_RETV_OK;
+}
+
+eddy_retv_t eddy_server_set_cmd_map(eddy_server_p server, const eddy_cmd_map_t* map)
+{
+	if(server == EDDY_NULL || map == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	server->cmd_map = map;
+
+	return EDDY_RETV_OK;
+}
+
+eddy_retv_t eddy_server_set_check_hint_clbk(eddy_server_p server, eddy_check_hint_clbk check_hint_clbk)
+{
+	if(server == EDDY_NULL || check_hint_clbk == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	server->check_hint_clbk = check_hint_clbk;
+
+	return EDDY_RETV_OK;
+}
+
+eddy_retv_t eddy_server_set_prompt(eddy_server_p server, char* prompt)
+{
+	if(server == EDDY_NULL || prompt == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	server->prompt = prompt;
+
+	return EDDY_RETV_OK;
+}
+
+eddy_retv_t eddy_server_poll(eddy_server_p server, int timeout_ms)
+{
+	struct epoll_event events[EDDY_SERVER_MAX_EVENTS];
+	eddy_server_handle_t* handle;
+	eddy_server_session_p session;
+	int cnt;
+	int idx;
+
+	if(server == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	cnt = epoll_wait(server->epfd, events, EDDY_SERVER_MAX_EVENTS, timeout_ms);
+
+	if(cnt < 0) {
+		return (errno == EINTR) ? EDDY_RETV_OK : EDDY_RETV_ERR;
+	}
+
+	for(idx = 0; idx < cnt; idx++) {
+		handle = events[idx].data.ptr;
+
+		if(handle->kind == EDDY_SERVER_LISTENER) {
+			eddy_server_accept(server, handle);
+			continue;
+		}
+
+		session = (eddy_server_session_p)handle;
+
+		if(events[idx].events & EPOLLOUT) {
+			eddy_server_drain(session);
+		}
+
+		if((events[idx].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !session->closing) {
+			eddy_server_read(session);
+		}
+
+		eddy_server_update(session);
+	}
+
+	return EDDY_RETV_OK;
+}
+
+eddy_server_session_p eddy_server_current(void)
+{
+	return eddy_server_active;
+}
+
+eddy_retv_t eddy_server_send(eddy_server_session_p session, const char* data, eddy_size_t len)
+{
+	eddy_segment_t segment;
+
+	if(session == EDDY_NULL || data == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	segment.data = data;
+	segment.len = len;
+
+	eddy_server_write(&session->eddy, &segment, 1);
+
+	return session->closing ? EDDY_RETV_ERR : EDDY_RETV_OK;
+}
+
+eddy_retv_t eddy_server_command_done(eddy_server_session_p session, eddy_retv_t status)
+{
+	eddy_retv_t error;
+
+	if(session == EDDY_NULL || session->handle.kind != EDDY_SERVER_SESSION) {
+		return EDDY_RETV_ERR;
+	}
+
+	eddy_server_active = session;
+	error = session->eddy.ops->command_done(&session->eddy, status);
+	eddy_server_active = EDDY_NULL;
+
+	eddy_server_update(session);
+
+	return error;
+}
+
+void eddy_server_close(eddy_server_session_p session)
+{
+	if(session != EDDY_NULL) {
+		session->closing = 1;
+	}
+}
+
+eddy_retv_t eddy_server_destroy(eddy_server_p server)
+{
+	eddy_size_t idx;
+
+	if(server == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	if(server->sessions != EDDY_NULL) {
+		for(idx = 0; idx < server->max_sessions; idx++) {
+			if(server->sessions[idx].handle.kind == EDDY_SERVER_SESSION) {
+				eddy_server_release(&server->sessions[idx]);
+			}
+		}
+	}
+
+	for(idx = 0; idx < server->listeners_cnt; idx++) {
+		close(server->listeners[idx].fd);
+	}
+
+	if(server->epfd >= 0) {
+		close(server->epfd);
+	}
+
+	eddy_free(server->sessions);
+	eddy_free(server->slab);
+
+	server->sessions = EDDY_NULL;
+	server->slab = EDDY_NULL;
+	server->listeners_cnt = 0;
+	server->epfd = -1;
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Start listening on bound socket and register it in epoll.
+ *
+ * @param server Pointer on server.
+ * @param fd Bound socket.
+ * @param telnet Telnet protocol is used by accepted sessions if not zero.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+static eddy_retv_t eddy_server_listen(eddy_server_p server, int fd, unsigned char telnet)
+{
+	eddy_server_handle_t* listener = &server->listeners[server->listeners_cnt];
+	struct epoll_event event;
+
+	listener->fd = fd;
+	listener->kind = EDDY_SERVER_LISTENER;
+	listener->telnet = telnet;
+
+	event.events = EPOLLIN;
+	event.data.ptr = listener;
+
+	if(listen(fd, SOMAXCONN) < 0 || epoll_ctl(server->epfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+		close(fd);
+		return EDDY_RETV_ERR;
+	}
+
+	server->listeners_cnt++;
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Accept all pending connections of listener.
+ *
+ * Connections above session limit are closed immediately.
+ *
+ * @param server Pointer on server.
+ * @param listener Listening socket handle.
+ */
+static void eddy_server_accept(eddy_server_p server, eddy_server_handle_t* listener)
+{
+	eddy_server_session_p session;
+	struct epoll_event event;
+	int on = 1;
+	int fd;
+
+	while((fd = accept4(listener->fd, EDDY_NULL, EDDY_NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+		session = server->free_sessions;
+
+		if(session == EDDY_NULL || init_eddy_pool(&session->eddy, &server->pool) != EDDY_RETV_OK) {
+			close(fd);
+			continue;
+		}
+
+		server->free_sessions = session->next_free;
+		session->serial = ++server->accepted;
+		server->active_sessions++;
+
+		if(listener->telnet) {
+			/* echo of every key is sent at once */
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+		}
+
+		session->handle.fd = fd;
+		session->handle.kind = EDDY_SERVER_SESSION;
+		session->handle.telnet = listener->telnet;
+		session->server = server;
+		session->events = EPOLLIN;
+		session->closing = 0;
+		session->tn_state = TELNET_STATE_DATA;
+		session->cr = 0;
+		session->out_head = 0;
+		session->out_len = 0;
+
+		event.events = EPOLLIN;
+		event.data.ptr = session;
+
+		if(epoll_ctl(server->epfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+			eddy_server_release(session);
+			continue;
+		}
+
+		session->eddy.ops->set_cli_write_clbk(&session->eddy, eddy_server_write);
+
+		if(server->exec_cmd_clbk != EDDY_NULL) {
+			session->eddy.ops->set_exec_cmd_clbk(&session->eddy, server->exec_cmd_clbk);
+		}
+
+		if(server->cmd_table != EDDY_NULL) {
+			session->eddy.ops->set_cmd_table(&session->eddy, server->cmd_table, server->cmd_cnt);
+		}
+
+		if(server->cmd_map != EDDY_NULL) {
+			session->eddy.ops->set_cmd_map(&session->eddy, server->cmd_map);
+		}
+
+		if(server->check_hint_clbk != EDDY_NULL) {
+			session->eddy.ops->set_check_hint_clbk(&session->eddy, server->check_hint_clbk);
+		}
+
+		if(server->prompt != EDDY_NULL) {
+			session->eddy.ops->set_prompt(&session->eddy, server->prompt);
+		}
+
+		if(session->handle.telnet) {
+			eddy_server_send(session, telnet_greeting, sizeof(telnet_greeting));
+		}
+
+		session->eddy.ops->show_prompt(&session->eddy);
+		eddy_server_update(session);
+	}
+}
+
+/**
+ * @brief Read available input of session and pass it to editor at once.
+ *
+ * @param session Pointer on session.
+ */
+static void eddy_server_read(eddy_server_session_p session)
+{
+	char* buffer = session->server->read_buff;
+	ssize_t len;
+
+	len = read(session->handle.fd, buffer, EDDY_SERVER_READ_LEN);
+
+	if(len <= 0) {
+		if(len == 0 || (errno != EAGAIN && errno != EINTR)) {
+			session->closing = 1;
+		}
+		return;
+	}
+
+	len = eddy_server_filter(session, buffer, len);
+
+	if(len > 0) {
+		eddy_server_active = session;
+		session->eddy.ops->put_chars(&session->eddy, buffer, len);
+		eddy_server_active = EDDY_NULL;
+	}
+}
+
+/**
+ * @brief Write queued output of session.
+ *
+ * @param session Pointer on session.
+ */
+static void eddy_server_drain(eddy_server_session_p session)
+{
+	ssize_t len;
+
+	if(session->out_len == 0) {
+		return;
+	}
+
+	len = write(session->handle.fd, session->out_buff + session->out_head, session->out_len);
+
+	if(len < 0) {
+		if(errno != EAGAIN && errno != EINTR) {
+			session->closing = 1;
+		}
+		return;
+	}
+
+	session->out_head += len;
+	session->out_len -= len;
+
+	if(session->out_len == 0) {
+		session->out_head = 0;
+	}
+}
+
+/**
+ * @brief Register events session waits for or release closed session.
+ *
+ * Input is not read while output queue is above high water level, so
+ * client which does not read output can not make server buffer more.
+ *
+ * @param session Pointer on session.
+ */
+static void eddy_server_update(eddy_server_session_p session)
+{
+	struct epoll_event event;
+
+	if(session->closing) {
+		eddy_server_release(session);
+		return;
+	}
+
+	event.events = 0;
+
+	if(session->out_len < EDDY_SERVER_OUT_HIGH_WATER) {
+		event.events |= EPOLLIN;
+	}
+
+	if(session->out_len > 0) {
+		event.events |= EPOLLOUT;
+	}
+
+	if(event.events != session->events) {
+		event.data.ptr = session;
+		epoll_ctl(session->server->epfd, EPOLL_CTL_MOD, session->handle.fd, &event);
+		session->events = event.events;
+	}
+}
+
+/**
+ * @brief Close session and return it with its editor context to pools.
+ *
+ * @param session Pointer on session.
+ */
+static void eddy_server_release(eddy_server_session_p session)
+{
+	eddy_server_p server = session->server;
+
+	close(session->handle.fd);
+
+	/* output of closed session is dropped */
+	session->out_len = 0;
+	session->closing = 1;
+	session->eddy.ops->destroy(&session->eddy);
+
+	session->handle.kind = EDDY_SERVER_UNUSED;
+	session->next_free = server->free_sessions;
+	server->free_sessions = session;
+	server->active_sessions--;
+}
+
+/**
+ * @brief Remove telnet commands and line end duplicates from input.
+ *
+ * Input is filtered in place. Negotiation requests other than echo and
+ * suppress go ahead are refused. Carriage return followed by new line
+ * or NUL is passed as single character.
+ *
+ * @param session Pointer on session.
+ * @param buffer Input data.
+ * @param len Length of input data.
+ * @return eddy_size_t Length of filtered data.
+ */
+static eddy_size_t eddy_server_filter(eddy_server_session_p session, char* buffer, eddy_size_t len)
+{
+	eddy_size_t out = 0;
+	eddy_size_t idx;
+	unsigned char c;
+	char reply[3];
+
+	for(idx = 0; idx < len; idx++) {
+		c = (unsigned char)buffer[idx];
+
+		switch(session->tn_state) {
+		case TELNET_STATE_IAC:
+			session->tn_state = TELNET_STATE_DATA;
+
+			if(c >= TELNET_WILL && c <= TELNET_DONT) {
+				session->tn_cmd = c;
+				session->tn_state = TELNET_STATE_OPT;
+			} else if(c == TELNET_SB) {
+				session->tn_state = TELNET_STATE_SB;
+			} else if(c == TELNET_IAC) {
+				buffer[out++] = (char)c;
+			}
+			continue;
+		case TELNET_STATE_OPT:
+			session->tn_state = TELNET_STATE_DATA;
+
+			if(c != TELNET_ECHO && c != TELNET_SGA) {
+				if(session->tn_cmd == TELNET_WILL) {
+					reply[1] = (char)TELNET_DONT;
+				} else if(session->tn_cmd == TELNET_DO) {
+					reply[1] = (char)TELNET_WONT;
+				} else {
+					continue;
+				}
+
+				reply[0] = (char)TELNET_IAC;
+				reply[2] = (char)c;
+				eddy_server_send(session, reply, sizeof(reply));
+			}
+			continue;
+		case TELNET_STATE_SB:
+			if(c == TELNET_IAC) {
+				session->tn_state = TELNET_STATE_SB_IAC;
+			}
+			continue;
+		case TELNET_STATE_SB_IAC:
+			session->tn_state = (c == TELNET_SE) ? TELNET_STATE_DATA : TELNET_STATE_SB;
+			continue;
+		default:
+			break;
+		}
+
+		if(c == TELNET_IAC && session->handle.telnet) {
+			session->tn_state = TELNET_STATE_IAC;
+			continue;
+		}
+
+		if(session->cr && (c == '\n' || c == '\0')) {
+			session->cr = 0;
+			continue;
+		}
+
+		session->cr = (c == '\r');
+		buffer[out++] = (char)c;
+	}
+
+	return out;
+}
+
+/**
+ * @brief Scatter-gather print callback of all sessions.
+ *
+ * Output is written directly when queue is empty, the rest is queued.
+ * Session is closed when queue overflows.
+ *
+ * @param self Pointer on library context of session.
+ * @param segments Array of segments to print in order.
+ * @param count Number of segments in array.
+ */
+static void eddy_server_write(eddy_p self, const eddy_segment_t* segments, eddy_size_t count)
+{
+	eddy_server_session_p session;
+	struct iovec iov[EDDY_OUT_MAX_SEGMENTS];
+	eddy_size_t written = 0;
+	eddy_size_t total = 0;
+	eddy_size_t skip;
+	eddy_size_t idx;
+	ssize_t len;
+
+	session = (eddy_server_session_p)((char*)self - offsetof(eddy_server_session_t, eddy));
+
+	if(session->closing) {
+		return;
+	}
+
+	for(idx = 0; idx < count; idx++) {
+		total += segments[idx].len;
+	}
+
+	if(session->out_len == 0 && count <= EDDY_OUT_MAX_SEGMENTS) {
+		for(idx = 0; idx < count; idx++) {
+			iov[idx].iov_base = (void*)segments[idx].data;
+			iov[idx].iov_len = segments[idx].len;
+		}
+
+		len = writev(session->handle.fd, iov, count);
+
+		if(len < 0 && errno != EAGAIN && errno != EINTR) {
+			session->closing = 1;
+			return;
+		}
+
+		written = (len > 0) ? (eddy_size_t)len : 0;
+	}
+
+	if(total - written > EDDY_SERVER_OUT_BUFF_LEN - session->out_len) {
+		session->closing = 1;
+		return;
+	}
+
+	if(session->out_head + session->out_len + (total - written) > EDDY_SERVER_OUT_BUFF_LEN) {
+		memmove(session->out_buff, session->out_buff + session->out_head, session->out_len);
+		session->out_head = 0;
+	}
+
+	for(idx = 0; idx < count; idx++) {
+		if(written >= segments[idx].len) {
+			written -= segments[idx].len;
+			continue;
+		}
+
+		skip = written;
+		written = 0;
+
+		memcpy(session->out_buff + session->out_head + session->out_len,
+			segments[idx].data + skip, segments[idx].len - skip);
+		session->out_len += segments[idx].len - skip;
+	}
+}
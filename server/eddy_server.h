@@ -0,0 +1,291 @@
+/**
+ * @file eddy_server.h
+ * @author Rafał Kędzierski (rafal.kedzierski@gmail.com)
+ * @brief Event-driven multi-session server front-end for eddy.
+ * @version 0.1
+ * @date 2023-04-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * One epoll loop owns all sessions. Each accepted connection gets its own
+ * eddy context taken from a fixed pool, input is read in chunks and passed
+ * to put_chars, output is written with scatter-gather callback and queued
+ * per session when socket is not writable. Linux only.
+ */
+#ifndef __EDDY_SERVER_H__
+#define __EDDY_SERVER_H__
+
+#include "eddy.h"
+
+/**
+ * @brief Size of per session output queue
+ *
+ * Session which does not read its output and fills the whole queue is closed.
+ */
+#ifndef EDDY_SERVER_OUT_BUFF_LEN
+#define EDDY_SERVER_OUT_BUFF_LEN	4096
+#endif
+
+/**
+ * @brief Output queue fill level which stops reading input of session
+ *
+ * Reading is resumed when queue is drained.
+ */
+#ifndef EDDY_SERVER_OUT_HIGH_WATER
+#define EDDY_SERVER_OUT_HIGH_WATER	(EDDY_SERVER_OUT_BUFF_LEN / 2)
+#endif
+
+/**
+ * @brief Maximal number of bytes read from session at once
+ */
+#ifndef EDDY_SERVER_READ_LEN
+#define EDDY_SERVER_READ_LEN	512
+#endif
+
+/**
+ * @brief Size of history buffer of each session
+ */
+#ifndef EDDY_SERVER_HIST_LEN
+#define EDDY_SERVER_HIST_LEN	512
+#endif
+
+/**
+ * @brief Maximal number of listening sockets
+ */
+#ifndef EDDY_SERVER_MAX_LISTENERS
+#define EDDY_SERVER_MAX_LISTENERS	4
+#endif
+
+/**
+ * @brief Maximal number of events handled by one poll call
+ */
+#ifndef EDDY_SERVER_MAX_EVENTS
+#define EDDY_SERVER_MAX_EVENTS	64
+#endif
+
+/**
+ * @brief Forward declarations
+ * @{
+ */
+struct eddy_server_s;
+struct eddy_server_session_s;
+/**
+ * @}
+ */
+
+/**
+ * @brief Definition of eddy_server_s struct type.
+ * @see eddy_server_s
+ */
+typedef struct eddy_server_s eddy_server_t;
+
+/**
+ * @brief Definition of pointer on eddy_server_s struct type.
+ * @see eddy_server_s
+ */
+typedef struct eddy_server_s* eddy_server_p;
+
+/**
+ * @brief Definition of eddy_server_session_s struct type.
+ * @see eddy_server_session_s
+ */
+typedef struct eddy_server_session_s eddy_server_session_t;
+
+/**
+ * @brief Definition of pointer on eddy_server_session_s struct type.
+ * @see eddy_server_session_s
+ */
+typedef struct eddy_server_session_s* eddy_server_session_p;
+
+/**
+ * @brief Common head of objects registered in epoll.
+ */
+typedef struct eddy_server_handle_s {
+	int fd;						/**< Socket descriptor. */
+	unsigned char kind;			/**< Listener or session. */
+	unsigned char telnet;		/**< Telnet protocol is used on socket. */
+} eddy_server_handle_t;
+
+/**
+ * @brief Connected session.
+ */
+struct eddy_server_session_s {
+	eddy_server_handle_t handle;		/**< Epoll registered handle, must be first. */
+	eddy_t eddy;						/**< Line editor of session. */
+	eddy_server_p server;				/**< Server owning session. */
+	eddy_server_session_p next_free;	/**< Next unused session. */
+	unsigned long serial;				/**< Number of connection, differs when session is reused. */
+	unsigned int events;				/**< Events currently registered in epoll. */
+	unsigned char closing;				/**< Session is closed after current event. */
+	unsigned char tn_state;				/**< Telnet input parser state. */
+	unsigned char tn_cmd;				/**< Telnet negotiation command in progress. */
+	unsigned char cr;					/**< Last input character was carriage return. */
+	unsigned int out_head;				/**< Offset of first queued output byte. */
+	unsigned int out_len;				/**< Number of queued output bytes. */
+	char out_buff[EDDY_SERVER_OUT_BUFF_LEN];	/**< Output queue. */
+};
+
+/**
+ * @brief Server state.
+ */
+struct eddy_server_s {
+	int epfd;											/**< Epoll descriptor. */
+	eddy_server_handle_t listeners[EDDY_SERVER_MAX_LISTENERS];	/**< Listening sockets. */
+	unsigned int listeners_cnt;							/**< Number of listening sockets. */
+	eddy_server_session_p sessions;						/**< Array of all sessions. */
+	eddy_server_session_p free_sessions;				/**< List of unused sessions. */
+	eddy_size_t max_sessions;							/**< Size of sessions array. */
+	eddy_size_t active_sessions;						/**< Number of connected sessions. */
+	unsigned long accepted;								/**< Number of accepted connections. */
+	eddy_pool_t pool;									/**< Pool of eddy contexts. */
+	void* slab;											/**< Memory of contexts pool. */
+	eddy_exec_cmd_clbk exec_cmd_clbk;					/**< Command execution callback of all sessions. */
+	eddy_check_hint_clbk check_hint_clbk;				/**< Hint callback of all sessions. */
+	eddy_cmd_t* cmd_table;								/**< Commands registered in all sessions. */
+	eddy_size_t cmd_cnt;								/**< Number of registered commands. */
+	const eddy_cmd_map_t* cmd_map;						/**< Const map of commands of all sessions. */
+	char* prompt;										/**< Prompt of all sessions. */
+	char read_buff[EDDY_SERVER_READ_LEN];				/**< Input buffer shared by sessions. */
+};
+
+/**
+ * @brief Server initialization function
+ *
+ * Allocates memory for all sessions at once.
+ *
+ * @param server Pointer on server.
+ * @param max_sessions Maximal number of connected sessions.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_server_init(eddy_server_p server, eddy_size_t max_sessions);
+
+/**
+ * @brief Listen on TCP port of loopback interface with telnet protocol.
+ *
+ * @param server Pointer on server.
+ * @param port TCP port number.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_server_listen_tcp(eddy_server_p server, unsigned short port);
+
+/**
+ * @brief Listen on Unix stream socket.
+ *
+ * @param server Pointer on server.
+ * @param path Path of socket, existing file is removed.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_server_listen_unix(eddy_server_p server, const char* path);
+
+/**
+ * @brief Set command execution callback used by new sessions.
+ *
+ * Session which executes command is returned by eddy_server_current.
+ *
+ * @param server Pointer on server.
+ * @param exec_cmd_clbk Pointer on command execution function.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_server_set_exec_cmd_clbk(eddy_server_p server, eddy_exec_cmd_clbk exec_cmd_clbk);
+
+/**
+ * @brief Set table of commands registered in new sessions.
+ * 
+ * Table is shared by all sessions and must stay valid.
+ * 
+ * @see eddy_s#set_cmd_table
+ * 
+ * @param server Pointer on server.
+ * @param table Array of commands.
+ * @param count Number of commands in array.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_server_set_cmd_table(eddy_server_p server, eddy_cmd_t* table, eddy_size_t count);
+
+/**
+ * @brief Set const map of commands registered in new sessions.
+ * 
+ * @see eddy_s#set_cmd_map
+ * 
+ * @param server Pointer on server.
+ * @param map Map generated by tools/eddy_cmdgen.py.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_server_set_cmd_map(eddy_server_p server, const eddy_cmd_map_t* map);
+
+/**
+ * @brief Set hint callback used by new sessions.
+ *
+ * @param server Pointer on server.
+ * @param check_hint_clbk Pointer on check and print hints function.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_server_set_check_hint_clbk(eddy_server_p server, eddy_check_hint_clbk check_hint_clbk);
+
+/**
+ * @brief Set prompt used by new sessions.
+ *
+ * @param server Pointer on server.
+ * @param prompt Prompt string, must stay valid.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_server_set_prompt(eddy_server_p server, char* prompt);
+
+/**
+ * @brief Wait for events and handle them.
+ *
+ * @param server Pointer on server.
+ * @param timeout_ms Maximal wait time in miliseconds, -1 to wait forever.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_server_poll(eddy_server_p server, int timeout_ms);
+
+/**
+ * @brief Session which input is processed now.
+ *
+ * Valid inside exec and hint callbacks.
+ *
+ * @return eddy_server_session_p Pointer on session or NULL.
+ */
+eddy_server_session_p eddy_server_current(void);
+
+/**
+ * @brief Send data to session.
+ *
+ * @param session Pointer on session.
+ * @param data Data to send.
+ * @param len Length of data.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if output queue is full.
+ */
+eddy_retv_t eddy_server_send(eddy_server_session_p session, const char* data, eddy_size_t len);
+
+/**
+ * @brief Finish command of session which returned EDDY_RETV_PENDING.
+ * 
+ * Prompt and input typed in the meantime are written to session. Must
+ * be called before session is closed, not from inside of callbacks.
+ * 
+ * @see eddy_s#command_done
+ * 
+ * @param session Pointer on session.
+ * @param status Result of command.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_server_command_done(eddy_server_session_p session, eddy_retv_t status);
+
+/**
+ * @brief Close session after current event is handled.
+ *
+ * @param session Pointer on session.
+ */
+void eddy_server_close(eddy_server_session_p session);
+
+/**
+ * @brief Close all sessions and listeners, release memory.
+ *
+ * @param server Pointer on server.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_server_destroy(eddy_server_p server);
+
+#endif /* __EDDY_SERVER_H__ */
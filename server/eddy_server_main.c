@@ -0,0 +1,209 @@
+/**
+ * @file eddy_server_main.c
+ * @author Rafał Kędzierski (rafal.kedzierski@gmail.com)
+ * @brief Example management CLI server.
+ * @version 0.1
+ * @date 2023-04-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * Usage: eddy_server [-t port] [-u path] [-m max_sessions]
+ *
+ * Commands: help, sessions, wait, quit. They are declared in
+ * eddy_server_cmds.def and their const map is generated at build time by
+ * tools/eddy_cmdgen.py. Other commands are accepted silently, so the
+ * server can be driven by eddy_loadgen. Command wait finishes
+ * asynchronously, input typed meanwhile is handled after it.
+ */
+#include "eddy_server.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SERVER_MAX_WAITS	64	/**< Maximal number of pending wait commands. */
+
+/**
+ * @brief Commands generated from eddy_server_cmds.def.
+ */
+extern const eddy_cmd_map_t server_cmd_map;
+
+/**
+ * @brief Pending wait command.
+ */
+typedef struct server_wait_s {
+	eddy_server_session_p session;	/**< Session waiting for command end. */
+	unsigned long serial;			/**< Connection of session, it may be closed meanwhile. */
+	long long deadline_ms;			/**< End time of command. */
+} server_wait_t;
+
+static eddy_server_t server;
+static volatile sig_atomic_t server_stop;
+static server_wait_t server_waits[SERVER_MAX_WAITS];
+static unsigned int server_waits_cnt;
+
+static void server_signal(int sig)
+{
+	(void)sig;
+	server_stop = 1;
+}
+
+static void server_reply_to(eddy_server_session_p session, const char* text)
+{
+	eddy_server_send(session, text, strlen(text));
+}
+
+static void server_reply(const char* text)
+{
+	server_reply_to(eddy_server_current(), text);
+}
+
+eddy_retv_t server_sessions(eddy_p self, int argc, char* argv[])
+{
+	char text[64];
+
+	(void)self;
+	(void)argc;
+	(void)argv;
+
+	snprintf(text, sizeof(text), "%lu\r\n", (unsigned long)server.active_sessions);
+	server_reply(text);
+
+	return EDDY_RETV_OK;
+}
+
+static long long server_now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+eddy_retv_t server_wait(eddy_p self, int argc, char* argv[])
+{
+	(void)self;
+	(void)argc;
+
+	if(server_waits_cnt >= SERVER_MAX_WAITS) {
+		return EDDY_RETV_ERR;
+	}
+
+	server_waits[server_waits_cnt].session = eddy_server_current();
+	server_waits[server_waits_cnt].serial = eddy_server_current()->serial;
+	server_waits[server_waits_cnt].deadline_ms = server_now_ms() + atol(argv[1]);
+	server_waits_cnt++;
+
+	return EDDY_RETV_PENDING;
+}
+
+/**
+ * @brief Finish wait commands which reached their deadline.
+ */
+static void server_wait_check(void)
+{
+	long long now = server_now_ms();
+	unsigned int idx = 0;
+
+	while(idx < server_waits_cnt) {
+		if(server_waits[idx].deadline_ms > now) {
+			idx++;
+			continue;
+		}
+
+		if(server_waits[idx].session->serial == server_waits[idx].serial) {
+			server_reply_to(server_waits[idx].session, "done\r\n");
+			eddy_server_command_done(server_waits[idx].session, EDDY_RETV_OK);
+		}
+
+		server_waits[idx] = server_waits[--server_waits_cnt];
+	}
+}
+
+eddy_retv_t server_quit(eddy_p self, int argc, char* argv[])
+{
+	(void)self;
+	(void)argc;
+	(void)argv;
+
+	eddy_server_close(eddy_server_current());
+
+	return EDDY_RETV_OK;
+}
+
+static eddy_retv_t server_exec(const char* cmd_line)
+{
+	(void)cmd_line;
+
+	return EDDY_RETV_OK;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned long max_sessions = 1024;
+	const char* path = NULL;
+	int port = -1;
+	int opt;
+
+	while((opt = getopt(argc, argv, "t:u:m:")) != -1) {
+		switch(opt) {
+		case 't':
+			port = atoi(optarg);
+			break;
+		case 'u':
+			path = optarg;
+			break;
+		case 'm':
+			max_sessions = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-t port] [-u path] [-m max_sessions]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if(port < 0 && path == NULL) {
+		port = 2323;
+	}
+
+	signal(SIGINT, server_signal);
+	signal(SIGTERM, server_signal);
+	signal(SIGPIPE, SIG_IGN);
+
+	if(eddy_server_init(&server, max_sessions) != EDDY_RETV_OK) {
+		fprintf(stderr, "server init failed\n");
+		return 1;
+	}
+
+	eddy_server_set_exec_cmd_clbk(&server, server_exec);
+	eddy_server_set_cmd_map(&server, &server_cmd_map);
+
+	if(port >= 0 && eddy_server_listen_tcp(&server, (unsigned short)port) != EDDY_RETV_OK) {
+		fprintf(stderr, "can not listen on port %d\n", port);
+		return 1;
+	}
+
+	if(path != NULL && eddy_server_listen_unix(&server, path) != EDDY_RETV_OK) {
+		fprintf(stderr, "can not listen on %s\n", path);
+		return 1;
+	}
+
+	while(!server_stop) {
+		if(eddy_server_poll(&server, server_waits_cnt > 0 ? 10 : 1000) != EDDY_RETV_OK) {
+			break;
+		}
+
+		server_wait_check();
+	}
+
+	eddy_server_destroy(&server);
+
+	if(path != NULL) {
+		unlink(path);
+	}
+
+	return 0;
+}
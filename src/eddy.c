@@ -13,6 +13,10 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+#ifdef EDDY_USE_LOG_QUEUE
+#include <stdatomic.h>
+#endif
 
 #ifndef   __WEAK
   #define __WEAK                                 __attribute__((weak))
@@ -23,6 +27,8 @@
  * @{ \name Escape character codes
  */
 #define VT100_BS_CODE  0x08
+#define VT100_CAN_CODE 0x18
+#define VT100_SUB_CODE 0x1A
 #define VT100_ESC_CODE 0x1B
 #define VT100_DEL_CODE 0x7F
 
@@ -44,6 +50,7 @@
 #define VT100_MOVE_CURSOR_LEFT_N  VT100_ESC "[%uD"
 #define VT100_SAVE_CURSOR_POS     VT100_ESC "[s"
 #define VT100_RESTORE_CURSOR_POS  VT100_ESC "[u"
+#define VT100_QUERY_CURSOR_POS    VT100_ESC "[6n"
 #define VT100_INSERT              VT100_ESC "[2~"
 #define VT100_DELETE              VT100_ESC "[3~"
 #define VT100_PAGE_UP             VT100_ESC "[5~"
@@ -66,6 +73,152 @@
  * @}
  */
 
+/**
+ * @brief Key codes recognized in escape sequences.
+ */
+typedef enum eddy_key_e {
+	EDDY_KEY_NONE,		/**< Unknown sequence. */
+	EDDY_KEY_UP,
+	EDDY_KEY_DOWN,
+	EDDY_KEY_RIGHT,
+	EDDY_KEY_LEFT,
+	EDDY_KEY_HOME,
+	EDDY_KEY_END,
+	EDDY_KEY_INSERT,
+	EDDY_KEY_DELETE,
+	EDDY_KEY_PAGE_UP,
+	EDDY_KEY_PAGE_DOWN,
+	EDDY_KEY_BACK_TAB,
+	EDDY_KEY_F1,
+	EDDY_KEY_F2,
+	EDDY_KEY_F3,
+	EDDY_KEY_F4,
+	EDDY_KEY_F5,
+	EDDY_KEY_F6,
+	EDDY_KEY_F7,
+	EDDY_KEY_F8,
+	EDDY_KEY_F9,
+	EDDY_KEY_F10,
+	EDDY_KEY_F11,
+	EDDY_KEY_F12,
+	EDDY_KEY_WORD_LEFT,
+	EDDY_KEY_WORD_RIGHT,
+	EDDY_KEY_CNT		/**< Number of key codes. */
+} eddy_key_t;
+
+/**
+ * @brief Table of recognized escape sequences.
+ * 
+ * Each entry is KEY(key, intro, param, final) where intro is '[' for CSI
+ * and 'O' for SS3 sequences (0 for [ALT+key] sent as ESC key), param is first numeric parameter of sequences
+ * terminated with '~' (0 for others) and final is the terminating character.
+ * Modifier parameter (e.g. 5 in ESC[1;5C) is not part of the entry.
+ */
+#define EDDY_KEYS_TABLE(KEY) \
+	KEY(EDDY_KEY_UP,        '[', 0,  'A') /* VT100_MOVE_CURSOR_UP */ \
+	KEY(EDDY_KEY_DOWN,      '[', 0,  'B') /* VT100_MOVE_CURSOR_DOWN */ \
+	KEY(EDDY_KEY_RIGHT,     '[', 0,  'C') /* VT100_MOVE_CURSOR_RIGHT */ \
+	KEY(EDDY_KEY_LEFT,      '[', 0,  'D') /* VT100_MOVE_CURSOR_LEFT */ \
+	KEY(EDDY_KEY_HOME,      '[', 0,  'H') /* VT100_HOME */ \
+	KEY(EDDY_KEY_END,       '[', 0,  'F') /* VT100_END */ \
+	KEY(EDDY_KEY_BACK_TAB,  '[', 0,  'Z') \
+	KEY(EDDY_KEY_F1,        '[', 0,  'P') \
+	KEY(EDDY_KEY_F2,        '[', 0,  'Q') \
+	KEY(EDDY_KEY_F3,        '[', 0,  'R') \
+	KEY(EDDY_KEY_F4,        '[', 0,  'S') \
+	KEY(EDDY_KEY_UP,        'O', 0,  'A') \
+	KEY(EDDY_KEY_DOWN,      'O', 0,  'B') \
+	KEY(EDDY_KEY_RIGHT,     'O', 0,  'C') \
+	KEY(EDDY_KEY_LEFT,      'O', 0,  'D') \
+	KEY(EDDY_KEY_HOME,      'O', 0,  'H') \
+	KEY(EDDY_KEY_END,       'O', 0,  'F') \
+	KEY(EDDY_KEY_F1,        'O', 0,  'P') /* VT100_F1 */ \
+	KEY(EDDY_KEY_F2,        'O', 0,  'Q') /* VT100_F2 */ \
+	KEY(EDDY_KEY_F3,        'O', 0,  'R') /* VT100_F3 */ \
+	KEY(EDDY_KEY_F4,        'O', 0,  'S') /* VT100_F4 */ \
+	KEY(EDDY_KEY_HOME,      '[', 1,  '~') \
+	KEY(EDDY_KEY_INSERT,    '[', 2,  '~') /* VT100_INSERT */ \
+	KEY(EDDY_KEY_DELETE,    '[', 3,  '~') /* VT100_DELETE */ \
+	KEY(EDDY_KEY_END,       '[', 4,  '~') \
+	KEY(EDDY_KEY_PAGE_UP,   '[', 5,  '~') /* VT100_PAGE_UP */ \
+	KEY(EDDY_KEY_PAGE_DOWN, '[', 6,  '~') /* VT100_PAGE_DOWN */ \
+	KEY(EDDY_KEY_HOME,      '[', 7,  '~') \
+	KEY(EDDY_KEY_END,       '[', 8,  '~') \
+	KEY(EDDY_KEY_F1,        '[', 11, '~') \
+	KEY(EDDY_KEY_F2,        '[', 12, '~') \
+	KEY(EDDY_KEY_F3,        '[', 13, '~') \
+	KEY(EDDY_KEY_F4,        '[', 14, '~') \
+	KEY(EDDY_KEY_F5,        '[', 15, '~') /* VT100_F5 */ \
+	KEY(EDDY_KEY_F6,        '[', 17, '~') /* VT100_F6 */ \
+	KEY(EDDY_KEY_F7,        '[', 18, '~') /* VT100_F7 */ \
+	KEY(EDDY_KEY_F8,        '[', 19, '~') /* VT100_F8 */ \
+	KEY(EDDY_KEY_F9,        '[', 20, '~') /* VT100_F9 */ \
+	KEY(EDDY_KEY_F10,       '[', 21, '~') /* VT100_F10 */ \
+	KEY(EDDY_KEY_F11,       '[', 23, '~') /* VT100_F11 */ \
+	KEY(EDDY_KEY_F12,       '[', 24, '~') /* VT100_F12 */ \
+	KEY(EDDY_KEY_WORD_LEFT, 0,   0,  'b') \
+	KEY(EDDY_KEY_WORD_RIGHT, 0,  0,  'f')
+
+/**
+ * @brief Packs escape sequence elements into single lookup code.
+ */
+#define EDDY_KEY_CODE(intro, param, final) \
+	(((unsigned long)(unsigned char)(intro) << 16) | ((unsigned long)(param) << 8) | (unsigned char)(final))
+
+/**
+ * @{ \name Escape sequence decoder states
+ */
+#define EDDY_ESC_STATE_ESC		0	/**< ESC received. */
+#define EDDY_ESC_STATE_CSI		1	/**< ESC [ received, collecting parameters. */
+#define EDDY_ESC_STATE_SS3		2	/**< ESC O received. */
+#define EDDY_ESC_STATE_INVALID	3	/**< Unsupported sequence, waiting for final character. */
+/**
+ * @}
+ */
+
+#define EDDY_ESC_MAX_PARAMS		2	/**< Number of decoded numeric parameters. */
+#define EDDY_ESC_MAX_PARAM_VAL	999	/**< Maximal value of decoded numeric parameter. */
+
+/**
+ * @{ \name Terminal width query states
+ */
+#define EDDY_TERM_QUERY_NONE	0	/**< No query in progress. */
+#define EDDY_TERM_QUERY_START	1	/**< Waiting for report of cursor position. */
+#define EDDY_TERM_QUERY_EDGE	2	/**< Waiting for report of position at right edge. */
+/**
+ * @}
+ */
+
+/**
+ * @brief Maximal length of UTF-8 encoded character.
+ */
+#define EDDY_UTF8_MAX_LEN	4
+
+/**
+ * @brief Byte is continuation byte of UTF-8 encoded character.
+ */
+#define EDDY_UTF8_CONT(c)	(((unsigned char)(c) & 0xC0) == 0x80)
+
+/**
+ * @brief Round size up to pointer alignment.
+ */
+#define EDDY_ALIGN(size)	(((size) + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*))
+
+/**
+ * @brief Round size up to cache line.
+ */
+#define EDDY_CACHE_ALIGN(size)	(((size) + EDDY_CACHE_LINE - 1) / EDDY_CACHE_LINE * EDDY_CACHE_LINE)
+
+/**
+ * @brief First cache line aligned address in memory.
+ */
+#define EDDY_CACHE_ALIGN_PTR(ptr)	((char*)(ptr) + (EDDY_CACHE_LINE - (uintptr_t)(ptr) % EDDY_CACHE_LINE) % EDDY_CACHE_LINE)
+
+/**
+ * @brief Code of key pressed with control key.
+ */
+#define EDDY_CTRL_KEY(c)	((c) & 0x1F)
+
 /**
  * @{ \name Definitions of internal beffer lenghts.
  */
@@ -75,6 +228,65 @@
  * @}
  */
 
+#define EDDY_HIST_NONE				((unsigned int)-1)	/**< Offset used when there is no history entry. */
+
+/**
+ * @brief Index bucket of history entries starting with given character.
+ */
+#define EDDY_HIST_BUCKET(c)			((unsigned char)(c) % EDDY_HIST_INDEX_BUCKETS)
+
+/**
+ * @{ \name History search modes
+ */
+#define EDDY_HIST_SEARCH_NONE		0	/**< No search in progress. */
+#define EDDY_HIST_SEARCH_PREFIX		1	/**< Browsing entries with common prefix [PAGE UP/DOWN]. */
+#define EDDY_HIST_SEARCH_REVERSE	2	/**< Incremental reverse search [CTRL+R]. */
+/**
+ * @}
+ */
+
+#ifdef EDDY_USE_STATS
+/**
+ * @brief Add value to statistics counter.
+ */
+#define EDDY_STAT_ADD(ctx, counter, value)	((ctx)->stats.counter += (value))
+
+/**
+ * @brief Update statistics maximum.
+ */
+#define EDDY_STAT_MAX(ctx, counter, value)	do { if((value) > (ctx)->stats.counter) (ctx)->stats.counter = (value); } while(0)
+#else
+#define EDDY_STAT_ADD(ctx, counter, value)	((void)0)
+#define EDDY_STAT_MAX(ctx, counter, value)	((void)0)
+#endif
+
+#ifdef EDDY_USE_RECORDER
+/**
+ * @brief Pass event to recorder callback if it is set.
+ */
+#define EDDY_RECORD(self, kind, data, len) \
+	do { if((self)->ctx->record_clbk != EDDY_NULL) (self)->ctx->record_clbk((self), (kind), (data), (len)); } while(0)
+
+/**
+ * @brief Pass command status to recorder callback as one byte event.
+ */
+#define EDDY_RECORD_STATUS(self, kind, status) \
+	do { char status_byte = (char)(status); EDDY_RECORD(self, kind, &status_byte, 1); } while(0)
+#else
+#define EDDY_RECORD(self, kind, data, len)		((void)0)
+#define EDDY_RECORD_STATUS(self, kind, status)	((void)0)
+#endif
+
+/**
+ * @{ \name Origin of private context memory
+ */
+#define EDDY_CTX_HEAP				0	/**< Allocated with eddy_malloc. */
+#define EDDY_CTX_STATIC				1	/**< Provided by user. */
+#define EDDY_CTX_POOL				2	/**< Taken from pool. */
+/**
+ * @}
+ */
+
 /**
  * @brief Structure contain del and backspace codes
  * 
@@ -84,35 +296,205 @@ typedef struct eddy_keys_codes_s {
 	char del_key;		/**< Delete key code. */
 } eddy_keys_codes_t;
 
+#ifdef EDDY_USE_LOG_QUEUE
+/**
+ * @brief Slot of log message queue.
+ * 
+ * Sequence number equal to queue position of slot means the slot is free
+ * for producer, position + 1 means message is ready for editor thread.
+ */
+typedef struct eddy_log_slot_s {
+	atomic_uint seq;					/**< Sequence number of slot. */
+	char text[EDDY_LOG_MSG_LEN];		/**< NUL terminated message. */
+} eddy_log_slot_t;
+#endif
+
 /**
  * @brief Private internal context of library
  * 
  */
 typedef struct eddy_ctx_s {
-	char line_buffer[EDDY_MAX_LINE_BUFF_LEN];	/**< Edited line buffer. */
+	/* fields used by every key, kept together in the first cache line */
+	char* line_buffer;							/**< Edited line buffer. */
+	eddy_cli_print_clbk cli_print_clbk;			/**< Pointer on terminal printing function. */
+	eddy_cli_write_clbk cli_write_clbk;			/**< Pointer on scatter-gather terminal printing function. */
 	unsigned int line_len;						/**< Number of entered characters. */
 	unsigned int line_pos;						/**< Cursor position in buffer. */
-	char esc_seq[EDDY_MAX_ESC_SEQ_LEN+1];		/**< Buffer on escape sequence. */
-	unsigned int esc_seq_len;					/**< Number of characters in escape sequence buffer. */
-	char prompt[EDDY_MAX_PROMPT_LEN];			/**< Buffer with prompt. */
+	unsigned int line_col;						/**< Cells before cursor, kept with line_pos. */
+	unsigned int line_width;					/**< Cells taken by line, kept with line_len. */
+	unsigned int line_size;						/**< Size of line buffer. */
+	unsigned int out_len;						/**< Number of characters in output staging buffer. */
+	unsigned short line_start;					/**< Terminal cells before line, taken by prompt. */
+	unsigned short term_cols;					/**< Terminal width. */
+	unsigned char out_segs_cnt;					/**< Number of used output segments. */
+	unsigned char esc_seq_len;					/**< Number of characters in escape sequence buffer. */
 	eddy_keys_codes_t keys_codes;				/**< Structure with back space and delete codes. */
+	unsigned char esc_state;					/**< State of escape sequence decoder. */
+	unsigned char utf8_len;						/**< Number of received bytes of multibyte character. */
+	unsigned char out_refs;						/**< Output segments point into line buffer. */
+	unsigned char hist_search;					/**< History search mode. */
+	unsigned char comp_tab;						/**< Previous [TAB] did not complete anything. */
+	unsigned char exec_pending;					/**< Executed command is not done yet. */
+	unsigned char batch_mode;					/**< Lines are executed without echo and prompt. */
+#ifdef EDDY_USE_GAP_BUFFER
+	unsigned char line_flat;					/**< Line is stored contiguously, gap is not opened at cursor. */
+#endif
+
+	char esc_seq[EDDY_MAX_ESC_SEQ_LEN+1];		/**< Buffer on escape sequence. */
+	unsigned char esc_param_cnt;				/**< Index of currently decoded parameter. */
+	unsigned short esc_params[EDDY_ESC_MAX_PARAMS];	/**< Numeric parameters of escape sequence. */
+	char utf8_seq[EDDY_UTF8_MAX_LEN];			/**< Received part of multibyte character. */
+	unsigned char utf8_need;					/**< Length of received multibyte character. */
+	unsigned char line_wide;					/**< Line may hold wide character, cells need padding check. */
+	unsigned char term_query;					/**< State of terminal width query. */
+	unsigned int term_query_col;				/**< Cursor column reported at query start. */
+	eddy_segment_t out_segs[EDDY_OUT_MAX_SEGMENTS];	/**< Output segments for scatter-gather callback. */
+	char out_buff[EDDY_OUT_BUFF_LEN+1];			/**< Output staging buffer. */
+	char line_store[EDDY_LINE_STORE_LEN];		/**< Line buffer inside context. */
 
-	eddy_cli_print_clbk cli_print_clbk;			/**< Pointer on terminal printing function. */
 	eddy_log_print_clbk log_print_clbk;			/**< Pointer on logs printing function. */
 	eddy_check_hint_clbk check_hint_clbk;		/**< Pointer on check and print hints function. */
+	unsigned char hint_quiet;					/**< Hint callback does not print, only changed part of line is printed. */
 	eddy_exec_cmd_clbk exec_cmd_clbk;			/**< Pointer on command execution function */
+	eddy_line_full_clbk line_full_clbk;			/**< Pointer on line full notification function. */
+	eddy_cmd_t* cmd_table;						/**< Registered commands sorted by name. */
+	unsigned int cmd_cnt;						/**< Number of registered commands. */
+	const eddy_cmd_map_t* cmd_map;				/**< Const map of commands. */
+	const eddy_trie_t* comp_trie;				/**< Trie of command names for completion. */
+	char prompt[EDDY_MAX_PROMPT_LEN];			/**< Buffer with prompt. */
+	char* line_base;							/**< Line buffer used by short lines, line_store or given by application. */
+	unsigned int line_base_size;				/**< Size of base line buffer. */
+	unsigned int line_limit;					/**< Size up to which line buffer grows, 0 if it does not grow. */
+	unsigned int line_drops;					/**< Characters dropped from full line since last notification. */
+
+	char* hist_buff;							/**< History ring buffer provided by user. */
+	unsigned int hist_size;						/**< Size of history ring buffer. */
+	unsigned int hist_used;						/**< Number of bytes used by history entries. */
+	unsigned int hist_head;						/**< Offset where next history entry is stored. */
+	unsigned int hist_tail;						/**< Offset of oldest history entry. */
+	unsigned int hist_pos;						/**< Offset of recalled history entry. */
+	unsigned char hist_recall;					/**< History entry is recalled. */
+	unsigned int hist_prefix_len;				/**< Length of prefix used by [PAGE UP/DOWN]. */
+	unsigned int hist_prefix_scan;				/**< Entry where stopped prefix scan continues or EDDY_HIST_NONE. */
+	unsigned char hist_prefix_older;			/**< Stopped prefix scan goes to older entries. */
+#ifdef EDDY_USE_HISTORY_INDEX
+	unsigned int hist_index[EDDY_HIST_INDEX_BUCKETS];	/**< Newest history entry of each index bucket. */
+#endif
+	char search_query[EDDY_HIST_SEARCH_LEN];	/**< Reverse search query. */
+	unsigned int search_len;					/**< Length of reverse search query. */
+	unsigned int search_scan;					/**< Offset of last found or next checked entry. */
+	unsigned int search_match[EDDY_HIST_SEARCH_LEN+1];	/**< Entry found for each query length. */
+	char kill_buff[EDDY_KILL_BUFF_LEN];			/**< Text removed with last kill command. */
+	unsigned int kill_len;						/**< Number of characters in kill buffer. */
+	char ahead_buff[EDDY_TYPEAHEAD_LEN];		/**< Input received while command is pending. */
+	unsigned int ahead_len;						/**< Number of characters in type-ahead buffer. */
+	unsigned char ahead_full;					/**< Type-ahead overflowed, input is dropped until command is done. */
+#ifdef EDDY_USE_LOG_QUEUE
+	eddy_log_slot_t log_slots[EDDY_LOG_SLOTS];	/**< Log message queue. */
+	atomic_uint log_tail;						/**< Queue position reserved by next producer. */
+	atomic_ulong log_drops;						/**< Messages dropped since last drain. */
+	unsigned int log_head;						/**< Queue position of next printed message. */
+#endif
+
+#ifdef EDDY_USE_STATS
+	eddy_stats_t stats;							/**< Runtime statistics. */
+#endif
+#ifdef EDDY_USE_RECORDER
+	eddy_record_clbk record_clbk;				/**< Pointer on recorder callback. */
+#endif
+
+	unsigned char ctx_origin;					/**< Origin of this context memory. */
+	void* ctx_mem;								/**< Memory allocated for context, it is aligned inside. */
+	eddy_pool_p pool;							/**< Pool owning this context. */
 } eddy_ctx_t;
 
+/**
+ * @brief Compile time check that fields used by every key fit into one cache line.
+ * 
+ * esc_seq is the first field after them. Context is placed at cache line
+ * boundary by all init functions.
+ */
+typedef char eddy_ctx_hot_check_t[(offsetof(eddy_ctx_t, esc_seq) <= EDDY_CACHE_LINE) ? 1 : -1];
+
+/**
+ * @brief Compile time check that EDDY_CTX_SIZE holds aligned context.
+ */
+_Static_assert(sizeof(eddy_ctx_t) + EDDY_CACHE_LINE - 1 <= EDDY_CTX_SIZE, "EDDY_CTX_SIZE is smaller than private context");
+
+/**
+ * @brief Compile time check that output segments can be counted by out_segs_cnt.
+ */
+typedef char eddy_out_segs_check_t[(EDDY_OUT_MAX_SEGMENTS <= 0xFF) ? 1 : -1];
+
+#ifdef EDDY_USE_LOG_QUEUE
+/**
+ * @brief Compile time check that queue positions can be masked with EDDY_LOG_SLOTS - 1.
+ */
+typedef char eddy_log_slots_check_t[(EDDY_LOG_SLOTS > 0 && (EDDY_LOG_SLOTS & (EDDY_LOG_SLOTS - 1)) == 0) ? 1 : -1];
+#endif
+
+/**
+ * @brief Maximal size of line buffer, current size if it does not grow.
+ */
+#define EDDY_LINE_MAX_SIZE(ctx)	(((ctx)->line_limit > (ctx)->line_size) ? (ctx)->line_limit : (ctx)->line_size)
+
+#ifdef EDDY_USE_GAP_BUFFER
+/**
+ * @brief Index of first character after the gap.
+ * 
+ * Text after cursor is kept at the end of line buffer, just before
+ * terminating NUL stored in last byte of the buffer.
+ */
+#define EDDY_LINE_GAP_END(ctx)	((ctx)->line_size - 1 - ((ctx)->line_len - (ctx)->line_pos))
+
+/**
+ * @brief Open gap at cursor position if line is stored contiguously.
+ * 
+ * @param ctx Pointer on library private context.
+ */
+static void eddy_line_gap_open(eddy_ctx_p ctx)
+{
+	if(ctx->line_flat) {
+		memmove(ctx->line_buffer + EDDY_LINE_GAP_END(ctx),
+			ctx->line_buffer + ctx->line_pos,
+			ctx->line_len - ctx->line_pos);
+		ctx->line_buffer[ctx->line_size - 1] = '\0';
+		ctx->line_flat = 0;
+	}
+}
+#endif
+
 /**
  * @{ \name API implementation functions.
 */
 eddy_retv_t eddy_put_char_impl(eddy_p self, char c);
+eddy_retv_t eddy_put_chars_impl(eddy_p self, const char* buffer, eddy_size_t len);
 eddy_retv_t eddy_set_cli_print_impl(eddy_p self, eddy_cli_print_clbk cli_print_clbk);
+eddy_retv_t eddy_set_cli_write_impl(eddy_p self, eddy_cli_write_clbk cli_write_clbk);
 eddy_retv_t eddy_set_log_print_impl(eddy_p self, eddy_log_print_clbk log_print_clbk);
 eddy_retv_t eddy_set_check_hint_impl(eddy_p self, eddy_check_hint_clbk check_hint_clbk);
+eddy_retv_t eddy_set_hint_quiet_impl(eddy_p self, int quiet);
 eddy_retv_t eddy_set_exec_cmd_impl(eddy_p self, eddy_exec_cmd_clbk exec_cmd_clbk);
+eddy_retv_t eddy_set_cmd_table_impl(eddy_p self, eddy_cmd_t* table, eddy_size_t count);
+eddy_retv_t eddy_set_cmd_map_impl(eddy_p self, const eddy_cmd_map_t* map);
+eddy_retv_t eddy_set_completion_impl(eddy_p self, const eddy_trie_t* trie);
 eddy_retv_t eddy_set_prompt_impl(eddy_p self, char* prompt);
+eddy_retv_t eddy_set_history_buff_impl(eddy_p self, char* buffer, eddy_size_t size);
+eddy_retv_t eddy_set_line_impl(eddy_p self, const char* line);
+eddy_retv_t eddy_set_term_width_impl(eddy_p self, unsigned int cols);
+eddy_retv_t eddy_query_term_width_impl(eddy_p self);
 eddy_retv_t eddy_show_prompt_impl(eddy_p self);
+eddy_retv_t eddy_flush_impl(eddy_p self);
+eddy_retv_t eddy_command_done_impl(eddy_p self, eddy_retv_t status);
+eddy_retv_t eddy_put_log_impl(eddy_p self, const char* text);
+eddy_retv_t eddy_drain_logs_impl(eddy_p self);
+eddy_retv_t eddy_get_stats_impl(eddy_p self, eddy_stats_t* stats);
+eddy_retv_t eddy_reset_stats_impl(eddy_p self);
+eddy_retv_t eddy_set_recorder_impl(eddy_p self, eddy_record_clbk record_clbk);
+eddy_retv_t eddy_set_batch_mode_impl(eddy_p self, int enable);
+eddy_retv_t eddy_set_line_buff_impl(eddy_p self, char* buffer, eddy_size_t size);
+eddy_retv_t eddy_set_line_limit_impl(eddy_p self, eddy_size_t limit);
+eddy_retv_t eddy_set_line_full_impl(eddy_p self, eddy_line_full_clbk line_full_clbk);
 eddy_retv_t eddy_destroy_impl(eddy_p self);
 /**
  * @}
@@ -120,56 +502,347 @@ eddy_retv_t eddy_destroy_impl(eddy_p self);
 /**
  * @{ \name Private functions declarations.
  */
+static void eddy_init_ctx(eddy_p self);
+eddy_retv_t eddy_process_chars(eddy_p self, const char* buffer, eddy_size_t len);
+eddy_retv_t eddy_batch_chars(eddy_p self, const char* buffer, eddy_size_t len);
+eddy_retv_t eddy_batch_exec(eddy_p self);
+void eddy_typeahead_put(eddy_p self, const char* buffer, eddy_size_t len);
+unsigned int eddy_typeahead_keys(const char* buffer, unsigned int len);
+eddy_retv_t eddy_log_drain(eddy_p self);
+eddy_retv_t eddy_process_char(eddy_p self, char c);
+eddy_retv_t eddy_process_esc_seq(eddy_p self, char c);
+eddy_retv_t eddy_term_report(eddy_p self, unsigned int col);
+eddy_key_t eddy_key_lookup(unsigned long code);
 eddy_retv_t eddy_proces_insert_char(eddy_p self, char c);
+eddy_retv_t eddy_line_insert(eddy_p self, char c);
+eddy_retv_t eddy_line_insert_seq(eddy_p self, const char* seq, unsigned int len);
+unsigned int eddy_line_delete_back(eddy_p self);
+unsigned int eddy_line_delete(eddy_p self);
+unsigned int eddy_line_move_left(eddy_p self);
+unsigned int eddy_line_move_right(eddy_p self);
+void eddy_line_seek(eddy_p self, unsigned int pos);
+void eddy_line_kill(eddy_p self, unsigned int back, unsigned int fwd);
+unsigned int eddy_line_word_start(eddy_p self);
+unsigned int eddy_line_word_end(eddy_p self);
+unsigned int eddy_line_prev_len(eddy_p self, unsigned int* width);
+unsigned int eddy_line_next_len(eddy_p self, unsigned int* width);
+unsigned int eddy_utf8_seq_len(char c);
+unsigned int eddy_utf8_complete(const char* text, unsigned int len);
+unsigned int eddy_utf8_partial(const char* text, unsigned int len);
+unsigned int eddy_utf8_prev(const char* text, unsigned int pos, unsigned int* width);
+unsigned int eddy_utf8_next(const char* text, unsigned int len, unsigned int* width);
+unsigned int eddy_utf8_width(unsigned long cp);
+unsigned int eddy_text_width(const char* text, unsigned int len);
+unsigned int eddy_ascii_run(const char* text, unsigned int len);
+unsigned int eddy_text_cells(eddy_p self, unsigned int cell, const char* text, unsigned int len);
+void eddy_line_measure(eddy_p self);
+void eddy_line_layout(eddy_p self, unsigned int reach, int moved);
+void eddy_line_clear(eddy_p self);
+eddy_retv_t eddy_line_reserve(eddy_p self, unsigned int len);
+void eddy_line_release(eddy_p self);
+void eddy_line_full_notify(eddy_p self);
+const char* eddy_line_tail(eddy_p self);
+char* eddy_line_view(eddy_p self);
+eddy_retv_t eddy_print_line_tail(eddy_p self, unsigned int from, unsigned int cell);
+eddy_retv_t eddy_print_line_rest(eddy_p self, int clear);
+eddy_retv_t eddy_print_line_below(eddy_p self);
+eddy_retv_t eddy_print_prompt(eddy_p self);
+eddy_retv_t eddy_print_prompt_line(eddy_p self);
+unsigned int eddy_format_number(char* buffer, unsigned long n);
+eddy_retv_t eddy_print_cursor_move(eddy_p self, const char* format, unsigned int n);
+eddy_retv_t eddy_print_cursor_goto(eddy_p self, unsigned int from, unsigned int to);
+eddy_retv_t eddy_print_wrap(eddy_p self, unsigned int end);
 eddy_retv_t eddy_process_cursor_left(eddy_p self);
 eddy_retv_t eddy_process_cursor_right(eddy_p self);
+eddy_retv_t eddy_process_cursor_to(eddy_p self, unsigned int pos);
+eddy_retv_t eddy_process_line_home(eddy_p self);
+eddy_retv_t eddy_process_line_end(eddy_p self);
+eddy_retv_t eddy_process_word_left(eddy_p self);
+eddy_retv_t eddy_process_word_right(eddy_p self);
+eddy_retv_t eddy_process_kill(eddy_p self, unsigned int back, unsigned int fwd);
+eddy_retv_t eddy_process_kill_start(eddy_p self);
+eddy_retv_t eddy_process_kill_end(eddy_p self);
+eddy_retv_t eddy_process_kill_word(eddy_p self);
+eddy_retv_t eddy_process_yank(eddy_p self);
+eddy_retv_t eddy_process_tab(eddy_p self);
+eddy_retv_t eddy_process_complete(eddy_p self);
+eddy_retv_t eddy_complete_list(eddy_p self, const eddy_trie_t* trie, unsigned int node, unsigned int start);
+unsigned int eddy_trie_find(const eddy_trie_t* trie, const char* prefix, unsigned int len);
 eddy_retv_t eddy_process_check_hint(eddy_p self, char* cmd_line);
-eddy_retv_t eddy_process_exec_cmd(eddy_p self, const char* cmd_line);
+eddy_retv_t eddy_process_exec_cmd(eddy_p self, char* cmd_line);
+eddy_retv_t eddy_exec_finish(eddy_p self, eddy_retv_t status);
+eddy_retv_t eddy_cmd_dispatch(eddy_p self, char* cmd_line);
+const eddy_cmd_t* eddy_cmd_lookup(eddy_ctx_p ctx, const char* name, unsigned int len);
+eddy_retv_t eddy_cmd_help(eddy_p self);
+eddy_retv_t eddy_cmd_usage(eddy_p self, const eddy_cmd_t* cmd);
+eddy_retv_t eddy_cmd_help_entry(eddy_p self, const eddy_cmd_t* cmd, unsigned int width);
 eddy_retv_t eddy_process_bs_key(eddy_p self);
 eddy_retv_t eddy_process_del_key(eddy_p self);
+eddy_retv_t eddy_process_history_prev(eddy_p self);
+eddy_retv_t eddy_process_history_next(eddy_p self);
+eddy_retv_t eddy_process_history_prefix_prev(eddy_p self);
+eddy_retv_t eddy_process_history_prefix_next(eddy_p self);
+eddy_retv_t eddy_process_search_start(eddy_p self);
+int eddy_search_consumes(eddy_p self, char c);
+eddy_retv_t eddy_process_search_char(eddy_p self, char c);
+eddy_retv_t eddy_search_exit(eddy_p self);
+static eddy_retv_t eddy_search_print(eddy_p self);
+static eddy_retv_t eddy_search_draw(eddy_p self);
+void eddy_history_add(eddy_p self, const char* line, unsigned int len);
+eddy_retv_t eddy_line_replace(eddy_p self, const char* text, unsigned int len);
+eddy_retv_t eddy_print_line_update(eddy_p self, unsigned int from);
 eddy_retv_t eddy_print(eddy_p self, const char* buffer);
+eddy_retv_t eddy_print_ref(eddy_p self, const char* buffer);
 eddy_retv_t eddy_put(eddy_p self, char chr);
+eddy_retv_t eddy_write(eddy_p self, const char* buffer, eddy_size_t len);
+eddy_retv_t eddy_write_ref(eddy_p self, const char* buffer, eddy_size_t len);
+eddy_retv_t eddy_write_line(eddy_p self, unsigned int cell, const char* text, unsigned int len);
+void eddy_line_touch(eddy_p self);
 /**
  * @}
  */
 
+const eddy_ops_t eddy_ops = {
+#define EDDY_API_OPS(type, name, impl)	.name = impl,
+	EDDY_API_TABLE(EDDY_API_OPS)
+#undef EDDY_API_OPS
+};
+
+/**
+ * @brief Key handlers indexed by key code. Keys without handler are ignored.
+ */
+static eddy_retv_t (* const eddy_key_handlers[EDDY_KEY_CNT])(eddy_p self) = {
+	[EDDY_KEY_LEFT] = eddy_process_cursor_left,
+	[EDDY_KEY_RIGHT] = eddy_process_cursor_right,
+	[EDDY_KEY_HOME] = eddy_process_line_home,
+	[EDDY_KEY_END] = eddy_process_line_end,
+	[EDDY_KEY_WORD_LEFT] = eddy_process_word_left,
+	[EDDY_KEY_WORD_RIGHT] = eddy_process_word_right,
+	[EDDY_KEY_DELETE] = eddy_process_del_key,
+	[EDDY_KEY_UP] = eddy_process_history_prev,
+	[EDDY_KEY_DOWN] = eddy_process_history_next,
+	[EDDY_KEY_PAGE_UP] = eddy_process_history_prefix_prev,
+	[EDDY_KEY_PAGE_DOWN] = eddy_process_history_prefix_next,
+};
+
+/**
+ * @brief Control character handlers indexed by code. Characters without handler are inserted.
+ */
+static eddy_retv_t (* const eddy_ctrl_handlers[0x20])(eddy_p self) = {
+	[EDDY_CTRL_KEY('A')] = eddy_process_line_home,
+	[EDDY_CTRL_KEY('E')] = eddy_process_line_end,
+	[EDDY_CTRL_KEY('K')] = eddy_process_kill_end,
+	[EDDY_CTRL_KEY('R')] = eddy_process_search_start,
+	[EDDY_CTRL_KEY('U')] = eddy_process_kill_start,
+	[EDDY_CTRL_KEY('W')] = eddy_process_kill_word,
+	[EDDY_CTRL_KEY('Y')] = eddy_process_yank,
+};
+
 eddy_retv_t init_eddy(eddy_p self)
 {
+	void* mem;
+
 	if(self == EDDY_NULL) {
 		return EDDY_RETV_ERR;
 	}
 
-	self->ctx = eddy_malloc(sizeof(*self->ctx));
+	mem = eddy_malloc(sizeof(eddy_ctx_t) + EDDY_CACHE_LINE - 1);
+
+	if(mem == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	self->ctx = (eddy_ctx_p)EDDY_CACHE_ALIGN_PTR(mem);
+
+	eddy_init_ctx(self);
+	self->ctx->ctx_origin = EDDY_CTX_HEAP;
+	self->ctx->ctx_mem = mem;
+
+	return EDDY_RETV_OK;
+}
+
+eddy_retv_t init_eddy_static(eddy_p self, void* storage, eddy_size_t size)
+{
+	char* ctx;
+
+	if(self == EDDY_NULL || storage == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	ctx = EDDY_CACHE_ALIGN_PTR(storage);
+
+	if(size < (eddy_size_t)(ctx - (char*)storage) + sizeof(eddy_ctx_t)) {
+		return EDDY_RETV_ERR;
+	}
+
+	self->ctx = (eddy_ctx_p)ctx;
+
+	eddy_init_ctx(self);
+	self->ctx->ctx_origin = EDDY_CTX_STATIC;
+	self->ctx->line_limit = 0;
+
+	return EDDY_RETV_OK;
+}
+
+eddy_size_t eddy_ctx_size(void)
+{
+	return sizeof(eddy_ctx_t) + EDDY_CACHE_LINE - 1;
+}
+
+eddy_size_t eddy_pool_block_size(eddy_size_t hist_size)
+{
+	return EDDY_CACHE_ALIGN(EDDY_ALIGN(sizeof(eddy_ctx_t)) + hist_size);
+}
+
+eddy_retv_t eddy_pool_init(eddy_pool_p pool, void* slab, eddy_size_t size, eddy_size_t hist_size)
+{
+	char* start;
+	char* block;
+
+	if(pool == EDDY_NULL || slab == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	start = EDDY_CACHE_ALIGN_PTR(slab);
+	size = (size > (eddy_size_t)(start - (char*)slab)) ? size - (eddy_size_t)(start - (char*)slab) : 0;
+
+	pool->block_size = eddy_pool_block_size(hist_size);
+	pool->hist_size = hist_size;
+	pool->free_list = EDDY_NULL;
+	pool->free_cnt = 0;
+
+	/* link blocks from the end, so they are taken in slab order */
+	for(block = start + (size / pool->block_size) * pool->block_size; block != start; ) {
+		block -= pool->block_size;
+		*(void**)block = pool->free_list;
+		pool->free_list = block;
+		pool->free_cnt++;
+	}
+
+	return EDDY_RETV_OK;
+}
+
+eddy_retv_t init_eddy_pool(eddy_p self, eddy_pool_p pool)
+{
+	char* block;
 
-	if(self->ctx == EDDY_NULL) {
+	if(self == EDDY_NULL || pool == EDDY_NULL || pool->free_list == EDDY_NULL) {
 		return EDDY_RETV_ERR;
 	}
 
-    self->put_char = eddy_put_char_impl;
-	self->set_cli_print_clbk = eddy_set_cli_print_impl;
-	self->set_log_print_clbk = eddy_set_log_print_impl;
-	self->set_check_hint_clbk = eddy_set_check_hint_impl;
-	self->set_exec_cmd_clbk = eddy_set_exec_cmd_impl;
-	self->set_prompt = eddy_set_prompt_impl;
-	self->show_prompt = eddy_show_prompt_impl;
-	self->destroy = eddy_destroy_impl;
+	block = pool->free_list;
+	pool->free_list = *(void**)block;
+	pool->free_cnt--;
+
+	self->ctx = (eddy_ctx_p)block;
+
+	eddy_init_ctx(self);
+	self->ctx->ctx_origin = EDDY_CTX_POOL;
+	self->ctx->pool = pool;
+	self->ctx->line_limit = 0;
+
+	if(pool->hist_size > 0) {
+		eddy_set_history_buff_impl(self, block + EDDY_ALIGN(sizeof(eddy_ctx_t)), pool->hist_size);
+	}
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Initialize private context and API of library.
+ * 
+ * @param self Pointer on library context with assigned private context memory.
+ */
+static void eddy_init_ctx(eddy_p self)
+{
+#if defined(EDDY_USE_HISTORY_INDEX) || defined(EDDY_USE_LOG_QUEUE)
+	unsigned int idx;
+#endif
+
+	self->ops = &eddy_ops;
+#ifndef EDDY_USE_SHARED_OPS
+#define EDDY_API_COPY(type, name, impl)	self->name = impl;
+	EDDY_API_TABLE(EDDY_API_COPY)
+#undef EDDY_API_COPY
+#endif
 
 	self->ctx->keys_codes.bs_key = VT100_DEL_CODE; /* VT100_BS_CODE; */
 	self->ctx->keys_codes.del_key = VT100_BS_CODE;
 
+	self->ctx->line_buffer = self->ctx->line_store;
+	self->ctx->line_size = EDDY_LINE_STORE_LEN;
+	self->ctx->line_base = self->ctx->line_store;
+	self->ctx->line_base_size = EDDY_LINE_STORE_LEN;
+	self->ctx->line_limit = EDDY_MAX_LINE_BUFF_LEN;
+	self->ctx->line_drops = 0;
+	self->ctx->line_full_clbk = EDDY_NULL;
 	self->ctx->line_len = 0;
 	self->ctx->line_pos = 0;
+	self->ctx->line_col = 0;
+	self->ctx->line_width = 0;
+	self->ctx->line_wide = 0;
+	self->ctx->line_buffer[0] = '\0';
+#ifdef EDDY_USE_GAP_BUFFER
+	self->ctx->line_flat = 1;
+#endif
 	self->ctx->esc_seq_len = 0;
+	self->ctx->utf8_len = 0;
+	self->ctx->out_len = 0;
+	self->ctx->out_segs_cnt = 0;
+	self->ctx->out_refs = 0;
+
+	self->ctx->hist_buff = EDDY_NULL;
+	self->ctx->hist_size = 0;
+	self->ctx->hist_used = 0;
+	self->ctx->hist_head = 0;
+	self->ctx->hist_tail = 0;
+	self->ctx->hist_recall = 0;
+	self->ctx->hist_search = EDDY_HIST_SEARCH_NONE;
+	self->ctx->hist_prefix_scan = EDDY_HIST_NONE;
+	self->ctx->hist_prefix_older = 0;
+#ifdef EDDY_USE_HISTORY_INDEX
+	for(idx = 0; idx < EDDY_HIST_INDEX_BUCKETS; idx++) {
+		self->ctx->hist_index[idx] = EDDY_HIST_NONE;
+	}
+#endif
 
 	self->ctx->prompt[0] = '>';
 	self->ctx->prompt[1] = '\0';
+	self->ctx->line_start = 1;
+	self->ctx->term_cols = EDDY_TERM_WIDTH;
+	self->ctx->term_query = EDDY_TERM_QUERY_NONE;
 
 	self->ctx->cli_print_clbk = EDDY_NULL;
+	self->ctx->cli_write_clbk = EDDY_NULL;
 	self->ctx->log_print_clbk = EDDY_NULL;
 	self->ctx->check_hint_clbk = EDDY_NULL;
+	self->ctx->hint_quiet = 0;
 	self->ctx->exec_cmd_clbk = EDDY_NULL;
+	self->ctx->cmd_table = EDDY_NULL;
+	self->ctx->cmd_cnt = 0;
+	self->ctx->cmd_map = EDDY_NULL;
+	self->ctx->comp_trie = EDDY_NULL;
+	self->ctx->comp_tab = 0;
+	self->ctx->kill_len = 0;
+	self->ctx->exec_pending = 0;
+	self->ctx->batch_mode = 0;
+	self->ctx->ahead_len = 0;
+	self->ctx->ahead_full = 0;
+#ifdef EDDY_USE_LOG_QUEUE
+	for(idx = 0; idx < EDDY_LOG_SLOTS; idx++) {
+		atomic_init(&self->ctx->log_slots[idx].seq, idx);
+	}
+	atomic_init(&self->ctx->log_tail, 0);
+	atomic_init(&self->ctx->log_drops, 0);
+	self->ctx->log_head = 0;
+#endif
+#ifdef EDDY_USE_RECORDER
+	self->ctx->record_clbk = EDDY_NULL;
+#endif
 
-	return EDDY_RETV_OK;
+	self->ctx->pool = EDDY_NULL;
+
+	eddy_reset_stats_impl(self);
 }
 
 /**
@@ -192,6 +865,29 @@ eddy_retv_t eddy_set_cli_print_impl(eddy_p self, eddy_cli_print_clbk cli_print_c
 	return EDDY_RETV_OK;
 }
 
+/**
+ * @brief Implementation of api set_cli_write_clbk function.
+ * 
+ * Function to set callback on scatter-gather terminal printing function.
+ * When set, it is used instead of terminal printing function.
+ * 
+ * @param self Pointer on library context.
+ * @param cli_write_clbk Pointer to print function.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_set_cli_write_impl(eddy_p self, eddy_cli_write_clbk cli_write_clbk)
+{
+	if(self == EDDY_NULL || cli_write_clbk == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	eddy_flush_impl(self);
+
+	self->ctx->cli_write_clbk = cli_write_clbk;
+
+	return EDDY_RETV_OK;
+}
+
 /**
  * @brief Implementation of api set_log_print_clbk function.
  * 
@@ -229,392 +925,4710 @@ eddy_retv_t eddy_set_check_hint_impl(eddy_p self, eddy_check_hint_clbk check_hin
 }
 
 /**
- * @brief Implementation of api set_exec_cmd_clbk function.
+ * @brief Implementation of api set_hint_quiet function.
+ * 
+ * Quiet hint callback only completes the line in place and does not
+ * print, so only changed part of the line is printed again instead of
+ * prompt and whole line.
  * 
  * @param self Pointer on library context.
- * @param exec_cmd_clbk Pointer to execute command function.
+ * @param quiet Non-zero if hint callback does not print.
  * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
  */
-eddy_retv_t eddy_set_exec_cmd_impl(eddy_p self, eddy_exec_cmd_clbk exec_cmd_clbk)
+eddy_retv_t eddy_set_hint_quiet_impl(eddy_p self, int quiet)
 {
-	if(self == EDDY_NULL || exec_cmd_clbk == EDDY_NULL) {
+	if(self == EDDY_NULL) {
 		return EDDY_RETV_ERR;
 	}
 
-	self->ctx->exec_cmd_clbk = exec_cmd_clbk;
+	self->ctx->hint_quiet = (quiet != 0);
 
 	return EDDY_RETV_OK;
 }
 
 /**
- * @brief Implementation of api set_prompt function.
+ * @brief Implementation of api set_exec_cmd_clbk function.
  * 
  * @param self Pointer on library context.
- * @param prompt Pointer on prompt string.
+ * @param exec_cmd_clbk Pointer to execute command function.
  * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
  */
-eddy_retv_t eddy_set_prompt_impl(eddy_p self, char* prompt)
+eddy_retv_t eddy_set_exec_cmd_impl(eddy_p self, eddy_exec_cmd_clbk exec_cmd_clbk)
 {
-	if(self == EDDY_NULL || prompt == EDDY_NULL) {
+	if(self == EDDY_NULL || exec_cmd_clbk == EDDY_NULL) {
 		return EDDY_RETV_ERR;
 	}
 
-	strncpy(self->ctx->prompt, prompt, EDDY_MAX_PROMPT_LEN);
+	self->ctx->exec_cmd_clbk = exec_cmd_clbk;
 
 	return EDDY_RETV_OK;
 }
 
 /**
- * @brief Implementation of api put_char function.
+ * @brief Compare commands by name for sorting.
+ */
+static int eddy_cmd_compare(const void* a, const void* b)
+{
+	return strcmp(((const eddy_cmd_t*)a)->name, ((const eddy_cmd_t*)b)->name);
+}
+
+/**
+ * @brief Implementation of api set_cmd_table function.
+ * 
+ * Table is used until it is replaced, so it must stay valid. Table which
+ * is not sorted by command name is sorted in place, but only after it was
+ * validated, rejected table is left unchanged. Sorted table is not written,
+ * so it can be shared by contexts. Lines starting with registered name
+ * are split into arguments and passed to command handler, other lines are
+ * passed to execute command callback.
  * 
  * @param self Pointer on library context.
- * @param c Character passed from terminal.
+ * @param table Array of commands or NULL to remove registered commands.
+ * @param count Number of commands in array.
  * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
  */
-eddy_retv_t eddy_put_char_impl(eddy_p self, char c)
+eddy_retv_t eddy_set_cmd_table_impl(eddy_p self, eddy_cmd_t* table, eddy_size_t count)
 {
-	eddy_retv_t error = EDDY_RETV_OK;
+	eddy_size_t sorted = 1;
+	eddy_size_t idx;
+	eddy_size_t other;
+	int cmp;
 
-	if(self == EDDY_NULL) {
+	if(self == EDDY_NULL || (table == EDDY_NULL && count > 0)) {
 		return EDDY_RETV_ERR;
 	}
 
-	if(c == self->ctx->keys_codes.bs_key) {
-		error = eddy_process_bs_key(self);
-	} else if(c == self->ctx->keys_codes.del_key) {
-		error = eddy_process_del_key(self);
-	} else if(self->ctx->esc_seq_len > 0) {
-		if(self->ctx->esc_seq_len < EDDY_MAX_ESC_SEQ_LEN) {
-			self->ctx->esc_seq[self->ctx->esc_seq_len++] = c;
-			self->ctx->esc_seq[self->ctx->esc_seq_len] = '\0';
+	for(idx = 0; idx < count; idx++) {
+		if(table[idx].name == EDDY_NULL || table[idx].name[0] == '\0' || table[idx].handler == EDDY_NULL
+			|| table[idx].min_args > table[idx].max_args) {
+			return EDDY_RETV_ERR;
 		}
+	}
+
+	/* names of sorted table are unique if each is greater than previous one */
+	for(idx = 1; idx < count && sorted; idx++) {
+		cmp = strcmp(table[idx - 1].name, table[idx].name);
 
-		if(((c>='A') && (c<='Z')) || ((c>='a') && (c<='z')) || c == '~') {	/* seq end */
-			if(!strcmp(self->ctx->esc_seq, VT100_DELETE)) {
-			error = eddy_process_del_key(self);
-			} else if(!strcmp(self->ctx->esc_seq, VT100_MOVE_CURSOR_LEFT)) {
-			error = eddy_process_cursor_left(self);
-			} else if(!strcmp(self->ctx->esc_seq, VT100_MOVE_CURSOR_RIGHT)) {
-			error = eddy_process_cursor_right(self);
-			} else if(!strcmp(self->ctx->esc_seq, VT100_MOVE_CURSOR_UP)) {
+		if(cmp == 0) {
+			return EDDY_RETV_ERR;
+		}
 
-			} else if(!strcmp(self->ctx->esc_seq, VT100_MOVE_CURSOR_DOWN)) {
+		sorted = (cmp < 0);
+	}
 
-			} else {
-			//Unknown escape sequence
-				//printf("DEBUG: unknown esc seq: %s\n", self->ctx->esc_seq + 1);
-				eddy_print(self, self->ctx->esc_seq);
+	if(!sorted) {
+		for(idx = 0; idx < count; idx++) {
+			for(other = idx + 1; other < count; other++) {
+				if(strcmp(table[idx].name, table[other].name) == 0) {
+					return EDDY_RETV_ERR;
+				}
 			}
-			self->ctx->esc_seq_len = 0;
 		}
-	} else if(c == VT100_ESC_CODE) {	/* seq start */
-		self->ctx->esc_seq[0] = c;
-		self->ctx->esc_seq_len = 1;
-	} else if(c == '\t') {
-		error = eddy_process_check_hint(self, self->ctx->line_buffer);
-	} else if((c == '\n') || (c == '\r')) {
-		error = eddy_process_exec_cmd(self, self->ctx->line_buffer);
-	} else {
-		error = eddy_proces_insert_char(self, c);
+
+		qsort(table, count, sizeof(*table), eddy_cmd_compare);
 	}
 
-	return error;
-}
+	self->ctx->cmd_table = (count > 0) ? table : EDDY_NULL;
+	self->ctx->cmd_cnt = count;
+
+	return EDDY_RETV_OK;
+}
 
 /**
- * @brief Fonction shows prompt
+ * @brief Implementation of api set_cmd_map function.
+ * 
+ * Map is only referenced, nothing is copied or sorted. Its commands are
+ * looked up before commands registered with set_cmd_table.
  * 
  * @param self Pointer on library context.
+ * @param map Pointer on generated map or NULL to remove it.
  * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
  */
-eddy_retv_t eddy_show_prompt_impl(eddy_p self)
+eddy_retv_t eddy_set_cmd_map_impl(eddy_p self, const eddy_cmd_map_t* map)
 {
-	return eddy_print(self, self->ctx->prompt);
+	if(self == EDDY_NULL || (map != EDDY_NULL && (map->cmds_cnt == 0 || map->seeds_cnt == 0))) {
+		return EDDY_RETV_ERR;
+	}
+
+	self->ctx->cmd_map = map;
+
+	return EDDY_RETV_OK;
 }
 
-eddy_retv_t eddy_destroy_impl(eddy_p self)
+/**
+ * @brief Implementation of api set_completion function.
+ * 
+ * When trie is set, [TAB] completes words with built-in completion engine
+ * instead of calling check hint callback. First word is completed from
+ * given trie, arguments from trie returned by provider of the command.
+ * 
+ * @param self Pointer on library context.
+ * @param trie Pointer on trie of command names or NULL to use check hint callback.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_set_completion_impl(eddy_p self, const eddy_trie_t* trie)
 {
-	if(self == EDDY_NULL) {
+	if(self == EDDY_NULL || (trie != EDDY_NULL && (trie->nodes == EDDY_NULL || trie->nodes_cnt == 0))) {
+		return EDDY_RETV_ERR;
+	}
+
+	self->ctx->comp_trie = trie;
+	self->ctx->comp_tab = 0;
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Implementation of api set_prompt function.
+ * 
+ * @param self Pointer on library context.
+ * @param prompt Pointer on prompt string.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_set_prompt_impl(eddy_p self, char* prompt)
+{
+	if(self == EDDY_NULL || prompt == EDDY_NULL) {
 		return EDDY_RETV_ERR;
 	}
 
-	eddy_free(self->ctx);
+	eddy_flush_impl(self);
 
-    self->put_char = EDDY_NULL;
-	self->set_cli_print_clbk = EDDY_NULL;
-	self->set_log_print_clbk = EDDY_NULL;
-	self->set_check_hint_clbk = EDDY_NULL;
-	self->set_exec_cmd_clbk = EDDY_NULL;
-	self->show_prompt = EDDY_NULL;
-	self->destroy = EDDY_NULL;
+	strncpy(self->ctx->prompt, prompt, EDDY_MAX_PROMPT_LEN);
 
 	return EDDY_RETV_OK;
 }
 
 /**
- * @brief Insert char into line buffer.
+ * @brief Implementation of api set_line function.
+ * 
+ * Edited line is replaced and only its changed part is printed again.
+ * Cursor is placed at the end of the line.
  * 
  * @param self Pointer on library context.
- * @param c Character to insertion.
+ * @param line New line text.
  * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
  */
-eddy_retv_t eddy_proces_insert_char(eddy_p self, char c)
+eddy_retv_t eddy_set_line_impl(eddy_p self, const char* line)
 {
-	eddy_retv_t error = EDDY_RETV_OK;
+	eddy_retv_t error;
+	unsigned int len;
 
-	if(self->ctx->line_len < (EDDY_MAX_LINE_BUFF_LEN - 1)) {
-		if(self->ctx->line_pos < self->ctx->line_len) {
-			memmove(self->ctx->line_buffer + self->ctx->line_pos + 1,
-				self->ctx->line_buffer + self->ctx->line_pos,
-				self->ctx->line_len - self->ctx->line_pos+1);
-		}
+	if(self == EDDY_NULL || line == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
 
-		self->ctx->line_buffer[self->ctx->line_pos] = c;
-		self->ctx->line_len++;
-		self->ctx->line_pos++;
-		self->ctx->line_buffer[self->ctx->line_len] = '\0';
+	len = strlen(line);
 
-		error = eddy_put(self, c);
+	if(self->ctx->exec_pending || eddy_line_reserve(self, len) != EDDY_RETV_OK) {
+		return EDDY_RETV_ERR;
+	}
 
-		if(self->ctx->line_pos < self->ctx->line_len) {
-			if(!error) {
-				eddy_print(self, VT100_SAVE_CURSOR_POS);
-			}
-		}
+	if(self->ctx->hist_search == EDDY_HIST_SEARCH_REVERSE) {
+		eddy_search_exit(self);
+	}
 
-		if(self->ctx->line_pos < self->ctx->line_len) {
-			if(!error) {
-				error = eddy_print(self, self->ctx->line_buffer + self->ctx->line_pos);
-			}
+	self->ctx->hist_search = EDDY_HIST_SEARCH_NONE;
+	self->ctx->hist_recall = 0;
 
-			if(!error) {
-				error = eddy_print(self, VT100_RESTORE_CURSOR_POS);
-			}
-		}
+	error = eddy_line_replace(self, line, len);
+
+	if(eddy_flush_impl(self) != EDDY_RETV_OK) {
+		error = EDDY_RETV_ERR;
 	}
 
 	return error;
 }
 
 /**
- * @brief Proceed back space on line buffer.
+ * @brief Implementation of api set_term_width function.
+ * 
+ * New width is used by following edits, line already shown is not
+ * printed again.
  * 
  * @param self Pointer on library context.
+ * @param cols Number of terminal columns, at most 65535.
  * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
  */
-eddy_retv_t eddy_process_bs_key(eddy_p self)
+eddy_retv_t eddy_set_term_width_impl(eddy_p self, unsigned int cols)
+{
+	if(self == EDDY_NULL || cols == 0 || cols > 0xFFFF) {
+		return EDDY_RETV_ERR;
+	}
+
+	self->ctx->term_cols = cols;
+	eddy_line_layout(self, cols, 1);
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Implementation of api query_term_width function.
+ * 
+ * Terminal is asked for cursor position. When it reports, cursor is moved
+ * to the right edge and position is asked again. Column of second report
+ * is terminal width, then cursor is moved back. Cursor is moved only after
+ * terminal answered, so terminal without position reports keeps previous
+ * width. Reports are passed with put_char or put_chars like keys. Any
+ * other key ends the query, so terminal which does not answer cannot turn
+ * later key with the same sequence, like Shift-F3, into a report.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_query_term_width_impl(eddy_p self)
 {
 	eddy_retv_t error;
 
-	if(self->ctx->line_pos > 0) {
-		error = eddy_print(self, VT100_BACKSPACE);
+	if(self == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
 
-		if(self->ctx->line_pos < self->ctx->line_len) {
-			error = eddy_print(self, VT100_SAVE_CURSOR_POS);
+	self->ctx->term_query = EDDY_TERM_QUERY_START;
 
-			if(!error) {
-				error = eddy_print(self, self->ctx->line_buffer + self->ctx->line_pos);
-			}
+	error = eddy_print(self, VT100_QUERY_CURSOR_POS);
 
-			if(!error) {
-				error = eddy_print(self, " " VT100_RESTORE_CURSOR_POS);
-			}
+	if(eddy_flush_impl(self) != EDDY_RETV_OK) {
+		error = EDDY_RETV_ERR;
+	}
 
-			memmove(self->ctx->line_buffer + self->ctx->line_pos - 1,
-				self->ctx->line_buffer + self->ctx->line_pos,
-				self->ctx->line_len - self->ctx->line_pos);
-		} else {
-			eddy_print(self, VT100_CLEAR_SCREEN_DOWN);
-		}
+	return error;
+}
 
-		self->ctx->line_len--;
-		self->ctx->line_pos--;
-		self->ctx->line_buffer[self->ctx->line_len] = '\0';
+/**
+ * @brief Implementation of api set_history_buff function.
+ * 
+ * Commands are stored in given buffer one after another, each with its
+ * length before and after the command text (4 bytes of overhead). When
+ * buffer is full the oldest commands are removed. History does not use
+ * any other memory.
+ * 
+ * @param self Pointer on library context.
+ * @param buffer Pointer on history buffer or NULL to disable history.
+ * @param size Size of history buffer in bytes.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_set_history_buff_impl(eddy_p self, char* buffer, eddy_size_t size)
+{
+#ifdef EDDY_USE_HISTORY_INDEX
+	unsigned int idx;
+#endif
+
+	if(self == EDDY_NULL || (buffer != EDDY_NULL && size <= EDDY_HIST_ENTRY_OVERHEAD)) {
+		return EDDY_RETV_ERR;
+	}
+
+	self->ctx->hist_buff = buffer;
+	self->ctx->hist_size = (buffer != EDDY_NULL) ? size : 0;
+	self->ctx->hist_used = 0;
+	self->ctx->hist_head = 0;
+	self->ctx->hist_tail = 0;
+	self->ctx->hist_recall = 0;
+	self->ctx->hist_search = EDDY_HIST_SEARCH_NONE;
+#ifdef EDDY_USE_HISTORY_INDEX
+	for(idx = 0; idx < EDDY_HIST_INDEX_BUCKETS; idx++) {
+		self->ctx->hist_index[idx] = EDDY_HIST_NONE;
 	}
+#endif
 
 	return EDDY_RETV_OK;
 }
 
 /**
- * @brief Proceed delete on line buffer.
+ * @brief Implementation of api set_line_buff function.
+ * 
+ * Given buffer is used instead of buffer inside context. Line which does
+ * not fit into it still grows up to set_line_limit. Edited line is copied
+ * into new buffer, so it must be larger than the line.
  * 
  * @param self Pointer on library context.
- * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ * @param buffer Pointer on line buffer or NULL to use buffer inside context.
+ * @param size Size of line buffer.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if edited line does not fit.
  */
-eddy_retv_t eddy_process_del_key(eddy_p self)
+eddy_retv_t eddy_set_line_buff_impl(eddy_p self, char* buffer, eddy_size_t size)
 {
-	eddy_retv_t error = EDDY_RETV_OK;
+	eddy_ctx_p ctx;
 
-	if(self->ctx->line_pos < self->ctx->line_len) {
-		error = eddy_print(self, VT100_SAVE_CURSOR_POS);
+	if(self == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
 
-		if(!error) {
-			error = eddy_print(self, self->ctx->line_buffer + self->ctx->line_pos + 1);
-		}
+	ctx = self->ctx;
 
-		if(!error) {
-			error = eddy_print(self, " " VT100_RESTORE_CURSOR_POS);
-		}
+	if(buffer == EDDY_NULL) {
+		buffer = ctx->line_store;
+		size = EDDY_LINE_STORE_LEN;
+	}
 
-		memmove(self->ctx->line_buffer + self->ctx->line_pos,
-			self->ctx->line_buffer + self->ctx->line_pos + 1,
-			self->ctx->line_len - self->ctx->line_pos+1);
+	if(ctx->line_len >= size) {
+		return EDDY_RETV_ERR;
+	}
 
-		self->ctx->line_len--;
+	eddy_line_touch(self);
+	eddy_line_view(self);
+
+	if(buffer != ctx->line_buffer) {
+		memcpy(buffer, ctx->line_buffer, ctx->line_len + 1);
 	}
 
-	return error;
+	if(ctx->line_buffer != ctx->line_base) {
+		eddy_free(ctx->line_buffer);
+	}
+
+	ctx->line_buffer = buffer;
+	ctx->line_size = size;
+	ctx->line_base = buffer;
+	ctx->line_base_size = size;
+
+	return EDDY_RETV_OK;
 }
 
 /**
- * @brief Proceed move cursor left on line buffer.
+ * @brief Implementation of api set_line_limit function.
+ * 
+ * Line longer than its buffer is moved into buffer allocated with
+ * eddy_malloc, which is twice as large, until limit is reached. Allocated
+ * buffer is freed after the line is executed.
  * 
  * @param self Pointer on library context.
+ * @param limit Maximal size of line buffer, 0 to keep line in its buffer,
+ * EDDY_MAX_LINE_BUFF_LEN after init_eddy, 0 after init_eddy_static and init_eddy_pool.
  * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
  */
-eddy_retv_t eddy_process_cursor_left(eddy_p self)
+eddy_retv_t eddy_set_line_limit_impl(eddy_p self, eddy_size_t limit)
 {
-	eddy_retv_t error = EDDY_RETV_OK;
+	if(self == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	self->ctx->line_limit = limit;
+
+	return EDDY_RETV_OK;
+}
 
-	if(self->ctx->line_pos > 0) {
-		error = eddy_print(self, VT100_BACKSPACE);
-		self->ctx->line_pos--;
+/**
+ * @brief Implementation of api set_line_full_clbk function.
+ * 
+ * @param self Pointer on library context.
+ * @param line_full_clbk Pointer on notification function or NULL.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_set_line_full_impl(eddy_p self, eddy_line_full_clbk line_full_clbk)
+{
+	if(self == EDDY_NULL) {
+		return EDDY_RETV_ERR;
 	}
 
-	return error;
+	self->ctx->line_full_clbk = line_full_clbk;
+
+	return EDDY_RETV_OK;
 }
 
 /**
- * @brief Proceed move cursor right on line buffer.
+ * @brief Implementation of api put_char function.
  * 
- * @param self Pointer on library context
+ * @param self Pointer on library context.
+ * @param c Character passed from terminal.
  * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
  */
-eddy_retv_t eddy_process_cursor_right(eddy_p self)
+eddy_retv_t eddy_put_char_impl(eddy_p self, char c)
 {
-	eddy_retv_t error = EDDY_RETV_OK;
+	eddy_retv_t error;
 
-	if(self->ctx->line_pos < self->ctx->line_len) {
-		error = eddy_print(self, VT100_MOVE_CURSOR_RIGHT);
+	if(self == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	EDDY_STAT_ADD(self->ctx, bytes_in, 1);
+	EDDY_RECORD(self, EDDY_RECORD_INPUT, &c, 1);
+
+	error = eddy_log_drain(self);
+
+	if(self->ctx->exec_pending) {
+		eddy_typeahead_put(self, &c, 1);
+	} else if(self->ctx->batch_mode) {
+		if(eddy_batch_chars(self, &c, 1) != EDDY_RETV_OK) {
+			error = EDDY_RETV_ERR;
+		}
+	} else if(eddy_process_char(self, c) != EDDY_RETV_OK) {
+		error = EDDY_RETV_ERR;
+	}
 
-		self->ctx->line_pos++;
+	eddy_line_full_notify(self);
+
+	if(eddy_flush_impl(self) != EDDY_RETV_OK) {
+		error = EDDY_RETV_ERR;
 	}
 
 	return error;
 }
 
 /**
- * @brief Function proceed hint searching.
+ * @brief Implementation of api put_chars function.
  * 
- * The function is called when [TAB] is pressed. Passes
- * the entered command through the set callback function.
- * 
- * @see eddy_s#set_check_hint_clbk
+ * Runs of printable characters are inserted into line buffer without
+ * echo. The line is redrawn once after each run, so terminal receives
+ * only final state of the line or its state at each command boundary.
  * 
  * @param self Pointer on library context.
- * @param cmd_line Command line buffer to process.
+ * @param buffer Characters passed from terminal.
+ * @param len Number of characters in buffer.
  * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
  */
-eddy_retv_t eddy_process_check_hint(eddy_p self, char* cmd_line)
+eddy_retv_t eddy_put_chars_impl(eddy_p self, const char* buffer, eddy_size_t len)
 {
-	eddy_retv_t error = EDDY_RETV_OK;
+	eddy_retv_t error;
 
-	if(self == EDDY_NULL || self->ctx->check_hint_clbk == EDDY_NULL) {
+	if(self == EDDY_NULL || (buffer == EDDY_NULL && len > 0)) {
 		return EDDY_RETV_ERR;
 	}
 
-	self->ctx->check_hint_clbk(cmd_line);
+	EDDY_STAT_ADD(self->ctx, bytes_in, len);
+	EDDY_RECORD(self, EDDY_RECORD_INPUT, buffer, len);
 
-	self->ctx->line_pos = strlen(self->ctx->line_buffer);
-	self->ctx->line_len = self->ctx->line_pos;
+	error = eddy_log_drain(self);
 
-	if(!error) {
-		error = eddy_print(self, self->ctx->prompt);
+	if(eddy_process_chars(self, buffer, len) != EDDY_RETV_OK) {
+		error = EDDY_RETV_ERR;
 	}
 
-	if(!error) {
-		error = eddy_print(self, self->ctx->line_buffer);
+	eddy_line_full_notify(self);
+
+	if(eddy_flush_impl(self) != EDDY_RETV_OK) {
+		error = EDDY_RETV_ERR;
 	}
 
-	return EDDY_RETV_OK;
+	return error;
 }
 
 /**
- * @brief Function precesses command entered in terminal.
+ * @brief Processes buffer of characters without flushing output.
  * 
- * The function is called when [ENTER] is pressed. Passes
- * the entered command through the set callback function.
+ * Characters following command which became pending are stored in
+ * type-ahead buffer.
  * 
  * @param self Pointer on library context.
- * @param cmd_line Command line buffer to process.
+ * @param buffer Characters passed from terminal.
+ * @param len Number of characters in buffer.
  * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
  */
-eddy_retv_t eddy_process_exec_cmd(eddy_p self, const char* cmd_line)
+eddy_retv_t eddy_process_chars(eddy_p self, const char* buffer, eddy_size_t len)
 {
 	eddy_retv_t error = EDDY_RETV_OK;
+	unsigned int run_pos = 0;
+	unsigned int run_cell = 0;
+	unsigned int seq;
+	int run = 0;
+	eddy_size_t idx;
+	char c;
 
-	if(self == EDDY_NULL || self->ctx->exec_cmd_clbk == EDDY_NULL) {
-		return EDDY_RETV_ERR;
+	if(self->ctx->batch_mode) {
+		return eddy_batch_chars(self, buffer, len);
 	}
 
-	error = eddy_print(self, "\r\n");
+	for(idx = 0; idx < len; idx++) {
+		c = buffer[idx];
 
-	if(!error) {
-		if(self->ctx->exec_cmd_clbk(cmd_line) != EDDY_RETV_OK) {
-			error = eddy_print(self, "ERROR\r\n");
+		if(self->ctx->exec_pending) {
+			eddy_typeahead_put(self, buffer + idx, len - idx);
+			break;
 		}
-	}
 
-	if(!error) {
-		error = eddy_print(self, self->ctx->prompt);
+		/* multibyte character is part of run only if it is complete in buffer */
+		seq = ((unsigned char)c < 0x80) ? 1 : eddy_utf8_complete(buffer + idx, len - idx);
+
+		if((unsigned char)c >= 0x20 && c != self->ctx->keys_codes.bs_key
+			&& c != self->ctx->keys_codes.del_key && self->ctx->esc_seq_len == 0
+			&& self->ctx->hist_search == EDDY_HIST_SEARCH_NONE && self->ctx->utf8_len == 0 && seq > 0) {
+			if(!run) {
+				run_pos = self->ctx->line_pos;
+				run_cell = self->ctx->line_start + self->ctx->line_col;
+				run = 1;
+				self->ctx->comp_tab = 0;
+				self->ctx->term_query = EDDY_TERM_QUERY_NONE;
+			}
+
+			if(seq == 1) {
+				eddy_line_insert(self, c);
+			} else {
+				eddy_line_insert_seq(self, buffer + idx, seq);
+				idx += seq - 1;
+			}
+			continue;
+		}
+
+		if(run) {
+			if(eddy_print_line_tail(self, run_pos, run_cell) != EDDY_RETV_OK) {
+				error = EDDY_RETV_ERR;
+			}
+			run = 0;
+		}
+
+		if(eddy_process_char(self, c) != EDDY_RETV_OK) {
+			error = EDDY_RETV_ERR;
+		}
 	}
 
-	self->ctx->line_len = 0;
-	self->ctx->line_pos = 0;
-	self->ctx->line_buffer[self->ctx->line_len] = '\0';
+	if(run) {
+		if(eddy_print_line_tail(self, run_pos, run_cell) != EDDY_RETV_OK) {
+			error = EDDY_RETV_ERR;
+		}
+	}
 
 	return error;
 }
 
 /**
- * @brief Function to print string in terminal.
+ * @brief Assembles lines from buffer of characters in batch mode.
+ * 
+ * Line ends are found with memchr and text between them is copied into
+ * line buffer at once. Characters are not echoed or decoded, empty lines
+ * are skipped and characters which do not fit into line buffer are dropped.
  * 
  * @param self Pointer on library context.
- * @param buffer Pointer on buffer to print.
+ * @param buffer Characters passed from input.
+ * @param len Number of characters in buffer.
  * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
  */
-eddy_retv_t eddy_print(eddy_p self, const char* buffer)
+eddy_retv_t eddy_batch_chars(eddy_p self, const char* buffer, eddy_size_t len)
 {
-	if(self == EDDY_NULL || self->ctx->cli_print_clbk == EDDY_NULL) {
-		return EDDY_RETV_ERR;
-	}
+	eddy_retv_t error = EDDY_RETV_OK;
+	eddy_ctx_p ctx = self->ctx;
+	const char* end = buffer + len;
+	const char* lf;
+	const char* eol;
+	eddy_size_t cnt;
+	eddy_size_t room;
 
-	self->ctx->cli_print_clbk(buffer);
+	lf = memchr(buffer, '\n', len);
 
-	return EDDY_RETV_OK;
+	while(buffer < end) {
+		if(ctx->exec_pending) {
+			eddy_typeahead_put(self, buffer, end - buffer);
+			break;
+		}
+
+		/* found LF is kept, so lines ended with CR do not scan whole buffer again */
+		if(lf != EDDY_NULL && lf < buffer) {
+			lf = memchr(buffer, '\n', end - buffer);
+		}
+
+		eol = memchr(buffer, '\r', ((lf != EDDY_NULL) ? lf : end) - buffer);
+
+		if(eol == EDDY_NULL) {
+			eol = lf;
+		}
+
+		cnt = ((eol != EDDY_NULL) ? eol : end) - buffer;
+		room = (eddy_line_reserve(self, ctx->line_len + cnt) == EDDY_RETV_OK) ? cnt : ctx->line_size - 1 - ctx->line_len;
+
+		if(cnt > room) {
+			EDDY_STAT_ADD(ctx, insert_drops, cnt - room);
+			ctx->line_drops += cnt - room;
+			cnt = room;
+		}
+
+		if(cnt > 0) {
+			eddy_line_touch(self);
+			memcpy(ctx->line_buffer + ctx->line_len, buffer, cnt);
+			ctx->line_len += cnt;
+			ctx->line_pos = ctx->line_len;
+			ctx->line_buffer[ctx->line_len] = '\0';
+		}
+
+		if(eol == EDDY_NULL) {
+			break;
+		}
+
+		buffer = eol + 1;
+
+		if(ctx->line_len > 0 && eddy_batch_exec(self) != EDDY_RETV_OK) {
+			error = EDDY_RETV_ERR;
+		}
+	}
+
+	return error;
 }
 
 /**
- * @brief Function to print single character in terminal.
+ * @brief Executes line assembled in batch mode.
+ * 
+ * Line is not added to history. Only error of command is printed.
  * 
  * @param self Pointer on library context.
- * @param ch Character to print.
  * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
  */
-eddy_retv_t eddy_put(eddy_p self, char ch)
+eddy_retv_t eddy_batch_exec(eddy_p self)
 {
-	char buffer[2];
+	eddy_retv_t status;
 
-	if(self == EDDY_NULL || self->ctx->cli_print_clbk == EDDY_NULL) {
+	if(self->ctx->exec_cmd_clbk == EDDY_NULL
+		&& self->ctx->cmd_table == EDDY_NULL && self->ctx->cmd_map == EDDY_NULL) {
+		eddy_line_clear(self);
 		return EDDY_RETV_ERR;
 	}
 
-	buffer[0] = ch;
-	buffer[1] = '\0';
+	EDDY_STAT_ADD(self->ctx, exec_calls, 1);
 
-	self->ctx->cli_print_clbk(buffer);
+	status = eddy_cmd_dispatch(self, self->ctx->line_buffer);
+	EDDY_RECORD_STATUS(self, EDDY_RECORD_EXEC, status);
 
-	return EDDY_RETV_OK;
+	if(status == EDDY_RETV_PENDING) {
+		self->ctx->exec_pending = 1;
+		return EDDY_RETV_OK;
+	}
+
+	return eddy_exec_finish(self, status);
+}
+
+/**
+ * @brief Store input received while command is pending.
+ * 
+ * When input does not fit, buffer is cut after last complete key, so
+ * escape sequence or multibyte character is never split, and all input
+ * is dropped until command is done.
+ * 
+ * @param self Pointer on library context.
+ * @param buffer Characters passed from terminal.
+ * @param len Number of characters in buffer.
+ */
+void eddy_typeahead_put(eddy_p self, const char* buffer, eddy_size_t len)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int keep;
+
+	if(!ctx->ahead_full && len > EDDY_TYPEAHEAD_LEN - ctx->ahead_len) {
+		memcpy(ctx->ahead_buff + ctx->ahead_len, buffer, EDDY_TYPEAHEAD_LEN - ctx->ahead_len);
+		keep = eddy_typeahead_keys(ctx->ahead_buff, EDDY_TYPEAHEAD_LEN);
+
+		EDDY_STAT_ADD(ctx, typeahead_drops, len + ctx->ahead_len - keep);
+		ctx->ahead_len = keep;
+		ctx->ahead_full = 1;
+		return;
+	}
+
+	if(ctx->ahead_full) {
+		EDDY_STAT_ADD(ctx, typeahead_drops, len);
+		return;
+	}
+
+	memcpy(ctx->ahead_buff + ctx->ahead_len, buffer, len);
+	ctx->ahead_len += len;
+}
+
+/**
+ * @brief Get length of complete keys at start of input.
+ * 
+ * Key is single character, complete multibyte character or escape
+ * sequence. Invalid byte is counted as key, it is dropped when processed.
+ * 
+ * @param buffer Characters passed from terminal.
+ * @param len Number of characters in buffer.
+ * @return unsigned int Number of characters up to end of last complete key.
+ */
+unsigned int eddy_typeahead_keys(const char* buffer, unsigned int len)
+{
+	unsigned int idx = 0;
+	unsigned int end;
+	unsigned int seq;
+
+	while(idx < len) {
+		if(buffer[idx] == VT100_ESC_CODE) {
+			end = idx + 1;
+
+			if(end < len && buffer[end] == '[') {	/* parameters and C0 controls up to final byte */
+				end++;
+				while(end < len && (unsigned char)buffer[end] < 0x40 && buffer[end] != VT100_ESC_CODE) {
+					end++;
+				}
+			} else if(end < len && buffer[end] == 'O') {
+				end++;
+			}
+
+			if(end >= len) {
+				break;
+			}
+
+			/* ESC starts new sequence */
+			idx = (buffer[end] == VT100_ESC_CODE) ? end : end + 1;
+		} else if(eddy_utf8_seq_len(buffer[idx]) > 1) {
+			seq = eddy_utf8_complete(buffer + idx, len - idx);
+
+			/* not finished character at end, invalid one is single key */
+			if(seq == 0 && eddy_utf8_partial(buffer, len) == len - idx) {
+				break;
+			}
+			idx += (seq == 0) ? 1 : seq;
+		} else {
+			idx++;
+		}
+	}
+
+	return idx;
+}
+
+/**
+ * @brief Processes single character or key code without flushing output.
+ * 
+ * Control character received inside escape sequence is executed as if it
+ * came before the sequence, which is continued with next character. ESC
+ * starts new sequence, CAN and SUB cancel it.
+ * 
+ * @param self Pointer on library context.
+ * @param c Character passed from terminal.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_char(eddy_p self, char c)
+{
+	eddy_retv_t error = EDDY_RETV_OK;
+	/* C0 control inside escape sequence is executed in place and sequence continues */
+	int in_seq = self->ctx->esc_seq_len > 0 && (unsigned char)c >= 0x20;
+
+	if(c != '\t') {
+		self->ctx->comp_tab = 0;
+	}
+
+	/* multibyte character interrupted by other byte is dropped */
+	if(self->ctx->utf8_len > 0 && !EDDY_UTF8_CONT(c)) {
+		self->ctx->utf8_len = 0;
+	}
+
+	if(self->ctx->hist_search == EDDY_HIST_SEARCH_REVERSE) {
+		if(eddy_search_consumes(self, c)) {
+			return eddy_process_search_char(self, c);
+		}
+
+		eddy_search_exit(self);
+	} else if(!in_seq && c != VT100_ESC_CODE) {
+		self->ctx->hist_search = EDDY_HIST_SEARCH_NONE;
+	}
+
+	if(!in_seq && c != VT100_ESC_CODE) {
+		self->ctx->term_query = EDDY_TERM_QUERY_NONE;
+	}
+
+	if(c == self->ctx->keys_codes.bs_key) {
+		error = eddy_process_bs_key(self);
+	} else if(c == self->ctx->keys_codes.del_key) {
+		error = eddy_process_del_key(self);
+	} else if(in_seq) {
+		error = eddy_process_esc_seq(self, c);
+	} else if(self->ctx->esc_seq_len > 0 && (c == VT100_CAN_CODE || c == VT100_SUB_CODE)) {	/* seq cancel */
+		self->ctx->esc_seq_len = 0;
+	} else if(c == VT100_ESC_CODE) {	/* seq start, unfinished one is abandoned */
+		self->ctx->esc_seq[0] = c;
+		self->ctx->esc_seq_len = 1;
+		self->ctx->esc_state = EDDY_ESC_STATE_ESC;
+	} else if(c == '\t') {
+		error = eddy_process_tab(self);
+	} else if((c == '\n') || (c == '\r')) {
+		error = eddy_process_exec_cmd(self, eddy_line_view(self));
+	} else if((unsigned char)c < 0x20 && eddy_ctrl_handlers[(unsigned char)c] != EDDY_NULL) {
+		error = eddy_ctrl_handlers[(unsigned char)c](self);
+	} else {
+		error = eddy_proces_insert_char(self, c);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Decodes next character of escape sequence.
+ * 
+ * Sequence is decoded byte by byte. When final character is received
+ * the key is resolved with single table lookup and its handler is called.
+ * 
+ * @param self Pointer on library context.
+ * @param c Character passed from terminal.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_esc_seq(eddy_p self, char c)
+{
+	eddy_retv_t error = EDDY_RETV_OK;
+	eddy_ctx_p ctx = self->ctx;
+	unsigned char intro;
+	unsigned int param;
+	unsigned int value;
+	eddy_key_t key;
+
+	if(ctx->esc_seq_len < EDDY_MAX_ESC_SEQ_LEN) {
+		ctx->esc_seq[ctx->esc_seq_len++] = c;
+		ctx->esc_seq[ctx->esc_seq_len] = '\0';
+	}
+
+	if(ctx->esc_state == EDDY_ESC_STATE_ESC) {
+		ctx->esc_param_cnt = 0;
+		ctx->esc_params[0] = 0;
+		ctx->esc_params[1] = 0;
+
+		if(c == '[') {
+			ctx->esc_state = EDDY_ESC_STATE_CSI;
+			return EDDY_RETV_OK;
+		} else if(c == 'O') {
+			ctx->esc_state = EDDY_ESC_STATE_SS3;
+			return EDDY_RETV_OK;
+		}
+		intro = 0;
+	} else if(c >= '0' && c <= '9' && ctx->esc_state != EDDY_ESC_STATE_INVALID) {
+		value = ctx->esc_params[ctx->esc_param_cnt] * 10 + (c - '0');
+
+		if(value > EDDY_ESC_MAX_PARAM_VAL) {
+			ctx->esc_state = EDDY_ESC_STATE_INVALID;
+		} else {
+			ctx->esc_params[ctx->esc_param_cnt] = value;
+		}
+		return EDDY_RETV_OK;
+	} else if(c == ';' && ctx->esc_state != EDDY_ESC_STATE_INVALID) {
+		if(++ctx->esc_param_cnt >= EDDY_ESC_MAX_PARAMS) {
+			ctx->esc_state = EDDY_ESC_STATE_INVALID;
+		}
+		return EDDY_RETV_OK;
+	} else if(c >= 0x20 && c < 0x40) {	/* other parameter or intermediate characters */
+		ctx->esc_state = EDDY_ESC_STATE_INVALID;
+		return EDDY_RETV_OK;
+	} else {
+		intro = (ctx->esc_state == EDDY_ESC_STATE_SS3) ? 'O' : '[';
+	}
+
+	/* seq end, ESC[row;colR is cursor position report while query is in progress */
+	if(c == 'R' && intro == '[' && ctx->esc_param_cnt == 1
+		&& ctx->esc_state != EDDY_ESC_STATE_INVALID && ctx->term_query != EDDY_TERM_QUERY_NONE) {
+		ctx->esc_seq_len = 0;
+		return eddy_term_report(self, ctx->esc_params[1]);
+	}
+
+	/* terminal answers query before other keys */
+	ctx->term_query = EDDY_TERM_QUERY_NONE;
+	key = EDDY_KEY_NONE;
+
+	if(ctx->esc_state != EDDY_ESC_STATE_INVALID) {
+		param = (c == '~') ? ctx->esc_params[0] : 0;
+
+		if(param <= 0xFF) {
+			key = eddy_key_lookup(EDDY_KEY_CODE(intro, param, c));
+		}
+	}
+
+	if(key != EDDY_KEY_PAGE_UP && key != EDDY_KEY_PAGE_DOWN) {
+		ctx->hist_search = EDDY_HIST_SEARCH_NONE;
+	}
+
+	if(key == EDDY_KEY_NONE) {
+		//Unknown escape sequence
+		EDDY_STAT_ADD(ctx, esc_rejected, 1);
+		eddy_print(self, ctx->esc_seq);
+	} else {
+		EDDY_STAT_ADD(ctx, esc_decoded, 1);
+
+		if(eddy_key_handlers[key] != EDDY_NULL) {
+			error = eddy_key_handlers[key](self);
+		}
+	}
+
+	ctx->esc_seq_len = 0;
+
+	return error;
+}
+
+/**
+ * @brief Handle cursor position report requested by query_term_width.
+ * 
+ * @param self Pointer on library context.
+ * @param col Reported cursor column, counted from 1.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_term_report(eddy_p self, unsigned int col)
+{
+	eddy_ctx_p ctx = self->ctx;
+	eddy_retv_t error;
+
+	if(ctx->term_query == EDDY_TERM_QUERY_START) {
+		ctx->term_query = EDDY_TERM_QUERY_EDGE;
+		ctx->term_query_col = col;
+
+		/* terminal stops cursor at the right edge */
+		error = eddy_print_cursor_move(self, VT100_MOVE_CURSOR_RIGHT_N, EDDY_ESC_MAX_PARAM_VAL);
+
+		if(!error) {
+			error = eddy_print(self, VT100_QUERY_CURSOR_POS);
+		}
+
+		return error;
+	}
+
+	ctx->term_query = EDDY_TERM_QUERY_NONE;
+
+	if(col > 0) {
+		ctx->term_cols = col;
+		eddy_line_layout(self, col, 1);
+	}
+
+	if(col > ctx->term_query_col) {
+		return eddy_print_cursor_move(self, VT100_MOVE_CURSOR_LEFT_N, col - ctx->term_query_col);
+	}
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Resolves key code of escape sequence.
+ * 
+ * @see EDDY_KEYS_TABLE
+ * 
+ * @param code Sequence code created with EDDY_KEY_CODE.
+ * @return eddy_key_t Key code or EDDY_KEY_NONE if sequence is unknown.
+ */
+eddy_key_t eddy_key_lookup(unsigned long code)
+{
+#define EDDY_KEY_CASE(key, intro, param, final) case EDDY_KEY_CODE(intro, param, final): return key;
+	switch(code) {
+	EDDY_KEYS_TABLE(EDDY_KEY_CASE)
+	default:
+		return EDDY_KEY_NONE;
+	}
+#undef EDDY_KEY_CASE
+}
+
+/**
+ * @brief Fonction shows prompt
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_show_prompt_impl(eddy_p self)
+{
+	eddy_retv_t error;
+
+	error = eddy_print_prompt(self);
+
+	if(!error) {
+		error = eddy_flush_impl(self);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Implementation of api flush function.
+ * 
+ * Passes content of output staging buffer to terminal printing
+ * callback with single call.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_flush_impl(eddy_p self)
+{
+	eddy_ctx_p ctx;
+	unsigned int cnt;
+#if defined(EDDY_USE_STATS) || defined(EDDY_USE_RECORDER)
+	unsigned int idx;
+#endif
+
+	if(self == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	ctx = self->ctx;
+
+	if(ctx->cli_write_clbk != EDDY_NULL) {
+		if(ctx->out_segs_cnt > 0) {
+#ifdef EDDY_USE_STATS
+			for(idx = 0; idx < ctx->out_segs_cnt; idx++) {
+				ctx->stats.bytes_out += ctx->out_segs[idx].len;
+			}
+			ctx->stats.print_calls++;
+#endif
+#ifdef EDDY_USE_RECORDER
+			for(idx = 0; idx < ctx->out_segs_cnt; idx++) {
+				EDDY_RECORD(self, EDDY_RECORD_OUTPUT, ctx->out_segs[idx].data, ctx->out_segs[idx].len);
+			}
+#endif
+			cnt = ctx->out_segs_cnt;
+			ctx->out_segs_cnt = 0;
+			ctx->out_len = 0;
+			ctx->out_refs = 0;
+			ctx->cli_write_clbk(self, ctx->out_segs, cnt);
+		}
+	} else if(ctx->out_len > 0) {
+		if(ctx->cli_print_clbk == EDDY_NULL) {
+			return EDDY_RETV_ERR;
+		}
+
+		EDDY_STAT_ADD(ctx, bytes_out, ctx->out_len);
+		EDDY_STAT_ADD(ctx, print_calls, 1);
+		EDDY_RECORD(self, EDDY_RECORD_OUTPUT, ctx->out_buff, ctx->out_len);
+
+		ctx->out_buff[ctx->out_len] = '\0';
+		ctx->out_len = 0;
+		ctx->cli_print_clbk(ctx->out_buff);
+	}
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Implementation of api command_done function.
+ * 
+ * Finishes command which returned EDDY_RETV_PENDING: prints error if
+ * status is not EDDY_RETV_OK and new prompt, then processes input
+ * received in the meantime. Must not be called from command callback.
+ * 
+ * @param self Pointer on library context.
+ * @param status Result of command.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if no command is pending.
+ */
+eddy_retv_t eddy_command_done_impl(eddy_p self, eddy_retv_t status)
+{
+	char ahead[EDDY_TYPEAHEAD_LEN];
+	eddy_retv_t error;
+	unsigned int len;
+
+	if(self == EDDY_NULL || !self->ctx->exec_pending) {
+		return EDDY_RETV_ERR;
+	}
+
+	self->ctx->exec_pending = 0;
+	self->ctx->ahead_full = 0;
+	EDDY_RECORD_STATUS(self, EDDY_RECORD_DONE, status);
+
+	error = eddy_exec_finish(self, status);
+
+	/* replayed input may start next pending command and queue its rest again */
+	len = self->ctx->ahead_len;
+	memcpy(ahead, self->ctx->ahead_buff, len);
+	self->ctx->ahead_len = 0;
+
+	if(eddy_process_chars(self, ahead, len) != EDDY_RETV_OK) {
+		error = EDDY_RETV_ERR;
+	}
+
+	eddy_line_full_notify(self);
+
+	if(eddy_flush_impl(self) != EDDY_RETV_OK) {
+		error = EDDY_RETV_ERR;
+	}
+
+	return error;
+}
+
+/**
+ * @brief Implementation of api put_log function.
+ * 
+ * Copies message into free slot of log queue. Can be called from any
+ * thread or interrupt at the same time as other library functions, slot
+ * is reserved with compare and swap, nothing is locked.
+ * 
+ * @param self Pointer on library context.
+ * @param text Message without line end, truncated to EDDY_LOG_MSG_LEN - 1 characters.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if queue is full or disabled.
+ */
+eddy_retv_t eddy_put_log_impl(eddy_p self, const char* text)
+{
+#ifdef EDDY_USE_LOG_QUEUE
+	eddy_log_slot_t* slot;
+	unsigned int pos;
+	unsigned int seq;
+	unsigned int len;
+#endif
+
+	if(self == EDDY_NULL || text == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+#ifdef EDDY_USE_LOG_QUEUE
+	pos = atomic_load_explicit(&self->ctx->log_tail, memory_order_relaxed);
+
+	for(;;) {
+		slot = self->ctx->log_slots + (pos & (EDDY_LOG_SLOTS - 1));
+		seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+
+		if(seq == pos) {
+			/* failed exchange loads current tail into pos */
+			if(atomic_compare_exchange_weak_explicit(&self->ctx->log_tail, &pos, pos + 1,
+				memory_order_relaxed, memory_order_relaxed)) {
+				break;
+			}
+		} else if((int)(seq - pos) < 0) {
+			/* slot still holds message from previous lap */
+			atomic_fetch_add_explicit(&self->ctx->log_drops, 1, memory_order_relaxed);
+			return EDDY_RETV_ERR;
+		} else {
+			pos = atomic_load_explicit(&self->ctx->log_tail, memory_order_relaxed);
+		}
+	}
+
+	for(len = 0; len < EDDY_LOG_MSG_LEN - 1 && text[len] != '\0'; len++) {
+		slot->text[len] = text[len];
+	}
+
+	slot->text[len] = '\0';
+	atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+	return EDDY_RETV_OK;
+#else
+	return EDDY_RETV_ERR;
+#endif
+}
+
+/**
+ * @brief Implementation of api drain_logs function.
+ * 
+ * Must be called from the same thread as put_char and put_chars, which
+ * also drain the queue before processing input.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error or queue is disabled.
+ */
+eddy_retv_t eddy_drain_logs_impl(eddy_p self)
+{
+#ifdef EDDY_USE_LOG_QUEUE
+	eddy_retv_t error;
+#endif
+
+	if(self == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+#ifdef EDDY_USE_LOG_QUEUE
+	error = eddy_log_drain(self);
+
+	if(eddy_flush_impl(self) != EDDY_RETV_OK) {
+		error = EDDY_RETV_ERR;
+	}
+
+	return error;
+#else
+	return EDDY_RETV_ERR;
+#endif
+}
+
+/**
+ * @brief Print queued log messages without flushing output.
+ * 
+ * Edited line is cleared once, ready messages are printed each in own
+ * line, then prompt and line are printed again with cursor restored. At
+ * most EDDY_LOG_SLOTS messages are printed, so producers can not keep
+ * editor thread here.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_log_drain(eddy_p self)
+{
+#ifdef EDDY_USE_LOG_QUEUE
+	eddy_ctx_p ctx = self->ctx;
+	eddy_log_slot_t* slot;
+	eddy_retv_t error = EDDY_RETV_OK;
+	unsigned long drops;
+	unsigned int cnt;
+	char notice[24];
+
+	slot = ctx->log_slots + (ctx->log_head & (EDDY_LOG_SLOTS - 1));
+
+	if(atomic_load_explicit(&slot->seq, memory_order_acquire) != ctx->log_head + 1
+		&& atomic_load_explicit(&ctx->log_drops, memory_order_relaxed) == 0) {
+		return EDDY_RETV_OK;
+	}
+
+	drops = atomic_exchange_explicit(&ctx->log_drops, 0, memory_order_relaxed);
+
+	if(ctx->exec_pending) {
+		error = eddy_print(self, "\r" VT100_CLEAR_LINE_RIGHT);
+	} else if(!ctx->batch_mode) {
+		error = eddy_print_cursor_goto(self, ctx->line_start + ctx->line_col, 0);
+
+		if(!error) {
+			error = eddy_print(self, VT100_CLEAR_SCREEN_DOWN);
+		}
+	}
+
+	for(cnt = 0; cnt < EDDY_LOG_SLOTS && !error; cnt++) {
+		slot = ctx->log_slots + (ctx->log_head & (EDDY_LOG_SLOTS - 1));
+
+		if(atomic_load_explicit(&slot->seq, memory_order_acquire) != ctx->log_head + 1) {
+			break;
+		}
+
+		error = eddy_print(self, slot->text);
+
+		if(!error) {
+			error = eddy_print(self, "\r\n");
+		}
+
+		if(ctx->log_print_clbk != EDDY_NULL) {
+			ctx->log_print_clbk(slot->text);
+		}
+
+		atomic_store_explicit(&slot->seq, ctx->log_head + EDDY_LOG_SLOTS, memory_order_release);
+		ctx->log_head++;
+	}
+
+	EDDY_STAT_ADD(ctx, log_lines, cnt);
+	EDDY_STAT_ADD(ctx, log_drops, drops);
+
+	if(!error && drops > 0) {
+		notice[0] = '(';
+		notice[eddy_format_number(notice + 1, drops) + 1] = '\0';
+		error = eddy_print(self, notice);
+
+		if(!error) {
+			error = eddy_print(self, " log messages dropped)\r\n");
+		}
+	}
+
+	if(error || ctx->exec_pending || ctx->batch_mode) {
+		return error;
+	}
+
+	if(ctx->hist_search == EDDY_HIST_SEARCH_REVERSE) {
+		return eddy_search_draw(self);
+	}
+
+	return eddy_print_prompt_line(self);
+#else
+	(void)self;
+
+	return EDDY_RETV_OK;
+#endif
+}
+
+/**
+ * @brief Implementation of api get_stats function.
+ * 
+ * @param self Pointer on library context.
+ * @param stats Pointer on structure filled with statistics.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if statistics are disabled.
+ */
+eddy_retv_t eddy_get_stats_impl(eddy_p self, eddy_stats_t* stats)
+{
+	if(self == EDDY_NULL || stats == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+#ifdef EDDY_USE_STATS
+	*stats = self->ctx->stats;
+
+	return EDDY_RETV_OK;
+#else
+	return EDDY_RETV_ERR;
+#endif
+}
+
+/**
+ * @brief Implementation of api reset_stats function.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if statistics are disabled.
+ */
+eddy_retv_t eddy_reset_stats_impl(eddy_p self)
+{
+	if(self == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+#ifdef EDDY_USE_STATS
+	memset(&self->ctx->stats, 0, sizeof(self->ctx->stats));
+
+	return EDDY_RETV_OK;
+#else
+	return EDDY_RETV_ERR;
+#endif
+}
+
+/**
+ * @brief Implementation of api set_recorder_clbk function.
+ * 
+ * @param self Pointer on library context.
+ * @param record_clbk Pointer on recorder function, NULL stops recording.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if recorder is disabled.
+ */
+eddy_retv_t eddy_set_recorder_impl(eddy_p self, eddy_record_clbk record_clbk)
+{
+	if(self == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+#ifdef EDDY_USE_RECORDER
+	eddy_flush_impl(self);
+
+	self->ctx->record_clbk = record_clbk;
+
+	return EDDY_RETV_OK;
+#else
+	(void)record_clbk;
+
+	return EDDY_RETV_ERR;
+#endif
+}
+
+/**
+ * @brief Implementation of api set_batch_mode function.
+ * 
+ * In batch mode input is only split into lines which are executed, there
+ * is no echo, escape sequence decoding, history or prompt. Use it for
+ * input which is not typed on terminal, e.g. when isatty fails. Unfinished
+ * line is kept when mode changes, show prompt after switching back.
+ * 
+ * @param self Pointer on library context.
+ * @param enable Non-zero to enable batch mode, zero to return to interactive editing.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_set_batch_mode_impl(eddy_p self, int enable)
+{
+	if(self == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	eddy_flush_impl(self);
+
+	/* batch lines are appended at the end of contiguous line */
+	eddy_line_view(self);
+	eddy_line_measure(self);
+
+	self->ctx->esc_seq_len = 0;
+	self->ctx->utf8_len = 0;
+	self->ctx->comp_tab = 0;
+	self->ctx->hist_recall = 0;
+	self->ctx->hist_search = EDDY_HIST_SEARCH_NONE;
+	self->ctx->batch_mode = (enable != 0);
+
+	return EDDY_RETV_OK;
+}
+
+eddy_retv_t eddy_destroy_impl(eddy_p self)
+{
+	eddy_pool_p pool;
+
+	if(self == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	eddy_flush_impl(self);
+
+	if(self->ctx->line_buffer != self->ctx->line_base) {
+		eddy_free(self->ctx->line_buffer);
+	}
+
+	if(self->ctx->ctx_origin == EDDY_CTX_HEAP) {
+		eddy_free(self->ctx->ctx_mem);
+	} else if(self->ctx->ctx_origin == EDDY_CTX_POOL) {
+		pool = self->ctx->pool;
+		*(void**)self->ctx = pool->free_list;
+		pool->free_list = self->ctx;
+		pool->free_cnt++;
+	}
+
+	self->ops = EDDY_NULL;
+#ifndef EDDY_USE_SHARED_OPS
+#define EDDY_API_CLEAR(type, name, impl)	self->name = EDDY_NULL;
+	EDDY_API_TABLE(EDDY_API_CLEAR)
+#undef EDDY_API_CLEAR
+#endif
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Insert char into line buffer.
+ * 
+ * Bytes of multibyte UTF-8 character are collected until the character
+ * is complete, then it is inserted and printed at once. Invalid bytes
+ * are dropped.
+ * 
+ * @param self Pointer on library context.
+ * @param c Character to insertion.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_proces_insert_char(eddy_p self, char c)
+{
+	eddy_ctx_p ctx = self->ctx;
+	eddy_retv_t error = EDDY_RETV_OK;
+	const char* seq = &c;
+	unsigned int len = 1;
+	unsigned int cell;
+
+	if((unsigned char)c >= 0x80) {
+		if(!EDDY_UTF8_CONT(c)) {
+			ctx->utf8_need = eddy_utf8_seq_len(c);
+			ctx->utf8_len = 0;
+
+			if(ctx->utf8_need == 0) {
+				return EDDY_RETV_OK;
+			}
+		} else if(ctx->utf8_len == 0) {
+			return EDDY_RETV_OK;
+		}
+
+		ctx->utf8_seq[ctx->utf8_len++] = c;
+
+		if(ctx->utf8_len < ctx->utf8_need) {
+			return EDDY_RETV_OK;
+		}
+
+		seq = ctx->utf8_seq;
+		len = ctx->utf8_len;
+		ctx->utf8_len = 0;
+	}
+
+	cell = ctx->line_start + ctx->line_col;
+
+	if(eddy_line_insert_seq(self, seq, len) == EDDY_RETV_OK) {
+		/* blank cell before wide character moved to next row, see eddy_write_line */
+		if(ctx->line_start + ctx->line_col - cell > eddy_text_width(seq, len)) {
+			error = eddy_write(self, " ", 1);
+		}
+
+		if(!error) {
+			error = eddy_write(self, seq, len);
+		}
+
+		if(!error) {
+			error = eddy_print_line_rest(self, 0);
+		}
+	}
+
+	return error;
+}
+
+/**
+ * @brief Insert char into line buffer without printing.
+ * 
+ * @param self Pointer on library context.
+ * @param c Character to insertion.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if line buffer is full.
+ */
+eddy_retv_t eddy_line_insert(eddy_p self, char c)
+{
+	unsigned int reach = self->ctx->line_width;
+	unsigned int width;
+	unsigned int len;
+
+	if(eddy_line_reserve(self, self->ctx->line_len + 1) != EDDY_RETV_OK) {
+		EDDY_STAT_ADD(self->ctx, insert_drops, 1);
+		self->ctx->line_drops++;
+		return EDDY_RETV_ERR;
+	}
+
+	eddy_line_touch(self);
+
+#ifdef EDDY_USE_GAP_BUFFER
+	eddy_line_gap_open(self->ctx);
+
+	self->ctx->line_buffer[self->ctx->line_pos] = c;
+	self->ctx->line_len++;
+	self->ctx->line_pos++;
+#else
+	if(self->ctx->line_pos < self->ctx->line_len) {
+		memmove(self->ctx->line_buffer + self->ctx->line_pos + 1,
+			self->ctx->line_buffer + self->ctx->line_pos,
+			self->ctx->line_len - self->ctx->line_pos+1);
+	}
+
+	self->ctx->line_buffer[self->ctx->line_pos] = c;
+	self->ctx->line_len++;
+	self->ctx->line_pos++;
+	self->ctx->line_buffer[self->ctx->line_len] = '\0';
+#endif
+
+	/* each byte takes one cell until it completes multibyte character */
+	self->ctx->line_col++;
+	self->ctx->line_width++;
+
+	if(EDDY_UTF8_CONT(c)) {
+		len = eddy_utf8_prev(self->ctx->line_buffer, self->ctx->line_pos, &width);
+
+		if(len > 1) {
+			self->ctx->line_wide |= (width == 2);
+			width = self->ctx->line_col;
+			self->ctx->line_col = eddy_text_cells(self, self->ctx->line_start + self->ctx->line_col - len,
+				self->ctx->line_buffer + self->ctx->line_pos - len, len) - self->ctx->line_start;
+			self->ctx->line_width -= width - self->ctx->line_col;
+		}
+	}
+
+	eddy_line_layout(self, reach, 0);
+
+	EDDY_STAT_MAX(self->ctx, max_line_len, self->ctx->line_len);
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Insert whole multibyte character into line buffer without printing.
+ * 
+ * @param self Pointer on library context.
+ * @param seq Bytes of character.
+ * @param len Number of bytes.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if line buffer is full.
+ */
+eddy_retv_t eddy_line_insert_seq(eddy_p self, const char* seq, unsigned int len)
+{
+	unsigned int idx;
+
+	if(eddy_line_reserve(self, self->ctx->line_len + len) != EDDY_RETV_OK) {
+		EDDY_STAT_ADD(self->ctx, insert_drops, len);
+		self->ctx->line_drops += len;
+		return EDDY_RETV_ERR;
+	}
+
+	for(idx = 0; idx < len; idx++) {
+		eddy_line_insert(self, seq[idx]);
+	}
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Remove character before cursor from line buffer without printing.
+ * 
+ * Whole UTF-8 character is removed together with following zero width
+ * characters (combining marks).
+ * 
+ * @param self Pointer on library context.
+ * @return unsigned int Number of cells cursor moved left.
+ */
+unsigned int eddy_line_delete_back(eddy_p self)
+{
+	unsigned int col = self->ctx->line_col;
+	unsigned int width;
+	unsigned int len;
+
+	len = eddy_line_prev_len(self, &width);
+
+	eddy_line_touch(self);
+
+#ifdef EDDY_USE_GAP_BUFFER
+	eddy_line_gap_open(self->ctx);
+#else
+	memmove(self->ctx->line_buffer + self->ctx->line_pos - len,
+		self->ctx->line_buffer + self->ctx->line_pos,
+		self->ctx->line_len - self->ctx->line_pos + 1);
+#endif
+
+	self->ctx->line_len -= len;
+	self->ctx->line_pos -= len;
+	self->ctx->line_col -= width;
+	self->ctx->line_width -= width;
+	eddy_line_layout(self, self->ctx->line_width + width, width == 2);
+
+	return col - self->ctx->line_col;
+}
+
+/**
+ * @brief Remove character under cursor from line buffer without printing.
+ * 
+ * @param self Pointer on library context.
+ * @return unsigned int Display width of removed character.
+ */
+unsigned int eddy_line_delete(eddy_p self)
+{
+	unsigned int width;
+	unsigned int len;
+
+	len = eddy_line_next_len(self, &width);
+
+	eddy_line_touch(self);
+
+#ifdef EDDY_USE_GAP_BUFFER
+	eddy_line_gap_open(self->ctx);
+#else
+	memmove(self->ctx->line_buffer + self->ctx->line_pos,
+		self->ctx->line_buffer + self->ctx->line_pos + len,
+		self->ctx->line_len - self->ctx->line_pos - len + 1);
+#endif
+
+	self->ctx->line_len -= len;
+	self->ctx->line_width -= width;
+	eddy_line_layout(self, self->ctx->line_width + width, 0);
+
+	return width;
+}
+
+/**
+ * @brief Move cursor in line buffer one character left.
+ * 
+ * @param self Pointer on library context.
+ * @return unsigned int Number of cells cursor moved.
+ */
+unsigned int eddy_line_move_left(eddy_p self)
+{
+	unsigned int col = self->ctx->line_col;
+	unsigned int width;
+	unsigned int len;
+
+	len = eddy_line_prev_len(self, &width);
+
+#ifdef EDDY_USE_GAP_BUFFER
+	eddy_line_touch(self);
+	eddy_line_gap_open(self->ctx);
+
+	memmove(self->ctx->line_buffer + EDDY_LINE_GAP_END(self->ctx) - len,
+		self->ctx->line_buffer + self->ctx->line_pos - len, len);
+#endif
+
+	self->ctx->line_pos -= len;
+	self->ctx->line_col -= width;
+
+	/* wide character may follow padding cell at the end of previous row */
+	if(width == 2 && self->ctx->line_start + self->ctx->line_width >= self->ctx->term_cols) {
+		self->ctx->line_col = eddy_text_cells(self, self->ctx->line_start,
+			self->ctx->line_buffer, self->ctx->line_pos) - self->ctx->line_start;
+	}
+
+	return col - self->ctx->line_col;
+}
+
+/**
+ * @brief Move cursor in line buffer one character right.
+ * 
+ * @param self Pointer on library context.
+ * @return unsigned int Number of cells cursor moved.
+ */
+unsigned int eddy_line_move_right(eddy_p self)
+{
+	unsigned int col = self->ctx->line_col;
+	unsigned int width;
+	unsigned int len;
+
+	len = eddy_line_next_len(self, &width);
+
+#ifdef EDDY_USE_GAP_BUFFER
+	eddy_line_touch(self);
+	eddy_line_gap_open(self->ctx);
+
+	memmove(self->ctx->line_buffer + self->ctx->line_pos,
+		self->ctx->line_buffer + EDDY_LINE_GAP_END(self->ctx), len);
+#endif
+
+	self->ctx->line_pos += len;
+	self->ctx->line_col = eddy_text_cells(self, self->ctx->line_start + col,
+		self->ctx->line_buffer + self->ctx->line_pos - len, len) - self->ctx->line_start;
+
+	return self->ctx->line_col - col;
+}
+
+/**
+ * @brief Move cursor in line buffer to given position without printing.
+ * 
+ * Position must be at character boundary. With gap buffer whole text
+ * between old and new position is moved across the gap at once.
+ * 
+ * @param self Pointer on library context.
+ * @param pos New cursor position.
+ */
+void eddy_line_seek(eddy_p self, unsigned int pos)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int len;
+
+	if(pos < ctx->line_pos) {
+		len = ctx->line_pos - pos;
+
+		if(ctx->line_wide && ctx->line_start + ctx->line_width >= ctx->term_cols) {
+			ctx->line_col = eddy_text_cells(self, ctx->line_start, ctx->line_buffer, pos) - ctx->line_start;
+		} else {
+			ctx->line_col -= eddy_text_width(ctx->line_buffer + pos, len);
+		}
+
+#ifdef EDDY_USE_GAP_BUFFER
+		eddy_line_touch(self);
+		eddy_line_gap_open(ctx);
+
+		memmove(ctx->line_buffer + EDDY_LINE_GAP_END(ctx) - len, ctx->line_buffer + pos, len);
+#endif
+	} else if(pos > ctx->line_pos) {
+		len = pos - ctx->line_pos;
+		ctx->line_col = eddy_text_cells(self, ctx->line_start + ctx->line_col, eddy_line_tail(self), len) - ctx->line_start;
+
+#ifdef EDDY_USE_GAP_BUFFER
+		eddy_line_touch(self);
+		eddy_line_gap_open(ctx);
+
+		memmove(ctx->line_buffer + ctx->line_pos, ctx->line_buffer + EDDY_LINE_GAP_END(ctx), len);
+#endif
+	}
+
+	ctx->line_pos = pos;
+}
+
+/**
+ * @brief Remove text around cursor from line buffer into kill buffer without printing.
+ * 
+ * Removed text replaces previous content of kill buffer. If it is longer
+ * than kill buffer only its beginning is kept.
+ * 
+ * @param self Pointer on library context.
+ * @param back Number of removed bytes before cursor.
+ * @param fwd Number of removed bytes after cursor.
+ */
+void eddy_line_kill(eddy_p self, unsigned int back, unsigned int fwd)
+{
+	eddy_ctx_p ctx = self->ctx;
+	const char* tail = eddy_line_tail(self);
+	unsigned int back_width = eddy_text_width(ctx->line_buffer + ctx->line_pos - back, back);
+	unsigned int fwd_width = eddy_text_width(tail, fwd);
+
+	ctx->kill_len = (back + fwd < EDDY_KILL_BUFF_LEN) ? back + fwd : EDDY_KILL_BUFF_LEN;
+	memcpy(ctx->kill_buff, ctx->line_buffer + ctx->line_pos - back, (back < ctx->kill_len) ? back : ctx->kill_len);
+
+	if(ctx->kill_len > back) {
+		memcpy(ctx->kill_buff + back, tail, ctx->kill_len - back);
+	}
+
+	ctx->kill_len -= eddy_utf8_partial(ctx->kill_buff, ctx->kill_len);
+
+	eddy_line_touch(self);
+
+#ifdef EDDY_USE_GAP_BUFFER
+	eddy_line_gap_open(ctx);
+#else
+	memmove(ctx->line_buffer + ctx->line_pos - back,
+		ctx->line_buffer + ctx->line_pos + fwd,
+		ctx->line_len - ctx->line_pos - fwd + 1);
+#endif
+
+	ctx->line_len -= back + fwd;
+	ctx->line_pos -= back;
+	ctx->line_col -= back_width;
+	ctx->line_width -= back_width + fwd_width;
+	eddy_line_layout(self, ctx->line_width + back_width + fwd_width, back > 0);
+}
+
+/**
+ * @brief Get position of beginning of word before cursor.
+ * 
+ * Words are separated with spaces.
+ * 
+ * @param self Pointer on library context.
+ * @return unsigned int Position in line buffer.
+ */
+unsigned int eddy_line_word_start(eddy_p self)
+{
+	const char* line = self->ctx->line_buffer;
+	unsigned int pos = self->ctx->line_pos;
+
+	while(pos > 0 && line[pos - 1] == ' ') {
+		pos--;
+	}
+
+	while(pos > 0 && line[pos - 1] != ' ') {
+		pos--;
+	}
+
+	return pos;
+}
+
+/**
+ * @brief Get position of end of word after cursor.
+ * 
+ * @param self Pointer on library context.
+ * @return unsigned int Position in line buffer.
+ */
+unsigned int eddy_line_word_end(eddy_p self)
+{
+	const char* tail = eddy_line_tail(self);
+	unsigned int left = self->ctx->line_len - self->ctx->line_pos;
+	unsigned int idx = 0;
+
+	while(idx < left && tail[idx] == ' ') {
+		idx++;
+	}
+
+	while(idx < left && tail[idx] != ' ') {
+		idx++;
+	}
+
+	return self->ctx->line_pos + idx;
+}
+
+/**
+ * @brief Get length of character before cursor.
+ * 
+ * Zero width characters are taken together with preceding character.
+ * Cursor must not be at line beginning.
+ * 
+ * @param self Pointer on library context.
+ * @param width Display width of character.
+ * @return unsigned int Number of bytes.
+ */
+unsigned int eddy_line_prev_len(eddy_p self, unsigned int* width)
+{
+	unsigned int len = 0;
+	unsigned int part;
+
+	*width = 0;
+
+	do {
+		len += eddy_utf8_prev(self->ctx->line_buffer, self->ctx->line_pos - len, &part);
+		*width += part;
+	} while(part == 0 && len < self->ctx->line_pos);
+
+	return len;
+}
+
+/**
+ * @brief Get length of character under cursor.
+ * 
+ * Zero width characters following it are taken together with it.
+ * Cursor must not be at line end.
+ * 
+ * @param self Pointer on library context.
+ * @param width Display width of character.
+ * @return unsigned int Number of bytes.
+ */
+unsigned int eddy_line_next_len(eddy_p self, unsigned int* width)
+{
+	const char* tail = eddy_line_tail(self);
+	unsigned int left = self->ctx->line_len - self->ctx->line_pos;
+	unsigned int part;
+	unsigned int next;
+	unsigned int len;
+
+	len = eddy_utf8_next(tail, left, width);
+
+	while(len < left) {
+		next = eddy_utf8_next(tail + len, left - len, &part);
+
+		if(part != 0) {
+			break;
+		}
+
+		len += next;
+	}
+
+	return len;
+}
+
+/**
+ * @brief Get length of UTF-8 encoded character from its first byte.
+ * 
+ * @param c First byte of character.
+ * @return unsigned int Number of bytes or 0 if byte can not start character.
+ */
+unsigned int eddy_utf8_seq_len(char c)
+{
+	unsigned char byte = (unsigned char)c;
+
+	if(byte < 0x80) {
+		return 1;
+	} else if(byte >= 0xC2 && byte <= 0xDF) {
+		return 2;
+	} else if(byte >= 0xE0 && byte <= 0xEF) {
+		return 3;
+	} else if(byte >= 0xF0 && byte <= 0xF4) {
+		return 4;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Check if text starts with complete multibyte character.
+ * 
+ * @param text Text to check.
+ * @param len Number of bytes available.
+ * @return unsigned int Length of character or 0 if it is not complete or valid.
+ */
+unsigned int eddy_utf8_complete(const char* text, unsigned int len)
+{
+	unsigned int seq = eddy_utf8_seq_len(text[0]);
+	unsigned int idx;
+
+	if(seq < 2 || seq > len) {
+		return 0;
+	}
+
+	for(idx = 1; idx < seq; idx++) {
+		if(!EDDY_UTF8_CONT(text[idx])) {
+			return 0;
+		}
+	}
+
+	return seq;
+}
+
+/**
+ * @brief Get number of bytes at text end which start not finished character.
+ * 
+ * @param text Text to check.
+ * @param len Length of text.
+ * @return unsigned int Number of bytes or 0 if last character is complete.
+ */
+unsigned int eddy_utf8_partial(const char* text, unsigned int len)
+{
+	unsigned int back;
+
+	for(back = 1; back <= EDDY_UTF8_MAX_LEN && back <= len; back++) {
+		if(!EDDY_UTF8_CONT(text[len - back])) {
+			return (eddy_utf8_seq_len(text[len - back]) > back) ? back : 0;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Decode UTF-8 encoded character.
+ * 
+ * @param text Complete character.
+ * @param len Length of character.
+ * @return unsigned long Code point.
+ */
+static unsigned long eddy_utf8_decode(const char* text, unsigned int len)
+{
+	unsigned long cp;
+	unsigned int idx;
+
+	if(len == 1) {
+		return (unsigned char)text[0];
+	}
+
+	cp = (unsigned char)text[0] & (0x7F >> len);
+
+	for(idx = 1; idx < len; idx++) {
+		cp = (cp << 6) | ((unsigned char)text[idx] & 0x3F);
+	}
+
+	return cp;
+}
+
+/**
+ * @brief Get length of character which ends at given position.
+ * 
+ * Byte which is not part of valid character is taken alone with width 1.
+ * 
+ * @param text Text to check.
+ * @param pos Position after character, greater than 0.
+ * @param width Display width of character.
+ * @return unsigned int Number of bytes.
+ */
+unsigned int eddy_utf8_prev(const char* text, unsigned int pos, unsigned int* width)
+{
+	unsigned int back;
+
+	*width = 1;
+
+	if((unsigned char)text[pos - 1] < 0x80) {
+		return 1;
+	}
+
+	for(back = 1; back <= EDDY_UTF8_MAX_LEN && back <= pos; back++) {
+		if(!EDDY_UTF8_CONT(text[pos - back])) {
+			if(back > 1 && eddy_utf8_seq_len(text[pos - back]) == back) {
+				*width = eddy_utf8_width(eddy_utf8_decode(text + pos - back, back));
+				return back;
+			}
+			break;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * @brief Get length of character which starts text.
+ * 
+ * Byte which is not part of valid character is taken alone with width 1.
+ * 
+ * @param text Text to check.
+ * @param len Number of bytes available, greater than 0.
+ * @param width Display width of character.
+ * @return unsigned int Number of bytes.
+ */
+unsigned int eddy_utf8_next(const char* text, unsigned int len, unsigned int* width)
+{
+	unsigned int seq;
+
+	*width = 1;
+
+	if((unsigned char)text[0] < 0x80) {
+		return 1;
+	}
+
+	seq = eddy_utf8_complete(text, len);
+
+	if(seq == 0) {
+		return 1;
+	}
+
+	*width = eddy_utf8_width(eddy_utf8_decode(text, seq));
+
+	return seq;
+}
+
+/**
+ * @brief Range of code points with the same display width.
+ */
+typedef struct eddy_utf8_range_s {
+	unsigned long first;	/**< First code point. */
+	unsigned long last;		/**< Last code point. */
+	unsigned char width;	/**< Display width. */
+} eddy_utf8_range_t;
+
+/**
+ * @brief Code points which do not take one column: combining marks and
+ * format characters (0) and East Asian wide characters and emoji (2).
+ * Sorted, not overlapping.
+ */
+static const eddy_utf8_range_t eddy_utf8_ranges[] = {
+	{ 0x0300, 0x036F, 0 }, { 0x0483, 0x0489, 0 }, { 0x0591, 0x05BD, 0 }, { 0x05BF, 0x05BF, 0 },
+	{ 0x05C1, 0x05C2, 0 }, { 0x05C4, 0x05C5, 0 }, { 0x05C7, 0x05C7, 0 }, { 0x0610, 0x061A, 0 },
+	{ 0x064B, 0x065F, 0 }, { 0x0670, 0x0670, 0 }, { 0x06D6, 0x06DC, 0 }, { 0x06DF, 0x06E4, 0 },
+	{ 0x06E7, 0x06E8, 0 }, { 0x06EA, 0x06ED, 0 }, { 0x0900, 0x0902, 0 }, { 0x093A, 0x093A, 0 },
+	{ 0x093C, 0x093C, 0 }, { 0x0941, 0x0948, 0 }, { 0x094D, 0x094D, 0 }, { 0x0951, 0x0957, 0 },
+	{ 0x0E31, 0x0E31, 0 }, { 0x0E34, 0x0E3A, 0 }, { 0x0E47, 0x0E4E, 0 }, { 0x1100, 0x115F, 2 },
+	{ 0x1AB0, 0x1AFF, 0 }, { 0x1DC0, 0x1DFF, 0 }, { 0x200B, 0x200F, 0 }, { 0x202A, 0x202E, 0 },
+	{ 0x2060, 0x2064, 0 }, { 0x20D0, 0x20FF, 0 }, { 0x231A, 0x231B, 2 }, { 0x2329, 0x232A, 2 },
+	{ 0x23E9, 0x23EC, 2 }, { 0x23F0, 0x23F0, 2 }, { 0x23F3, 0x23F3, 2 }, { 0x25FD, 0x25FE, 2 },
+	{ 0x2614, 0x2615, 2 }, { 0x2648, 0x2653, 2 }, { 0x267F, 0x267F, 2 }, { 0x2693, 0x2693, 2 },
+	{ 0x26A1, 0x26A1, 2 }, { 0x26AA, 0x26AB, 2 }, { 0x26BD, 0x26BE, 2 }, { 0x26C4, 0x26C5, 2 },
+	{ 0x26CE, 0x26CE, 2 }, { 0x26D4, 0x26D4, 2 }, { 0x26EA, 0x26EA, 2 }, { 0x26F2, 0x26F3, 2 },
+	{ 0x26F5, 0x26F5, 2 }, { 0x26FA, 0x26FA, 2 }, { 0x26FD, 0x26FD, 2 }, { 0x2705, 0x2705, 2 },
+	{ 0x270A, 0x270B, 2 }, { 0x2728, 0x2728, 2 }, { 0x274C, 0x274C, 2 }, { 0x274E, 0x274E, 2 },
+	{ 0x2753, 0x2755, 2 }, { 0x2757, 0x2757, 2 }, { 0x2795, 0x2797, 2 }, { 0x27B0, 0x27B0, 2 },
+	{ 0x27BF, 0x27BF, 2 }, { 0x2B1B, 0x2B1C, 2 }, { 0x2B50, 0x2B50, 2 }, { 0x2B55, 0x2B55, 2 },
+	{ 0x2E80, 0x3029, 2 }, { 0x302A, 0x302D, 0 }, { 0x302E, 0x303E, 2 }, { 0x3041, 0x3098, 2 },
+	{ 0x3099, 0x309A, 0 }, { 0x309B, 0xA4CF, 2 }, { 0xA960, 0xA97F, 2 }, { 0xAC00, 0xD7A3, 2 },
+	{ 0xF900, 0xFAFF, 2 }, { 0xFE00, 0xFE0F, 0 }, { 0xFE10, 0xFE19, 2 }, { 0xFE20, 0xFE2F, 0 },
+	{ 0xFE30, 0xFE6F, 2 }, { 0xFEFF, 0xFEFF, 0 }, { 0xFF00, 0xFF60, 2 }, { 0xFFE0, 0xFFE6, 2 },
+	{ 0x16FE0, 0x16FE4, 2 }, { 0x17000, 0x18AFF, 2 }, { 0x1B000, 0x1B2FF, 2 }, { 0x1F004, 0x1F004, 2 },
+	{ 0x1F0CF, 0x1F0CF, 2 }, { 0x1F18E, 0x1F18E, 2 }, { 0x1F191, 0x1F19A, 2 }, { 0x1F200, 0x1F202, 2 },
+	{ 0x1F210, 0x1F23B, 2 }, { 0x1F240, 0x1F248, 2 }, { 0x1F250, 0x1F251, 2 }, { 0x1F260, 0x1F265, 2 },
+	{ 0x1F300, 0x1F64F, 2 }, { 0x1F680, 0x1F6FF, 2 }, { 0x1F7E0, 0x1F7EB, 2 }, { 0x1F90C, 0x1F9FF, 2 },
+	{ 0x1FA70, 0x1FAFF, 2 }, { 0x20000, 0x2FFFD, 2 }, { 0x30000, 0x3FFFD, 2 }, { 0xE0100, 0xE01EF, 0 },
+};
+
+/**
+ * @brief Get number of terminal columns taken by character.
+ * 
+ * @param cp Code point.
+ * @return unsigned int Display width: 0, 1 or 2.
+ */
+unsigned int eddy_utf8_width(unsigned long cp)
+{
+	unsigned int low = 0;
+	unsigned int high = sizeof(eddy_utf8_ranges) / sizeof(eddy_utf8_ranges[0]);
+	unsigned int mid;
+
+	if(cp < eddy_utf8_ranges[0].first) {
+		return 1;
+	}
+
+	while(low < high) {
+		mid = (low + high) / 2;
+
+		if(cp < eddy_utf8_ranges[mid].first) {
+			high = mid;
+		} else if(cp > eddy_utf8_ranges[mid].last) {
+			low = mid + 1;
+		} else {
+			return eddy_utf8_ranges[mid].width;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * @brief Get number of terminal columns taken by text.
+ * 
+ * @param text UTF-8 encoded text.
+ * @param len Length of text.
+ * @return unsigned int Display width.
+ */
+unsigned int eddy_text_width(const char* text, unsigned int len)
+{
+	unsigned int width = 0;
+	unsigned int part;
+	unsigned int pos = 0;
+
+	while(pos < len) {
+		if((unsigned char)text[pos] < 0x80) {
+			width++;
+			pos++;
+			continue;
+		}
+
+		pos += eddy_utf8_next(text + pos, len - pos, &part);
+		width += part;
+	}
+
+	return width;
+}
+
+/**
+ * @brief Get length of ASCII characters at text start.
+ * 
+ * Text is checked by words, edited lines are mostly ASCII.
+ * 
+ * @param text Text to check.
+ * @param len Length of text.
+ * @return unsigned int Number of bytes below 0x80.
+ */
+unsigned int eddy_ascii_run(const char* text, unsigned int len)
+{
+	unsigned int pos = 0;
+	unsigned long word;
+
+	while(pos + sizeof(word) <= len) {
+		memcpy(&word, text + pos, sizeof(word));
+
+		if(word & (~0UL / 0xFF * 0x80)) {
+			break;
+		}
+		pos += sizeof(word);
+	}
+
+	while(pos < len && (unsigned char)text[pos] < 0x80) {
+		pos++;
+	}
+
+	return pos;
+}
+
+/**
+ * @brief Get cell after text printed from given cell.
+ * 
+ * Terminal moves wide character which would start in the last column to
+ * next row and leaves that column blank. The blank cell is counted too,
+ * so cells map to rows and columns by division only.
+ * 
+ * @param self Pointer on library context.
+ * @param cell Cell where text starts.
+ * @param text UTF-8 encoded text.
+ * @param len Length of text.
+ * @return unsigned int Cell after last character.
+ */
+unsigned int eddy_text_cells(eddy_p self, unsigned int cell, const char* text, unsigned int len)
+{
+	unsigned int cols = self->ctx->term_cols;
+	unsigned int part;
+	unsigned int pos = 0;
+
+	while(pos < len) {
+		part = eddy_ascii_run(text + pos, len - pos);
+		cell += part;
+		pos += part;
+
+		if(pos >= len) {
+			break;
+		}
+
+		pos += eddy_utf8_next(text + pos, len - pos, &part);
+
+		if(part == 2 && cols > 1 && cell % cols == cols - 1) {
+			cell++;
+		}
+		cell += part;
+	}
+
+	return cell;
+}
+
+/**
+ * @brief Move cursor to line end and measure line width again.
+ * 
+ * Used after whole line was replaced. Line must be contiguous.
+ * 
+ * @param self Pointer on library context.
+ */
+void eddy_line_measure(eddy_p self)
+{
+	self->ctx->line_wide = eddy_ascii_run(self->ctx->line_buffer, self->ctx->line_len) < self->ctx->line_len;
+	self->ctx->line_pos = self->ctx->line_len;
+	self->ctx->line_width = eddy_text_cells(self, self->ctx->line_start,
+		self->ctx->line_buffer, self->ctx->line_len) - self->ctx->line_start;
+	self->ctx->line_col = self->ctx->line_width;
+}
+
+/**
+ * @brief Count cells of cursor and line end again after edit.
+ * 
+ * Cells are updated by width of edited characters while line has no wide
+ * character or stays in the first row. Padding cells depend on all text
+ * before them, so in line reaching next row before or after the edit the
+ * text after cursor is measured again, and text before cursor too if
+ * cursor went back over character which may follow padding.
+ * 
+ * @param self Pointer on library context.
+ * @param reach Cells taken by line before the edit.
+ * @param moved Cursor went back over wide character or more characters.
+ */
+void eddy_line_layout(eddy_p self, unsigned int reach, int moved)
+{
+	eddy_ctx_p ctx = self->ctx;
+
+	if(!ctx->line_wide || (ctx->line_start + reach < ctx->term_cols
+		&& ctx->line_start + ctx->line_width < ctx->term_cols)) {
+		return;
+	}
+
+	if(moved) {
+		ctx->line_col = eddy_text_cells(self, ctx->line_start, ctx->line_buffer, ctx->line_pos) - ctx->line_start;
+	}
+
+	ctx->line_width = ctx->line_col;
+
+	if(ctx->line_pos < ctx->line_len) {
+		ctx->line_width = eddy_text_cells(self, ctx->line_start + ctx->line_col,
+			eddy_line_tail(self), ctx->line_len - ctx->line_pos) - ctx->line_start;
+	}
+}
+
+/**
+ * @brief Remove all characters from line buffer.
+ * 
+ * @param self Pointer on library context.
+ */
+void eddy_line_clear(eddy_p self)
+{
+	eddy_line_touch(self);
+
+	self->ctx->line_len = 0;
+	self->ctx->line_pos = 0;
+	self->ctx->line_col = 0;
+	self->ctx->line_width = 0;
+	self->ctx->line_wide = 0;
+	self->ctx->line_buffer[0] = '\0';
+#ifdef EDDY_USE_GAP_BUFFER
+	self->ctx->line_flat = 1;
+#endif
+}
+
+/**
+ * @brief Make line buffer large enough for line of given length.
+ * 
+ * Buffer grows geometrically up to line_limit. Line is copied into new
+ * buffer contiguous, staged output pointing into old buffer is flushed.
+ * 
+ * @param self Pointer on library context.
+ * @param len Number of characters which must fit into line buffer.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if line can not be so long.
+ */
+eddy_retv_t eddy_line_reserve(eddy_p self, unsigned int len)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int size = ctx->line_size;
+	char* buffer;
+
+	if(len < size) {
+		return EDDY_RETV_OK;
+	}
+
+	if(len >= ctx->line_limit) {
+		return EDDY_RETV_ERR;
+	}
+
+	while(size <= len && size < ctx->line_limit) {
+		size = (size > ctx->line_limit / 2) ? ctx->line_limit : size * 2;
+	}
+
+	buffer = eddy_malloc(size);
+
+	if(buffer == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	eddy_line_touch(self);
+	eddy_line_view(self);
+
+	memcpy(buffer, ctx->line_buffer, ctx->line_len + 1);
+
+	if(ctx->line_buffer != ctx->line_base) {
+		eddy_free(ctx->line_buffer);
+	}
+
+	ctx->line_buffer = buffer;
+	ctx->line_size = size;
+	EDDY_STAT_ADD(ctx, line_grows, 1);
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Return to base line buffer after grown line was cleared.
+ * 
+ * @param self Pointer on library context.
+ */
+void eddy_line_release(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+
+	if(ctx->line_buffer == ctx->line_base) {
+		return;
+	}
+
+	eddy_line_touch(self);
+	eddy_free(ctx->line_buffer);
+
+	ctx->line_buffer = ctx->line_base;
+	ctx->line_size = ctx->line_base_size;
+	ctx->line_buffer[0] = '\0';
+}
+
+/**
+ * @brief Pass number of characters dropped from full line to line full callback.
+ * 
+ * @param self Pointer on library context.
+ */
+void eddy_line_full_notify(eddy_p self)
+{
+	eddy_size_t dropped = self->ctx->line_drops;
+
+	if(dropped == 0) {
+		return;
+	}
+
+	self->ctx->line_drops = 0;
+
+	if(self->ctx->line_full_clbk != EDDY_NULL) {
+		self->ctx->line_full_clbk(self, dropped);
+	}
+}
+
+/**
+ * @brief Get part of line after cursor.
+ * 
+ * @param self Pointer on library context.
+ * @return const char* NUL terminated characters from cursor to end of line.
+ */
+const char* eddy_line_tail(eddy_p self)
+{
+#ifdef EDDY_USE_GAP_BUFFER
+	if(!self->ctx->line_flat) {
+		return self->ctx->line_buffer + EDDY_LINE_GAP_END(self->ctx);
+	}
+#endif
+
+	return self->ctx->line_buffer + self->ctx->line_pos;
+}
+
+/**
+ * @brief Get whole line as contiguous NUL terminated string.
+ * 
+ * With gap buffer the text after cursor is moved to close the gap,
+ * so call it only when whole line is needed (command execution, hints).
+ * 
+ * @param self Pointer on library context.
+ * @return char* Pointer on line buffer.
+ */
+char* eddy_line_view(eddy_p self)
+{
+#ifdef EDDY_USE_GAP_BUFFER
+	if(!self->ctx->line_flat) {
+		eddy_line_touch(self);
+		memmove(self->ctx->line_buffer + self->ctx->line_pos,
+			self->ctx->line_buffer + EDDY_LINE_GAP_END(self->ctx),
+			self->ctx->line_len - self->ctx->line_pos);
+		self->ctx->line_buffer[self->ctx->line_len] = '\0';
+		self->ctx->line_flat = 1;
+	}
+#endif
+
+	return self->ctx->line_buffer;
+}
+
+/**
+ * @brief Print line buffer from given position and restore cursor.
+ * 
+ * Terminal cursor is expected at from position. After printing it is
+ * moved back to current cursor position in line buffer.
+ * 
+ * @param self Pointer on library context.
+ * @param from Position in line buffer where printing starts.
+ * @param cell Cell of from position, where terminal cursor is.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_print_line_tail(eddy_p self, unsigned int from, unsigned int cell)
+{
+	eddy_retv_t error = EDDY_RETV_OK;
+
+	if(from == self->ctx->line_pos && self->ctx->line_pos == self->ctx->line_len) {
+		return EDDY_RETV_OK;
+	}
+
+	if(from < self->ctx->line_pos) {
+		error = eddy_write_line(self, cell, self->ctx->line_buffer + from, self->ctx->line_pos - from);
+	}
+
+	if(!error) {
+		error = eddy_print_line_rest(self, 0);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Print line after cursor and move cursor back.
+ * 
+ * Called when line before cursor was just printed, terminal cursor is
+ * right after it.
+ * 
+ * @param self Pointer on library context.
+ * @param clear Clear screen after the line, used when line got shorter.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_print_line_rest(eddy_p self, int clear)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int end = ctx->line_start + ctx->line_width;
+	eddy_retv_t error = EDDY_RETV_OK;
+
+	if(ctx->line_pos < ctx->line_len) {
+		error = eddy_write_line(self, ctx->line_start + ctx->line_col, eddy_line_tail(self), ctx->line_len - ctx->line_pos);
+	}
+
+	if(!error) {
+		error = eddy_print_wrap(self, end);
+	}
+
+	if(!error && clear) {
+		error = eddy_print(self, VT100_CLEAR_SCREEN_DOWN);
+	}
+
+	if(!error) {
+		error = eddy_print_cursor_goto(self, end, ctx->line_start + ctx->line_col);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Move cursor to the beginning of row below edited line.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_print_line_below(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int cell = ctx->line_start + ctx->line_col;
+	unsigned int end = ctx->line_start + ctx->line_width;
+	eddy_retv_t error = EDDY_RETV_OK;
+
+	/* row filled up to the edge was left already, see eddy_print_wrap */
+	if(end > 0 && end % ctx->term_cols == 0) {
+		return eddy_print_cursor_goto(self, cell, end);
+	}
+
+	if(end / ctx->term_cols > cell / ctx->term_cols) {
+		error = eddy_print_cursor_move(self, VT100_MOVE_CURSOR_DOWN_N,
+			end / ctx->term_cols - cell / ctx->term_cols);
+	}
+
+	if(!error) {
+		error = eddy_print(self, "\r\n");
+	}
+
+	return error;
+}
+
+/**
+ * @brief Print prompt at the beginning of terminal row.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_print_prompt(eddy_p self)
+{
+	eddy_retv_t error;
+
+	if(self->ctx->batch_mode) {
+		return EDDY_RETV_OK;
+	}
+
+	self->ctx->line_start = eddy_text_cells(self, 0, self->ctx->prompt, strlen(self->ctx->prompt));
+
+	error = eddy_print_ref(self, self->ctx->prompt);
+
+	if(!error) {
+		error = eddy_print_wrap(self, self->ctx->line_start);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Print prompt and whole line, then move cursor to its position.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_print_prompt_line(eddy_p self)
+{
+	eddy_retv_t error;
+
+	error = eddy_print_prompt(self);
+
+	if(!error) {
+		error = eddy_print_line_tail(self, 0, self->ctx->line_start);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Format unsigned number as decimal digits.
+ * 
+ * Library prints numbers itself instead of depending on printf family.
+ * Buffer is not terminated.
+ * 
+ * @param buffer Buffer for at least 20 digits.
+ * @param n Formatted number.
+ * @return unsigned int Number of digits written.
+ */
+unsigned int eddy_format_number(char* buffer, unsigned long n)
+{
+	char digits[20];
+	unsigned int cnt = 0;
+	unsigned int len = 0;
+
+	do {
+		digits[cnt++] = '0' + n % 10;
+		n /= 10;
+	} while(n > 0);
+
+	while(cnt > 0) {
+		buffer[len++] = digits[--cnt];
+	}
+
+	return len;
+}
+
+/**
+ * @brief Print cursor move escape sequence with counter.
+ * 
+ * Counter is formatted in place of %u without snprintf, cursor moves are
+ * printed for most keys.
+ * 
+ * @param self Pointer on library context.
+ * @param format One of VT100_MOVE_CURSOR_*_N sequences.
+ * @param n Number of rows or columns.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_print_cursor_move(eddy_p self, const char* format, unsigned int n)
+{
+	char buffer[EDDY_MAX_ESC_SEQ_LEN+8];
+	unsigned int len = 0;
+
+	while(*format != '%') {
+		buffer[len++] = *format++;
+	}
+
+	len += eddy_format_number(buffer + len, n);
+
+	/* skip "%u", final character follows */
+	buffer[len++] = format[2];
+
+	return eddy_write(self, buffer, len);
+}
+
+/**
+ * @brief Move terminal cursor between cells of edited line.
+ * 
+ * Cells are counted from the beginning of the row where prompt starts,
+ * line wraps at term_cols. Blank cell left before wide character moved to
+ * next row is counted (see eddy_text_cells), so row and column are given
+ * by division. Cursor is moved with relative sequences only, rows first.
+ * 
+ * @param self Pointer on library context.
+ * @param from Cell where cursor is.
+ * @param to Cell where cursor is moved.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_print_cursor_goto(eddy_p self, unsigned int from, unsigned int to)
+{
+	unsigned int cols = self->ctx->term_cols;
+	unsigned int from_col = from % cols;
+	unsigned int to_col = to % cols;
+	eddy_retv_t error = EDDY_RETV_OK;
+
+	if(from / cols > to / cols) {
+		error = eddy_print_cursor_move(self, VT100_MOVE_CURSOR_UP_N, from / cols - to / cols);
+	} else if(from / cols < to / cols) {
+		error = eddy_print_cursor_move(self, VT100_MOVE_CURSOR_DOWN_N, to / cols - from / cols);
+	}
+
+	if(error || from_col == to_col) {
+		return error;
+	}
+
+	if(to_col == 0) {
+		return eddy_print(self, "\r");
+	} else if(from_col == to_col + 1) {
+		return eddy_print(self, VT100_BACKSPACE);
+	} else if(from_col > to_col) {
+		return eddy_print_cursor_move(self, VT100_MOVE_CURSOR_LEFT_N, from_col - to_col);
+	} else if(to_col == from_col + 1) {
+		return eddy_print(self, VT100_MOVE_CURSOR_RIGHT);
+	}
+
+	return eddy_print_cursor_move(self, VT100_MOVE_CURSOR_RIGHT_N, to_col - from_col);
+}
+
+/**
+ * @brief Move cursor to next row if printing filled the row.
+ * 
+ * Terminal keeps cursor at the right edge of filled row until next
+ * character is printed. Cursor is moved to next row, so each cell has one
+ * cursor position. End counts padding cells, so it is at row boundary
+ * only when last character filled the row. Must be called only right
+ * after printing.
+ * 
+ * @param self Pointer on library context.
+ * @param end Cell after last printed character.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_print_wrap(eddy_p self, unsigned int end)
+{
+	if(end > 0 && end % self->ctx->term_cols == 0) {
+		return eddy_print(self, "\r\n");
+	}
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Proceed back space on line buffer.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_bs_key(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+	eddy_retv_t error = EDDY_RETV_OK;
+	unsigned int width;
+
+	if(ctx->line_pos > 0) {
+		width = eddy_line_delete_back(self);
+
+		error = eddy_print_cursor_goto(self, ctx->line_start + ctx->line_col + width,
+			ctx->line_start + ctx->line_col);
+
+		if(!error && ctx->line_pos < ctx->line_len) {
+			error = eddy_print_line_rest(self, 1);
+		} else if(!error) {
+			error = eddy_print(self, VT100_CLEAR_SCREEN_DOWN);
+		}
+	}
+
+	return error;
+}
+
+/**
+ * @brief Proceed delete on line buffer.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_del_key(eddy_p self)
+{
+	eddy_retv_t error = EDDY_RETV_OK;
+
+	if(self->ctx->line_pos < self->ctx->line_len) {
+		eddy_line_delete(self);
+
+		if(self->ctx->line_pos < self->ctx->line_len) {
+			error = eddy_print_line_rest(self, 1);
+		} else {
+			error = eddy_print(self, VT100_CLEAR_SCREEN_DOWN);
+		}
+	}
+
+	return error;
+}
+
+/**
+ * @brief Proceed move cursor left on line buffer.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_cursor_left(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+	eddy_retv_t error = EDDY_RETV_OK;
+	unsigned int width;
+
+	if(ctx->line_pos > 0) {
+		width = eddy_line_move_left(self);
+		error = eddy_print_cursor_goto(self, ctx->line_start + ctx->line_col + width,
+			ctx->line_start + ctx->line_col);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Proceed move cursor right on line buffer.
+ * 
+ * @param self Pointer on library context
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_cursor_right(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+	eddy_retv_t error = EDDY_RETV_OK;
+	unsigned int width;
+
+	if(ctx->line_pos < ctx->line_len) {
+		width = eddy_line_move_right(self);
+		error = eddy_print_cursor_goto(self, ctx->line_start + ctx->line_col - width,
+			ctx->line_start + ctx->line_col);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Move cursor to given position in line with single cursor jump.
+ * 
+ * @param self Pointer on library context.
+ * @param pos New cursor position.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_cursor_to(eddy_p self, unsigned int pos)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int cell = ctx->line_start + ctx->line_col;
+
+	eddy_line_seek(self, pos);
+
+	return eddy_print_cursor_goto(self, cell, ctx->line_start + ctx->line_col);
+}
+
+/**
+ * @brief Move cursor to line beginning [HOME] or [CTRL+A].
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_line_home(eddy_p self)
+{
+	return eddy_process_cursor_to(self, 0);
+}
+
+/**
+ * @brief Move cursor to line end [END] or [CTRL+E].
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_line_end(eddy_p self)
+{
+	return eddy_process_cursor_to(self, self->ctx->line_len);
+}
+
+/**
+ * @brief Move cursor to beginning of previous word [ALT+B].
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_word_left(eddy_p self)
+{
+	return eddy_process_cursor_to(self, eddy_line_word_start(self));
+}
+
+/**
+ * @brief Move cursor to end of next word [ALT+F].
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_word_right(eddy_p self)
+{
+	return eddy_process_cursor_to(self, eddy_line_word_end(self));
+}
+
+/**
+ * @brief Remove text around cursor into kill buffer and redraw line once.
+ * 
+ * @param self Pointer on library context.
+ * @param back Number of removed bytes before cursor.
+ * @param fwd Number of removed bytes after cursor.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_kill(eddy_p self, unsigned int back, unsigned int fwd)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int cell = ctx->line_start + ctx->line_col;
+	eddy_retv_t error;
+
+	if(back + fwd == 0) {
+		return EDDY_RETV_OK;
+	}
+
+	eddy_line_kill(self, back, fwd);
+
+	error = eddy_print_cursor_goto(self, cell, ctx->line_start + ctx->line_col);
+
+	if(!error && ctx->line_pos < ctx->line_len) {
+		error = eddy_print_line_rest(self, 1);
+	} else if(!error) {
+		error = eddy_print(self, VT100_CLEAR_SCREEN_DOWN);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Kill line before cursor [CTRL+U].
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_kill_start(eddy_p self)
+{
+	return eddy_process_kill(self, self->ctx->line_pos, 0);
+}
+
+/**
+ * @brief Kill line after cursor [CTRL+K].
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_kill_end(eddy_p self)
+{
+	return eddy_process_kill(self, 0, self->ctx->line_len - self->ctx->line_pos);
+}
+
+/**
+ * @brief Kill word before cursor [CTRL+W].
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_kill_word(eddy_p self)
+{
+	return eddy_process_kill(self, self->ctx->line_pos - eddy_line_word_start(self), 0);
+}
+
+/**
+ * @brief Insert content of kill buffer at cursor [CTRL+Y].
+ * 
+ * Nothing is inserted if killed text does not fit into line.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_yank(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int from = ctx->line_pos;
+	unsigned int cell = ctx->line_start + ctx->line_col;
+
+	if(ctx->kill_len == 0 || eddy_line_insert_seq(self, ctx->kill_buff, ctx->kill_len) != EDDY_RETV_OK) {
+		return EDDY_RETV_OK;
+	}
+
+	return eddy_print_line_tail(self, from, cell);
+}
+
+/**
+ * @brief Proceed [TAB] key.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_tab(eddy_p self)
+{
+	if(self->ctx->comp_trie != EDDY_NULL) {
+		return eddy_process_complete(self);
+	}
+
+	return eddy_process_check_hint(self, eddy_line_view(self));
+}
+
+/**
+ * @brief Complete word before cursor.
+ * 
+ * Word is extended with longest common prefix of its candidates and only
+ * inserted characters (and the rest of the line if cursor is not at its
+ * end) are printed. Unique complete word is followed with space. When
+ * nothing can be inserted, next [TAB] lists candidates. Words are
+ * separated with spaces, quotes are not taken into account.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_complete(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+	const eddy_trie_t* trie = ctx->comp_trie;
+	const eddy_trie_node_t* nodes;
+	const eddy_cmd_t* cmd;
+	char add[EDDY_COMPLETE_MAX_LEN];
+	unsigned int add_len = 0;
+	unsigned int start;
+	unsigned int from;
+	unsigned int cell;
+	unsigned int node;
+	unsigned int idx;
+	unsigned int len;
+	int arg = 0;
+	char* line;
+
+	line = eddy_line_view(self);
+	start = ctx->line_pos;
+
+	while(start > 0 && line[start - 1] != ' ') {
+		start--;
+	}
+
+	for(idx = 0; idx < start; idx++) {
+		if(line[idx] != ' ' && (idx == 0 || line[idx - 1] == ' ')) {
+			arg++;
+		}
+	}
+
+	if(arg > 0) {
+		for(idx = 0; line[idx] == ' '; idx++) {
+		}
+
+		len = strcspn(line + idx, " ");
+		cmd = eddy_cmd_lookup(ctx, line + idx, len);
+		trie = (cmd != EDDY_NULL && cmd->complete != EDDY_NULL) ? cmd->complete(self, arg) : EDDY_NULL;
+	}
+
+	if(trie == EDDY_NULL) {
+		return EDDY_RETV_OK;
+	}
+
+	node = eddy_trie_find(trie, line + start, ctx->line_pos - start);
+
+	if(node == 0 && start != ctx->line_pos) {
+		ctx->comp_tab = 0;
+		return EDDY_RETV_OK;
+	}
+
+	nodes = trie->nodes;
+	from = ctx->line_pos;
+	cell = ctx->line_start + ctx->line_col;
+
+	while(!nodes[node].word && nodes[node].child != 0 && nodes[nodes[node].child].sibling == 0
+		&& add_len < sizeof(add) && ctx->line_len + add_len < EDDY_LINE_MAX_SIZE(ctx) - 1) {
+		node = nodes[node].child;
+		add[add_len++] = nodes[node].c;
+	}
+
+	/* common prefix may end inside multibyte character */
+	len = eddy_utf8_partial(add, add_len);
+
+	eddy_line_insert_seq(self, add, add_len - len);
+
+	if(len > 0) {
+		node = eddy_trie_find(trie, ctx->line_buffer + start, ctx->line_pos - start);
+	}
+
+	if(nodes[node].word && nodes[node].child == 0 && ctx->line_pos == ctx->line_len) {
+		eddy_line_insert(self, ' ');
+	}
+
+	if(ctx->line_pos != from) {
+		ctx->comp_tab = 0;
+		return eddy_print_line_tail(self, from, cell);
+	}
+
+	if(!ctx->comp_tab) {
+		ctx->comp_tab = 1;
+		return EDDY_RETV_OK;
+	}
+
+	ctx->comp_tab = 0;
+
+	return eddy_complete_list(self, trie, node, start);
+}
+
+/**
+ * @brief Print candidates below edited line and redraw it.
+ * 
+ * @param self Pointer on library context.
+ * @param trie Pointer on trie of candidates.
+ * @param node Trie node of completed prefix.
+ * @param start Position of completed word in line buffer.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_complete_list(eddy_p self, const eddy_trie_t* trie, unsigned int node, unsigned int start)
+{
+	eddy_ctx_p ctx = self->ctx;
+	const eddy_trie_node_t* nodes = trie->nodes;
+	unsigned short stack[EDDY_COMPLETE_MAX_LEN];
+	unsigned int listed = 0;
+	unsigned int depth = 0;
+	unsigned int idx;
+	eddy_retv_t error;
+	char* line;
+
+	line = eddy_line_view(self);
+
+	error = eddy_print_line_below(self);
+
+	if(nodes[node].word) {
+		eddy_write(self, line + start, ctx->line_pos - start);
+		listed++;
+	}
+
+	/* depth first walk over subtree, stack keeps path below prefix */
+	node = nodes[node].child;
+
+	while(node != 0 && !error) {
+		stack[depth] = node;
+
+		if(nodes[node].word) {
+			if(listed >= EDDY_COMPLETE_MAX_LIST) {
+				error = eddy_print(self, "...");
+				break;
+			}
+
+			if(listed > 0) {
+				eddy_print(self, "  ");
+			}
+
+			error = eddy_write(self, line + start, ctx->line_pos - start);
+
+			for(idx = 0; idx <= depth && !error; idx++) {
+				error = eddy_put(self, nodes[stack[idx]].c);
+			}
+
+			listed++;
+		}
+
+		if(nodes[node].child != 0 && depth + 1 < EDDY_COMPLETE_MAX_LEN) {
+			node = nodes[node].child;
+			depth++;
+			continue;
+		}
+
+		while(nodes[node].sibling == 0 && depth > 0) {
+			node = stack[--depth];
+		}
+
+		node = nodes[node].sibling;
+	}
+
+	if(!error) {
+		error = eddy_print(self, "\r\n");
+	}
+
+	if(!error) {
+		error = eddy_print_prompt_line(self);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Find trie node of given prefix.
+ * 
+ * @param trie Pointer on trie.
+ * @param prefix Prefix characters.
+ * @param len Length of prefix.
+ * @return unsigned int Index of node or 0 if there is no word with prefix (or prefix is empty).
+ */
+unsigned int eddy_trie_find(const eddy_trie_t* trie, const char* prefix, unsigned int len)
+{
+	const eddy_trie_node_t* nodes = trie->nodes;
+	unsigned int node = 0;
+	unsigned int idx;
+
+	for(idx = 0; idx < len; idx++) {
+		node = nodes[node].child;
+
+		while(node != 0 && nodes[node].c != prefix[idx]) {
+			node = nodes[node].sibling;
+		}
+
+		if(node == 0) {
+			return 0;
+		}
+	}
+
+	return node;
+}
+
+eddy_retv_t eddy_trie_build(eddy_trie_t* trie, eddy_trie_node_t* nodes, eddy_size_t nodes_cnt,
+	const char* const* words, eddy_size_t words_cnt)
+{
+	unsigned int used = 1;
+	unsigned int node;
+	unsigned short* link;
+	eddy_size_t idx;
+	const char* c;
+
+	if(trie == EDDY_NULL || nodes == EDDY_NULL || nodes_cnt == 0 || (words == EDDY_NULL && words_cnt > 0)) {
+		return EDDY_RETV_ERR;
+	}
+
+	if(nodes_cnt > 0xFFFF) {
+		nodes_cnt = 0xFFFF;
+	}
+
+	memset(nodes, 0, sizeof(*nodes));
+
+	for(idx = 0; idx < words_cnt; idx++) {
+		node = 0;
+
+		for(c = words[idx]; *c != '\0'; c++) {
+			/* find child with character or place to insert it in order */
+			link = &nodes[node].child;
+
+			while(*link != 0 && (unsigned char)nodes[*link].c < (unsigned char)*c) {
+				link = &nodes[*link].sibling;
+			}
+
+			if(*link == 0 || nodes[*link].c != *c) {
+				if(used >= nodes_cnt) {
+					return EDDY_RETV_ERR;
+				}
+
+				nodes[used].c = *c;
+				nodes[used].child = 0;
+				nodes[used].word = 0;
+				nodes[used].sibling = *link;
+				*link = used++;
+			}
+
+			node = *link;
+		}
+
+		nodes[node].word = (node != 0);
+	}
+
+	trie->nodes = nodes;
+	trie->nodes_cnt = used;
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Function proceed hint searching.
+ * 
+ * The function is called when [TAB] is pressed. Passes
+ * the entered command through the set callback function.
+ * Callback prints hints below the line, so prompt and line are printed
+ * again after them. Quiet callback does not print, then only the part
+ * of line changed by it is printed.
+ * 
+ * Callback completes copy of the line of EDDY_MAX_LINE_BUFF_LEN bytes.
+ * Line buffer grows only if completed line does not fit into it, part
+ * which does not fit after failed growth is dropped. Longer lines are
+ * not passed to callback.
+ * 
+ * @see eddy_s#set_check_hint_clbk
+ * 
+ * @param self Pointer on library context.
+ * @param cmd_line Command line buffer to process.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_check_hint(eddy_p self, char* cmd_line)
+{
+	char hint_line[EDDY_MAX_LINE_BUFF_LEN];
+	eddy_ctx_p ctx;
+	unsigned int same = 0;
+	unsigned int len;
+
+	if(self == EDDY_NULL || self->ctx->check_hint_clbk == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	ctx = self->ctx;
+
+	if(ctx->line_len >= EDDY_MAX_LINE_BUFF_LEN) {
+		return EDDY_RETV_OK;
+	}
+
+	/* hints printed by callback follow output staged before */
+	eddy_flush_impl(self);
+
+	memcpy(hint_line, cmd_line, ctx->line_len + 1);
+
+	EDDY_STAT_ADD(ctx, hint_calls, 1);
+
+	ctx->check_hint_clbk(hint_line);
+
+	hint_line[EDDY_MAX_LINE_BUFF_LEN - 1] = '\0';
+	len = strlen(hint_line);
+
+	if(eddy_line_reserve(self, len) != EDDY_RETV_OK) {
+		EDDY_STAT_ADD(ctx, insert_drops, len - (ctx->line_size - 1));
+		ctx->line_drops += len - (ctx->line_size - 1);
+		len = ctx->line_size - 1;
+		len -= eddy_utf8_partial(hint_line, len);
+	}
+
+	while(same < len && same < ctx->line_len && ctx->line_buffer[same] == hint_line[same]) {
+		same++;
+	}
+
+	memcpy(ctx->line_buffer + same, hint_line + same, len - same);
+	ctx->line_buffer[len] = '\0';
+	ctx->line_len = len;
+	EDDY_STAT_MAX(ctx, max_line_len, ctx->line_len);
+
+	if(!ctx->hint_quiet) {
+		eddy_line_measure(self);
+		return eddy_print_prompt_line(self);
+	}
+
+	return eddy_print_line_update(self, same);
+}
+
+/**
+ * @brief Function precesses command entered in terminal.
+ * 
+ * The function is called when [ENTER] is pressed. Passes
+ * the entered command through the set callback function.
+ * 
+ * @param self Pointer on library context.
+ * @param cmd_line Command line buffer to process.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_exec_cmd(eddy_p self, char* cmd_line)
+{
+	eddy_retv_t error;
+	eddy_retv_t status;
+
+	if(self == EDDY_NULL || (self->ctx->exec_cmd_clbk == EDDY_NULL
+		&& self->ctx->cmd_table == EDDY_NULL && self->ctx->cmd_map == EDDY_NULL)) {
+		return EDDY_RETV_ERR;
+	}
+
+	error = eddy_print_line_below(self);
+
+	if(!error) {
+		error = eddy_flush_impl(self);
+	}
+
+	eddy_history_add(self, cmd_line, self->ctx->line_len);
+
+	if(error) {
+		eddy_line_clear(self);
+		return error;
+	}
+
+	EDDY_STAT_ADD(self->ctx, exec_calls, 1);
+
+	status = eddy_cmd_dispatch(self, cmd_line);
+	EDDY_RECORD_STATUS(self, EDDY_RECORD_EXEC, status);
+
+	if(status == EDDY_RETV_PENDING) {
+		/* line buffer keeps command arguments until command_done */
+		self->ctx->exec_pending = 1;
+		return EDDY_RETV_OK;
+	}
+
+	return eddy_exec_finish(self, status);
+}
+
+/**
+ * @brief Print command result and new prompt.
+ * 
+ * @param self Pointer on library context.
+ * @param status Result of command.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_exec_finish(eddy_p self, eddy_retv_t status)
+{
+	eddy_retv_t error = EDDY_RETV_OK;
+
+	if(status != EDDY_RETV_OK) {
+		error = eddy_print(self, "ERROR\r\n");
+	}
+
+	eddy_line_clear(self);
+	eddy_line_release(self);
+
+	if(!error) {
+		error = eddy_print_prompt(self);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Pass executed line to registered command or execute command callback.
+ * 
+ * First word of the line is looked up in generated command map and in
+ * registered commands. Only line of found command is split into arguments, other lines
+ * are passed to callback unchanged. Wrong number of arguments is reported
+ * with expected count. Word help lists registered commands if there is
+ * no command with this name and no callback which could have one.
+ * 
+ * @param self Pointer on library context.
+ * @param cmd_line Executed line, may be modified.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_cmd_dispatch(eddy_p self, char* cmd_line)
+{
+	eddy_ctx_p ctx = self->ctx;
+	char* argv[EDDY_MAX_ARGS + 1];
+	const eddy_cmd_t* cmd;
+	unsigned int len;
+	char* name;
+	int argc;
+
+	if(ctx->cmd_table != EDDY_NULL || ctx->cmd_map != EDDY_NULL) {
+		name = cmd_line;
+
+		while(*name == ' ' || *name == '\t') {
+			name++;
+		}
+
+		len = strcspn(name, " \t");
+		cmd = eddy_cmd_lookup(ctx, name, len);
+
+		if(cmd != EDDY_NULL) {
+			argc = eddy_split_args(name, argv, EDDY_MAX_ARGS);
+
+			if(argc <= cmd->min_args || argc > cmd->max_args + 1) {
+				eddy_cmd_usage(self, cmd);
+				return EDDY_RETV_ERR;
+			}
+
+			return cmd->handler(self, argc, argv);
+		}
+
+		if(ctx->exec_cmd_clbk == EDDY_NULL) {
+			if(len == 4 && strncmp(name, "help", 4) == 0) {
+				return eddy_cmd_help(self);
+			}
+
+			return (len == 0) ? EDDY_RETV_OK : EDDY_RETV_ERR;
+		}
+	}
+
+	return ctx->exec_cmd_clbk(cmd_line);
+}
+
+/**
+ * @brief Find registered command by name.
+ * 
+ * Generated map needs two hashes and one compare, table registered at
+ * runtime is searched with binary search.
+ * 
+ * @param ctx Pointer on library private context.
+ * @param name Command name, not NUL terminated.
+ * @param len Length of name.
+ * @return const eddy_cmd_t* Pointer on command or NULL if it is not registered.
+ */
+const eddy_cmd_t* eddy_cmd_lookup(eddy_ctx_p ctx, const char* name, unsigned int len)
+{
+	const eddy_cmd_map_t* map = ctx->cmd_map;
+	const eddy_cmd_t* cmd;
+	unsigned int low = 0;
+	unsigned int high = ctx->cmd_cnt;
+	unsigned int mid;
+	int cmp;
+
+	if(map != EDDY_NULL) {
+		mid = map->seeds[eddy_cmd_hash(name, len, 0) % map->seeds_cnt];
+		cmd = map->cmds + eddy_cmd_hash(name, len, mid) % map->cmds_cnt;
+
+		if(strncmp(name, cmd->name, len) == 0 && cmd->name[len] == '\0') {
+			return cmd;
+		}
+	}
+
+	while(low < high) {
+		mid = (low + high) / 2;
+		cmp = strncmp(name, ctx->cmd_table[mid].name, len);
+
+		if(cmp == 0 && ctx->cmd_table[mid].name[len] != '\0') {
+			cmp = -1;	/* name is prefix of longer command */
+		}
+
+		if(cmp == 0) {
+			return ctx->cmd_table + mid;
+		} else if(cmp < 0) {
+			high = mid;
+		} else {
+			low = mid + 1;
+		}
+	}
+
+	return EDDY_NULL;
+}
+
+/**
+ * @brief Print expected number of arguments of command.
+ * 
+ * @param self Pointer on library context.
+ * @param cmd Command called with wrong number of arguments.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_cmd_usage(eddy_p self, const eddy_cmd_t* cmd)
+{
+	char count[24];
+	unsigned int len;
+	eddy_retv_t error;
+
+	len = eddy_format_number(count, cmd->min_args);
+
+	if(cmd->max_args != cmd->min_args) {
+		count[len++] = '.';
+		count[len++] = '.';
+		len += eddy_format_number(count + len, cmd->max_args);
+	}
+
+	error = eddy_print(self, cmd->name);
+
+	if(!error) {
+		error = eddy_print(self, ": argument count must be ");
+	}
+
+	if(!error) {
+		error = eddy_write(self, count, len);
+	}
+
+	if(!error) {
+		error = eddy_print(self, "\r\n");
+	}
+
+	return error;
+}
+
+/**
+ * @brief Print registered commands with their descriptions.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_cmd_help(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+	eddy_retv_t error = EDDY_RETV_OK;
+	unsigned int width = 0;
+	unsigned int len;
+	unsigned int idx;
+
+	for(idx = 0; idx < ctx->cmd_cnt; idx++) {
+		len = strlen(ctx->cmd_table[idx].name);
+
+		if(len > width) {
+			width = len;
+		}
+	}
+
+	for(idx = 0; ctx->cmd_map != EDDY_NULL && idx < ctx->cmd_map->cmds_cnt; idx++) {
+		len = strlen(ctx->cmd_map->cmds[idx].name);
+
+		if(len > width) {
+			width = len;
+		}
+	}
+
+	for(idx = 0; ctx->cmd_map != EDDY_NULL && idx < ctx->cmd_map->cmds_cnt && !error; idx++) {
+		error = eddy_cmd_help_entry(self, ctx->cmd_map->cmds + idx, width);
+	}
+
+	for(idx = 0; idx < ctx->cmd_cnt && !error; idx++) {
+		error = eddy_cmd_help_entry(self, ctx->cmd_table + idx, width);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Print one line of help.
+ * 
+ * @param self Pointer on library context.
+ * @param cmd Pointer on command.
+ * @param width Width of names column.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_cmd_help_entry(eddy_p self, const eddy_cmd_t* cmd, unsigned int width)
+{
+	eddy_retv_t error;
+	unsigned int len;
+
+	error = eddy_print(self, cmd->name);
+
+	if(cmd->help != EDDY_NULL) {
+		for(len = strlen(cmd->name); len < width + 2 && !error; len++) {
+			error = eddy_put(self, ' ');
+		}
+
+		if(!error) {
+			error = eddy_print(self, cmd->help);
+		}
+	}
+
+	if(!error) {
+		error = eddy_print(self, "\r\n");
+	}
+
+	return error;
+}
+
+unsigned long eddy_cmd_hash(const char* name, unsigned int len, unsigned int seed)
+{
+	unsigned long hash = 2166136261UL ^ seed;
+	unsigned int idx;
+
+	for(idx = 0; idx < len; idx++) {
+		hash ^= (unsigned char)name[idx];
+		hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+	}
+
+	/* FNV low bits are weak, mix them before modulo by small table sizes */
+	hash ^= hash >> 16;
+	hash = (hash * 0x85EBCA6BUL) & 0xFFFFFFFFUL;
+	hash ^= hash >> 13;
+
+	return hash;
+}
+
+int eddy_split_args(char* line, char* argv[], int max_args)
+{
+	char* in = line;
+	char* out = line;
+	char quote;
+	char sep;
+	int argc = 0;
+
+	if(line == EDDY_NULL || argv == EDDY_NULL) {
+		return -1;
+	}
+
+	while(1) {
+		while(*in == ' ' || *in == '\t') {
+			in++;
+		}
+
+		if(*in == '\0') {
+			break;
+		}
+
+		if(argc >= max_args) {
+			return -1;
+		}
+
+		argv[argc++] = out;
+		quote = '\0';
+
+		/* out never passes in, so characters are moved only towards line start */
+		while(*in != '\0' && (quote != '\0' || (*in != ' ' && *in != '\t'))) {
+			if(quote != '\0' && *in == quote) {
+				quote = '\0';
+				in++;
+			} else if(quote == '\0' && (*in == '"' || *in == '\'')) {
+				quote = *in++;
+			} else if(*in == '\\' && quote != '\'' && in[1] != '\0') {
+				in++;
+				*out++ = *in++;
+			} else {
+				*out++ = *in++;
+			}
+		}
+
+		if(quote != '\0') {
+			return -1;
+		}
+
+		sep = *in;
+		*out++ = '\0';
+
+		if(sep != '\0') {
+			in++;
+		}
+	}
+
+	argv[argc] = EDDY_NULL;
+
+	return argc;
+}
+
+/**
+ * @brief Offset in history buffer moved by given number of bytes.
+ */
+#define EDDY_HIST_OFFSET(ctx, off, delta)	(((off) + (delta)) % (ctx)->hist_size)
+
+/**
+ * @brief Number of bytes from history offset from to offset to.
+ */
+#define EDDY_HIST_DISTANCE(ctx, from, to)	(((to) + (ctx)->hist_size - (from)) % (ctx)->hist_size)
+
+/**
+ * @brief Offset of text of history entry.
+ */
+#define EDDY_HIST_TEXT(ctx, off)	EDDY_HIST_OFFSET(ctx, off, EDDY_HIST_HDR_SIZE)
+
+/**
+ * @brief Copy characters between history ring buffer and linear buffer.
+ * 
+ * @param ctx Pointer on library private context.
+ * @param off Offset in history buffer.
+ * @param data Linear buffer.
+ * @param len Number of characters to copy.
+ * @param store Copy from data into history if not zero, otherwise from history into data.
+ */
+static void eddy_history_copy(eddy_ctx_p ctx, unsigned int off, char* data, unsigned int len, int store)
+{
+	unsigned int chunk = ctx->hist_size - off;
+
+	if(chunk > len) {
+		chunk = len;
+	}
+
+	if(store) {
+		memcpy(ctx->hist_buff + off, data, chunk);
+		memcpy(ctx->hist_buff, data + chunk, len - chunk);
+	} else {
+		memcpy(data, ctx->hist_buff + off, chunk);
+		memcpy(data + chunk, ctx->hist_buff, len - chunk);
+	}
+}
+
+/**
+ * @brief Read 2 bytes field (length or link) of history entry.
+ * 
+ * @param ctx Pointer on library private context.
+ * @param off Offset of the field.
+ * @return unsigned int Value of the field.
+ */
+static unsigned int eddy_history_field(eddy_ctx_p ctx, unsigned int off)
+{
+	unsigned char field[2];
+
+	eddy_history_copy(ctx, off, (char*)field, sizeof(field), 0);
+
+	return field[0] | (field[1] << 8);
+}
+
+/**
+ * @brief Write 2 bytes field (length or link) of history entry.
+ * 
+ * @param ctx Pointer on library private context.
+ * @param off Offset of the field.
+ * @param value Value of the field.
+ */
+static void eddy_history_set_field(eddy_ctx_p ctx, unsigned int off, unsigned int value)
+{
+	unsigned char field[2];
+
+	field[0] = value & 0xFF;
+	field[1] = (value >> 8) & 0xFF;
+
+	eddy_history_copy(ctx, off, (char*)field, sizeof(field), 1);
+}
+
+/**
+ * @brief Offset of the newest history entry.
+ * 
+ * @param ctx Pointer on library private context.
+ * @return unsigned int Offset of entry or EDDY_HIST_NONE if history is empty.
+ */
+static unsigned int eddy_history_newest(eddy_ctx_p ctx)
+{
+	unsigned int len;
+
+	if(ctx->hist_used == 0) {
+		return EDDY_HIST_NONE;
+	}
+
+	len = eddy_history_field(ctx, EDDY_HIST_OFFSET(ctx, ctx->hist_head, ctx->hist_size - EDDY_HIST_LEN_SIZE));
+
+	return EDDY_HIST_OFFSET(ctx, ctx->hist_head, ctx->hist_size - len - EDDY_HIST_ENTRY_OVERHEAD);
+}
+
+/**
+ * @brief Offset of history entry older than given one.
+ * 
+ * @param ctx Pointer on library private context.
+ * @param off Offset of history entry.
+ * @return unsigned int Offset of entry or EDDY_HIST_NONE if given entry is the oldest.
+ */
+static unsigned int eddy_history_prev(eddy_ctx_p ctx, unsigned int off)
+{
+	unsigned int len;
+
+	if(off == ctx->hist_tail) {
+		return EDDY_HIST_NONE;
+	}
+
+	len = eddy_history_field(ctx, EDDY_HIST_OFFSET(ctx, off, ctx->hist_size - EDDY_HIST_LEN_SIZE));
+
+	return EDDY_HIST_OFFSET(ctx, off, ctx->hist_size - len - EDDY_HIST_ENTRY_OVERHEAD);
+}
+
+/**
+ * @brief Offset of history entry newer than given one.
+ * 
+ * @param ctx Pointer on library private context.
+ * @param off Offset of history entry.
+ * @return unsigned int Offset of entry or EDDY_HIST_NONE if given entry is the newest.
+ */
+static unsigned int eddy_history_next(eddy_ctx_p ctx, unsigned int off)
+{
+	off = EDDY_HIST_OFFSET(ctx, off, eddy_history_field(ctx, off) + EDDY_HIST_ENTRY_OVERHEAD);
+
+	return (off == ctx->hist_head) ? EDDY_HIST_NONE : off;
+}
+
+#ifdef EDDY_USE_HISTORY_INDEX
+/**
+ * @brief Offset of previous history entry from the same index bucket.
+ * 
+ * @param ctx Pointer on library private context.
+ * @param off Offset of history entry.
+ * @return unsigned int Offset of entry or EDDY_HIST_NONE if there is no such entry.
+ */
+static unsigned int eddy_history_link(eddy_ctx_p ctx, unsigned int off)
+{
+	unsigned int link;
+
+	link = eddy_history_field(ctx, EDDY_HIST_OFFSET(ctx, off, EDDY_HIST_LEN_SIZE));
+
+	if(link == 0 || link > EDDY_HIST_DISTANCE(ctx, ctx->hist_tail, off)) {
+		return EDDY_HIST_NONE;
+	}
+
+	return EDDY_HIST_OFFSET(ctx, off, ctx->hist_size - link);
+}
+#endif
+
+/**
+ * @brief Check if history entry contains given text.
+ * 
+ * @param ctx Pointer on library private context.
+ * @param off Offset of history entry.
+ * @param text Text to find.
+ * @param len Length of text to find.
+ * @param anywhere Text may be placed anywhere in entry if not zero, otherwise only at its beginning.
+ * @return int Not zero if entry contains text.
+ */
+static int eddy_history_match(eddy_ctx_p ctx, unsigned int off, const char* text, unsigned int len, int anywhere)
+{
+	unsigned int entry_len = eddy_history_field(ctx, off);
+	unsigned int start;
+	unsigned int idx;
+
+	off = EDDY_HIST_TEXT(ctx, off);
+
+	for(start = 0; start + len <= entry_len; start++) {
+		for(idx = 0; idx < len; idx++) {
+			if(ctx->hist_buff[EDDY_HIST_OFFSET(ctx, off, start + idx)] != text[idx]) {
+				break;
+			}
+		}
+
+		if(idx == len) {
+			return 1;
+		}
+
+		if(!anywhere) {
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Store command in history.
+ * 
+ * Empty commands and commands equal to the newest entry are not stored.
+ * 
+ * @param self Pointer on library context.
+ * @param line Command text.
+ * @param len Length of command text.
+ */
+void eddy_history_add(eddy_p self, const char* line, unsigned int len)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int need = EDDY_HIST_ENTRY_SIZE(len);
+	unsigned int off;
+#ifdef EDDY_USE_HISTORY_INDEX
+	unsigned int bucket;
+	unsigned int link;
+#endif
+
+	ctx->hist_recall = 0;
+
+	if(ctx->hist_buff == EDDY_NULL || len == 0 || need > ctx->hist_size) {
+		return;
+	}
+
+	off = eddy_history_newest(ctx);
+
+	if(off != EDDY_HIST_NONE && eddy_history_field(ctx, off) == len
+		&& eddy_history_match(ctx, off, line, len, 0)) {
+		return;
+	}
+
+	while(ctx->hist_size - ctx->hist_used < need) {
+#ifdef EDDY_USE_HISTORY_INDEX
+		bucket = EDDY_HIST_BUCKET(ctx->hist_buff[EDDY_HIST_TEXT(ctx, ctx->hist_tail)]);
+
+		if(ctx->hist_index[bucket] == ctx->hist_tail) {
+			ctx->hist_index[bucket] = EDDY_HIST_NONE;
+		}
+#endif
+		off = eddy_history_field(ctx, ctx->hist_tail) + EDDY_HIST_ENTRY_OVERHEAD;
+		ctx->hist_tail = EDDY_HIST_OFFSET(ctx, ctx->hist_tail, off);
+		ctx->hist_used -= off;
+	}
+
+	off = ctx->hist_head;
+	eddy_history_set_field(ctx, off, len);
+
+#ifdef EDDY_USE_HISTORY_INDEX
+	bucket = EDDY_HIST_BUCKET(line[0]);
+	link = 0;
+
+	if(ctx->hist_index[bucket] != EDDY_HIST_NONE) {
+		link = EDDY_HIST_DISTANCE(ctx, ctx->hist_index[bucket], off);
+
+		if(link > 0xFFFF) {
+			link = 0;
+		}
+	}
+
+	eddy_history_set_field(ctx, EDDY_HIST_OFFSET(ctx, off, EDDY_HIST_LEN_SIZE), link);
+	ctx->hist_index[bucket] = off;
+#endif
+
+	eddy_history_copy(ctx, EDDY_HIST_TEXT(ctx, off), (char*)line, len, 1);
+	eddy_history_set_field(ctx, EDDY_HIST_OFFSET(ctx, off, need - EDDY_HIST_LEN_SIZE), len);
+
+	ctx->hist_head = EDDY_HIST_OFFSET(ctx, off, need);
+	ctx->hist_used += need;
+}
+
+/**
+ * @brief Load history entry into line buffer without printing.
+ * 
+ * @param self Pointer on library context.
+ * @param off Offset of history entry.
+ * @return unsigned int Number of characters at line beginning which were not changed.
+ */
+static unsigned int eddy_history_load(eddy_p self, unsigned int off)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int same = 0;
+	unsigned int len;
+	char* line;
+
+	len = eddy_history_field(ctx, off);
+
+	if(eddy_line_reserve(self, len) != EDDY_RETV_OK) {
+		len = ctx->line_size - 1;
+	}
+
+	ctx->hist_pos = off;
+	ctx->hist_recall = 1;
+
+	off = EDDY_HIST_TEXT(ctx, off);
+	line = eddy_line_view(self);
+
+	while(same < len && same < ctx->line_len && line[same] == ctx->hist_buff[EDDY_HIST_OFFSET(ctx, off, same)]) {
+		same++;
+	}
+
+	eddy_line_touch(self);
+
+	eddy_history_copy(ctx, EDDY_HIST_OFFSET(ctx, off, same), line + same, len - same, 0);
+	line[len] = '\0';
+	ctx->line_len = len;
+	EDDY_STAT_MAX(ctx, max_line_len, len);
+
+	return same;
+}
+
+/**
+ * @brief Replace edited line with recalled history entry.
+ * 
+ * @param self Pointer on library context.
+ * @param off Offset of history entry.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+static eddy_retv_t eddy_history_recall(eddy_p self, unsigned int off)
+{
+	unsigned int same;
+
+	same = eddy_history_load(self, off);
+
+	return eddy_print_line_update(self, same);
+}
+
+/**
+ * @brief Recall previous (older) command from history.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_history_prev(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int off;
+
+	off = ctx->hist_recall ? eddy_history_prev(ctx, ctx->hist_pos) : eddy_history_newest(ctx);
+
+	if(off == EDDY_HIST_NONE) {
+		return EDDY_RETV_OK;
+	}
+
+	return eddy_history_recall(self, off);
+}
+
+/**
+ * @brief Recall next (newer) command from history.
+ * 
+ * Moving past the newest command clears the line.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_history_next(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int off;
+
+	if(!ctx->hist_recall) {
+		return EDDY_RETV_OK;
+	}
+
+	off = eddy_history_next(ctx, ctx->hist_pos);
+
+	if(off == EDDY_HIST_NONE) {
+		ctx->hist_recall = 0;
+		return eddy_line_replace(self, "", 0);
+	}
+
+	return eddy_history_recall(self, off);
+}
+
+/**
+ * @brief Older history entry visited by prefix scan.
+ * 
+ * With EDDY_USE_HISTORY_INDEX only entries from the index bucket of
+ * the first prefix character are visited.
+ * 
+ * @param ctx Pointer on library private context.
+ * @param off Offset of current entry or EDDY_HIST_NONE to get the first visited entry.
+ * @param prefix Prefix text.
+ * @param len Length of prefix.
+ * @return unsigned int Offset of older entry or EDDY_HIST_NONE.
+ */
+static unsigned int eddy_history_prefix_step(eddy_ctx_p ctx, unsigned int off, const char* prefix, unsigned int len)
+{
+#ifdef EDDY_USE_HISTORY_INDEX
+	if(len > 0) {
+		return (off == EDDY_HIST_NONE) ? ctx->hist_index[EDDY_HIST_BUCKET(prefix[0])] : eddy_history_link(ctx, off);
+	}
+#else
+	(void)prefix;
+	(void)len;
+#endif
+
+	return (off == EDDY_HIST_NONE) ? eddy_history_newest(ctx) : eddy_history_prev(ctx, off);
+}
+
+/**
+ * @brief Find older history entry starting with given prefix.
+ * 
+ * At most EDDY_HIST_SEARCH_STEPS entries are checked. Entry where
+ * scanning stopped is kept in hist_prefix_scan, so it can be continued
+ * by next [PAGE UP].
+ * 
+ * @param ctx Pointer on library private context.
+ * @param off Offset of the first entry to check.
+ * @param prefix Prefix text.
+ * @param len Length of prefix.
+ * @return unsigned int Offset of found entry or EDDY_HIST_NONE.
+ */
+static unsigned int eddy_history_prefix_older(eddy_ctx_p ctx, unsigned int off, const char* prefix, unsigned int len)
+{
+	unsigned int steps;
+
+	ctx->hist_prefix_older = 1;
+
+	for(steps = 0; off != EDDY_HIST_NONE && steps < EDDY_HIST_SEARCH_STEPS; steps++) {
+		if(eddy_history_match(ctx, off, prefix, len, 0)) {
+			ctx->hist_prefix_scan = EDDY_HIST_NONE;
+			return off;
+		}
+
+		off = eddy_history_prefix_step(ctx, off, prefix, len);
+	}
+
+	ctx->hist_prefix_scan = off;
+
+	return EDDY_HIST_NONE;
+}
+
+/**
+ * @brief Find newer history entry starting with given prefix.
+ * 
+ * Scan is limited as in eddy_history_prefix_older and continued by
+ * next [PAGE DOWN].
+ * 
+ * @param ctx Pointer on library private context.
+ * @param off Offset of the first entry to check.
+ * @param prefix Prefix text.
+ * @param len Length of prefix.
+ * @return unsigned int Offset of found entry or EDDY_HIST_NONE.
+ */
+static unsigned int eddy_history_prefix_newer(eddy_ctx_p ctx, unsigned int off, const char* prefix, unsigned int len)
+{
+	unsigned int steps;
+
+	ctx->hist_prefix_older = 0;
+
+	for(steps = 0; off != EDDY_HIST_NONE && steps < EDDY_HIST_SEARCH_STEPS; steps++) {
+		if(eddy_history_match(ctx, off, prefix, len, 0)) {
+			ctx->hist_prefix_scan = EDDY_HIST_NONE;
+			return off;
+		}
+
+		off = eddy_history_next(ctx, off);
+	}
+
+	ctx->hist_prefix_scan = off;
+
+	return EDDY_HIST_NONE;
+}
+
+/**
+ * @brief Recall older command starting with text before cursor [PAGE UP].
+ * 
+ * Text before cursor at first key press is used as prefix for all
+ * following [PAGE UP] and [PAGE DOWN] presses.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_history_prefix_prev(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int off;
+	char* line;
+
+	if(ctx->hist_used == 0) {
+		return EDDY_RETV_OK;
+	}
+
+	if(ctx->hist_search != EDDY_HIST_SEARCH_PREFIX) {
+		ctx->hist_search = EDDY_HIST_SEARCH_PREFIX;
+		ctx->hist_prefix_len = ctx->line_pos;
+		ctx->hist_prefix_scan = EDDY_HIST_NONE;
+		ctx->hist_recall = 0;
+	}
+
+	line = eddy_line_view(self);
+
+	if(ctx->hist_prefix_scan != EDDY_HIST_NONE && ctx->hist_prefix_older) {
+		off = ctx->hist_prefix_scan;
+	} else {
+		off = eddy_history_prefix_step(ctx, ctx->hist_recall ? ctx->hist_pos : EDDY_HIST_NONE, line, ctx->hist_prefix_len);
+	}
+
+	off = eddy_history_prefix_older(ctx, off, line, ctx->hist_prefix_len);
+
+	if(off == EDDY_HIST_NONE) {
+		return EDDY_RETV_OK;
+	}
+
+	return eddy_history_recall(self, off);
+}
+
+/**
+ * @brief Recall newer command starting with the same prefix [PAGE DOWN].
+ * 
+ * Moving past the newest matching command leaves only the prefix in line.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_history_prefix_next(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int off;
+	char* line;
+
+	if(ctx->hist_search != EDDY_HIST_SEARCH_PREFIX || !ctx->hist_recall) {
+		return EDDY_RETV_OK;
+	}
+
+	line = eddy_line_view(self);
+
+	if(ctx->hist_prefix_scan != EDDY_HIST_NONE && !ctx->hist_prefix_older) {
+		off = ctx->hist_prefix_scan;
+	} else {
+		off = eddy_history_next(ctx, ctx->hist_pos);
+	}
+
+	off = eddy_history_prefix_newer(ctx, off, line, ctx->hist_prefix_len);
+
+	if(ctx->hist_prefix_scan != EDDY_HIST_NONE) {
+		return EDDY_RETV_OK;
+	}
+
+	if(off == EDDY_HIST_NONE) {
+		ctx->hist_recall = 0;
+		return eddy_line_replace(self, line, ctx->hist_prefix_len);
+	}
+
+	return eddy_history_recall(self, off);
+}
+
+/**
+ * @brief Scan history for entries containing reverse search query.
+ * 
+ * At most EDDY_HIST_SEARCH_STEPS entries are checked. Position where
+ * scanning stopped is kept in search_scan, so it can be continued.
+ * 
+ * @param ctx Pointer on library private context.
+ * @param off Offset of the first entry to check.
+ * @return unsigned int Offset of found entry or EDDY_HIST_NONE.
+ */
+static unsigned int eddy_search_scan(eddy_ctx_p ctx, unsigned int off)
+{
+	unsigned int steps;
+
+	for(steps = 0; off != EDDY_HIST_NONE && steps < EDDY_HIST_SEARCH_STEPS; steps++) {
+		if(eddy_history_match(ctx, off, ctx->search_query, ctx->search_len, 1)) {
+			ctx->search_scan = off;
+			return off;
+		}
+
+		off = eddy_history_prev(ctx, off);
+	}
+
+	ctx->search_scan = off;
+
+	return EDDY_HIST_NONE;
+}
+
+/**
+ * @brief Print reverse search state in place of prompt and line.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+static eddy_retv_t eddy_search_print(eddy_p self)
+{
+	eddy_retv_t error;
+
+	error = eddy_print_cursor_goto(self, self->ctx->line_start + self->ctx->line_col, 0);
+
+	if(!error) {
+		error = eddy_search_draw(self);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Print reverse search state from the beginning of terminal row.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+static eddy_retv_t eddy_search_draw(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+	const char* label = "(reverse-i-search)`";
+	eddy_retv_t error;
+
+	if(ctx->search_len > 0 && ctx->search_match[ctx->search_len] == EDDY_HIST_NONE) {
+		label = "(failing reverse-i-search)`";
+	}
+
+	error = eddy_print(self, label);
+
+	if(!error) {
+		error = eddy_write(self, ctx->search_query, ctx->search_len);
+	}
+
+	if(!error) {
+		error = eddy_print(self, "': ");
+	}
+
+	if(!error) {
+		error = eddy_write_ref(self, eddy_line_view(self), ctx->line_len);
+	}
+
+	ctx->line_start = strlen(label) + eddy_text_width(ctx->search_query, ctx->search_len) + 3;
+	eddy_line_measure(self);
+
+	if(!error) {
+		error = eddy_print_wrap(self, ctx->line_start + ctx->line_width);
+	}
+
+	if(!error) {
+		error = eddy_print(self, VT100_CLEAR_SCREEN_DOWN);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Start incremental reverse history search [CTRL+R].
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_search_start(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+
+	if(ctx->hist_buff == EDDY_NULL) {
+		return EDDY_RETV_OK;
+	}
+
+	ctx->hist_search = EDDY_HIST_SEARCH_REVERSE;
+	ctx->search_len = 0;
+	ctx->search_match[0] = EDDY_HIST_NONE;
+	ctx->search_scan = eddy_history_newest(ctx);
+
+	return eddy_search_print(self);
+}
+
+/**
+ * @brief Check if character is handled by reverse history search.
+ * 
+ * @param self Pointer on library context.
+ * @param c Character passed from terminal.
+ * @return int Not zero if character is handled by search.
+ */
+int eddy_search_consumes(eddy_p self, char c)
+{
+	return (unsigned char)c >= 0x20 || c == EDDY_CTRL_KEY('R') || c == EDDY_CTRL_KEY('G')
+		|| c == self->ctx->keys_codes.bs_key || c == self->ctx->keys_codes.del_key;
+}
+
+/**
+ * @brief Process character in reverse history search mode.
+ * 
+ * Growing query continues from current match, because newer entries
+ * did not contain shorter query. Removing query character restores
+ * match found for shorter query.
+ * 
+ * @param self Pointer on library context.
+ * @param c Character passed from terminal.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_process_search_char(eddy_p self, char c)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int off;
+	unsigned int len;
+
+	if(c == EDDY_CTRL_KEY('G')) {
+		/* cursor is taken to the beginning of the line, which is cleared */
+		if(eddy_print_cursor_goto(self, ctx->line_start + ctx->line_col, ctx->line_start) != EDDY_RETV_OK) {
+			return EDDY_RETV_ERR;
+		}
+
+		eddy_line_clear(self);
+		return eddy_search_exit(self);
+	}
+
+	if(c == self->ctx->keys_codes.bs_key || c == self->ctx->keys_codes.del_key) {
+		if(ctx->search_len == 0) {
+			return EDDY_RETV_OK;
+		}
+
+		/* whole multibyte character is removed from query */
+		do {
+			ctx->search_len--;
+		} while(ctx->search_len > 0 && EDDY_UTF8_CONT(ctx->search_query[ctx->search_len]));
+
+		off = ctx->search_match[ctx->search_len];
+
+		if(off != EDDY_HIST_NONE) {
+			eddy_history_load(self, off);
+			ctx->search_scan = off;
+		} else {
+			ctx->search_scan = eddy_history_newest(ctx);
+		}
+
+		return eddy_search_print(self);
+	}
+
+	if(c == EDDY_CTRL_KEY('R')) {
+		off = ctx->search_scan;
+
+		if(ctx->search_match[ctx->search_len] != EDDY_HIST_NONE && off != EDDY_HIST_NONE) {
+			off = eddy_history_prev(ctx, off);
+		}
+	} else {
+		/* multibyte character is added only if it fits whole */
+		if(EDDY_UTF8_CONT(c)) {
+			len = (eddy_utf8_partial(ctx->search_query, ctx->search_len) > 0) ? 1 : 0;
+		} else {
+			len = eddy_utf8_seq_len(c);
+		}
+
+		if(len == 0 || ctx->search_len + len > EDDY_HIST_SEARCH_LEN) {
+			return EDDY_RETV_OK;
+		}
+
+		ctx->search_query[ctx->search_len++] = c;
+		off = ctx->search_scan;
+	}
+
+	off = eddy_search_scan(ctx, off);
+	ctx->search_match[ctx->search_len] = off;
+
+	/* query and found line are printed when last query character is complete */
+	if(eddy_utf8_partial(ctx->search_query, ctx->search_len) > 0) {
+		return EDDY_RETV_OK;
+	}
+
+	if(off != EDDY_HIST_NONE) {
+		eddy_history_load(self, off);
+	}
+
+	return eddy_search_print(self);
+}
+
+/**
+ * @brief Leave reverse history search and show prompt with found line.
+ * 
+ * @param self Pointer on library context.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_search_exit(eddy_p self)
+{
+	eddy_ctx_p ctx = self->ctx;
+	eddy_retv_t error;
+
+	ctx->hist_search = EDDY_HIST_SEARCH_NONE;
+
+	error = eddy_print_cursor_goto(self, ctx->line_start + ctx->line_col, 0);
+
+	if(!error) {
+		error = eddy_print_prompt(self);
+	}
+
+	if(!error && ctx->line_len > 0) {
+		error = eddy_write_line(self, ctx->line_start, eddy_line_view(self), ctx->line_len);
+	}
+
+	eddy_line_measure(self);
+
+	if(!error && ctx->line_len > 0) {
+		error = eddy_print_wrap(self, ctx->line_start + ctx->line_width);
+	}
+
+	if(!error) {
+		error = eddy_print(self, VT100_CLEAR_SCREEN_DOWN);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Replace whole edited line and update terminal.
+ * 
+ * @param self Pointer on library context.
+ * @param text New line text.
+ * @param len Length of new line text.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_line_replace(eddy_p self, const char* text, unsigned int len)
+{
+	eddy_ctx_p ctx = self->ctx;
+	unsigned int old_len = ctx->line_len;
+	unsigned int same = 0;
+	char* line;
+
+	line = eddy_line_view(self);
+
+	while(same < len && same < old_len && line[same] == text[same]) {
+		same++;
+	}
+
+	eddy_line_touch(self);
+
+	memcpy(line + same, text + same, len - same);
+	line[len] = '\0';
+	ctx->line_len = len;
+
+	return eddy_print_line_update(self, same);
+}
+
+/**
+ * @brief Update terminal after line buffer was changed from given position.
+ * 
+ * Terminal shows old line with cursor at line_col. Line must be contiguous
+ * (see eddy_line_view) with new length already set. Unchanged beginning of
+ * the line is skipped with relative cursor move, rest of the line is
+ * printed and old characters are cleared only if the line shrank. Cursor
+ * is placed at the end of the line and cached columns are measured again.
+ * 
+ * @param self Pointer on library context.
+ * @param from Position of first changed byte.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_print_line_update(eddy_p self, unsigned int from)
+{
+	eddy_ctx_p ctx = self->ctx;
+	eddy_retv_t error = EDDY_RETV_OK;
+	unsigned int from_col;
+	unsigned int width;
+
+	/* changed byte may be inside multibyte character */
+	while(from > 0 && EDDY_UTF8_CONT(ctx->line_buffer[from])) {
+		from--;
+	}
+
+	ctx->line_wide = eddy_ascii_run(ctx->line_buffer, ctx->line_len) < ctx->line_len;
+	from_col = eddy_text_cells(self, ctx->line_start, ctx->line_buffer, from) - ctx->line_start;
+
+	error = eddy_print_cursor_goto(self, ctx->line_start + ctx->line_col, ctx->line_start + from_col);
+
+	width = eddy_text_cells(self, ctx->line_start + from_col, ctx->line_buffer + from, ctx->line_len - from) - ctx->line_start;
+	ctx->line_pos = ctx->line_len;
+
+	if(!error && from < ctx->line_len) {
+		error = eddy_write_line(self, ctx->line_start + from_col, ctx->line_buffer + from, ctx->line_len - from);
+
+		if(!error) {
+			error = eddy_print_wrap(self, ctx->line_start + width);
+		}
+	}
+
+	if(!error && width < ctx->line_width) {
+		error = eddy_print(self, VT100_CLEAR_SCREEN_DOWN);
+	}
+
+	ctx->line_col = width;
+	ctx->line_width = width;
+
+	return error;
+}
+
+/**
+ * @brief Function to print string in terminal.
+ * 
+ * @param self Pointer on library context.
+ * @param buffer Pointer on buffer to print.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_print(eddy_p self, const char* buffer)
+{
+	return eddy_write(self, buffer, strlen(buffer));
+}
+
+/**
+ * @brief Function to print string in terminal without copying.
+ * 
+ * @see eddy_write_ref
+ * 
+ * @param self Pointer on library context.
+ * @param buffer Pointer on buffer to print.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_print_ref(eddy_p self, const char* buffer)
+{
+	return eddy_write_ref(self, buffer, strlen(buffer));
+}
+
+/**
+ * @brief Print part of edited line which starts at given cell.
+ * 
+ * Blank cell left before wide character moved to next row is printed as
+ * space, so it does not keep character shown there before.
+ * 
+ * @param self Pointer on library context.
+ * @param cell Cell where terminal cursor is.
+ * @param text UTF-8 encoded text.
+ * @param len Length of text.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_write_line(eddy_p self, unsigned int cell, const char* text, unsigned int len)
+{
+	unsigned int cols = self->ctx->term_cols;
+	eddy_retv_t error = EDDY_RETV_OK;
+	unsigned int start = 0;
+	unsigned int pos = 0;
+	unsigned int part;
+	unsigned int seq;
+
+	/* text without wide character or which ends in the same row has no padding */
+	if(!self->ctx->line_wide || cell % cols + len < cols) {
+		return eddy_write_ref(self, text, len);
+	}
+
+	while(pos < len && !error) {
+		seq = eddy_ascii_run(text + pos, len - pos);
+		cell += seq;
+		pos += seq;
+
+		if(pos >= len) {
+			break;
+		}
+
+		seq = eddy_utf8_next(text + pos, len - pos, &part);
+
+		if(part == 2 && cols > 1 && cell % cols == cols - 1) {
+			error = eddy_write_ref(self, text + start, pos - start);
+
+			if(!error) {
+				error = eddy_write(self, " ", 1);
+			}
+
+			start = pos;
+			cell++;
+		}
+
+		cell += part;
+		pos += seq;
+	}
+
+	if(!error) {
+		error = eddy_write_ref(self, text + start, len - start);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Function to append output segment pointing on caller's characters.
+ * 
+ * Used for line buffer and prompt. With scatter-gather print callback the
+ * characters are not copied, so they must not change until flush.
+ * With terminal printing callback characters are copied as by eddy_write.
+ * 
+ * @param self Pointer on library context.
+ * @param buffer Pointer on characters to print.
+ * @param len Number of characters to print.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_write_ref(eddy_p self, const char* buffer, eddy_size_t len)
+{
+	eddy_ctx_p ctx;
+	eddy_segment_t* seg;
+
+	if(self == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	ctx = self->ctx;
+
+	if(ctx->cli_write_clbk == EDDY_NULL) {
+		return eddy_write(self, buffer, len);
+	}
+
+	if(len == 0) {
+		return EDDY_RETV_OK;
+	}
+
+	seg = (ctx->out_segs_cnt > 0) ? ctx->out_segs + ctx->out_segs_cnt - 1 : EDDY_NULL;
+
+	if(seg != EDDY_NULL && seg->data + seg->len == buffer) {
+		seg->len += len;
+	} else {
+		if(ctx->out_segs_cnt >= EDDY_OUT_MAX_SEGMENTS) {
+			eddy_flush_impl(self);
+		}
+
+		seg = ctx->out_segs + ctx->out_segs_cnt++;
+		seg->data = buffer;
+		seg->len = len;
+	}
+
+	if(buffer >= ctx->line_buffer && buffer < ctx->line_buffer + ctx->line_size) {
+		ctx->out_refs = 1;
+	}
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Function to append characters to output staging buffer.
+ * 
+ * Buffer is flushed when its fill level reaches EDDY_OUT_BUFF_HIGH_WATER.
+ * 
+ * @param self Pointer on library context.
+ * @param buffer Pointer on characters to print.
+ * @param len Number of characters to print.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_write(eddy_p self, const char* buffer, eddy_size_t len)
+{
+	eddy_ctx_p ctx;
+	eddy_segment_t* seg;
+	eddy_size_t chunk;
+
+	if(self == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	ctx = self->ctx;
+
+	if(ctx->cli_print_clbk == EDDY_NULL && ctx->cli_write_clbk == EDDY_NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	while(len > 0) {
+		chunk = EDDY_OUT_BUFF_LEN - ctx->out_len;
+
+		if(chunk > len) {
+			chunk = len;
+		}
+
+		if(ctx->cli_write_clbk != EDDY_NULL) {
+			seg = (ctx->out_segs_cnt > 0) ? ctx->out_segs + ctx->out_segs_cnt - 1 : EDDY_NULL;
+
+			if(seg == EDDY_NULL || seg->data + seg->len != ctx->out_buff + ctx->out_len) {
+				if(ctx->out_segs_cnt >= EDDY_OUT_MAX_SEGMENTS) {
+					eddy_flush_impl(self);
+				}
+
+				seg = ctx->out_segs + ctx->out_segs_cnt++;
+				seg->data = ctx->out_buff + ctx->out_len;
+				seg->len = 0;
+			}
+
+			seg->len += chunk;
+		}
+
+		memcpy(ctx->out_buff + ctx->out_len, buffer, chunk);
+		ctx->out_len += chunk;
+		buffer += chunk;
+		len -= chunk;
+
+		if(ctx->out_len >= EDDY_OUT_BUFF_HIGH_WATER) {
+			eddy_flush_impl(self);
+		}
+	}
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Function called before line buffer is modified.
+ * 
+ * Output segments still pointing into line buffer are flushed, so the
+ * terminal receives characters as they were when printed.
+ * 
+ * @param self Pointer on library context.
+ */
+void eddy_line_touch(eddy_p self)
+{
+	if(self->ctx->out_refs) {
+		eddy_flush_impl(self);
+	}
+}
+
+/**
+ * @brief Function to print single character in terminal.
+ * 
+ * @param self Pointer on library context.
+ * @param ch Character to print.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_put(eddy_p self, char ch)
+{
+	return eddy_write(self, &ch, 1);
 }
 
 /**
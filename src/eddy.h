@@ -15,19 +15,240 @@
 #include <stddef.h>
 
 /**
- * @brief Size of line buffer
+ * @brief Default size up to which line buffer grows
  * 
+ * Longer lines need buffer given with set_line_buff or larger limit set
+ * with set_line_limit.
  */
 #ifndef EDDY_MAX_LINE_BUFF_LEN
 #define EDDY_MAX_LINE_BUFF_LEN	256
 #endif
 
+/**
+ * @brief Size of line buffer inside context
+ * 
+ * Short lines stay in context, longer ones are moved into allocated buffer
+ * up to line limit.
+ */
+#ifndef EDDY_LINE_STORE_LEN
+#define EDDY_LINE_STORE_LEN	64
+#endif
+
+/**
+ * @brief Shared table of API functions [optional]
+ * 
+ * When defined, eddy_t holds only pointer on private context and pointer
+ * on eddy_ops table, API is called through it:
+ * 
+ *     eddy.ops->put_chars(&eddy, buf, len);
+ * 
+ * Saves one pointer per API function in every eddy_t. Call through ops
+ * works also when it is not defined.
+ */
+//#define EDDY_USE_SHARED_OPS
+
+/**
+ * @brief Gap buffer line storage [optional]
+ * 
+ * When defined, text after cursor is kept at the end of line buffer, so
+ * insert and delete at cursor do not move the rest of the line. Whole line
+ * is made contiguous only when it is passed to hint or execute callback.
+ * Useful with large EDDY_MAX_LINE_BUFF_LEN.
+ */
+//#define EDDY_USE_GAP_BUFFER
+
+/**
+ * @brief Runtime statistics [optional]
+ * 
+ * When defined, each context counts input and output bytes, callback calls
+ * and decoder events, see eddy_stats_t. Without it counters are not
+ * compiled in and get_stats returns error.
+ */
+//#define EDDY_USE_STATS
+
+/**
+ * @brief History prefix index [optional]
+ * 
+ * When defined, each history entry is linked with previous entry starting
+ * with character from the same index bucket, so [PAGE UP] prefix search
+ * visits only those entries. Costs 2 bytes of history buffer per entry.
+ */
+//#define EDDY_USE_HISTORY_INDEX
+
+/**
+ * @brief Log message queue [optional]
+ * 
+ * When defined, put_log can be called from other threads or interrupts.
+ * Messages are stored in lock-free queue and printed by editor thread
+ * above the edited line, which is redrawn once per drain. Requires C11
+ * atomics, lock-free only where atomic_uint is lock-free.
+ */
+//#define EDDY_USE_LOG_QUEUE
+
+/**
+ * @brief Input and output recorder [optional]
+ * 
+ * When defined, callback set with set_recorder_clbk receives every input
+ * chunk, output segment and command status of the context, so session can
+ * be stored and replayed later, see tools/eddy_trace.h. Without it
+ * set_recorder_clbk returns error.
+ */
+//#define EDDY_USE_RECORDER
+
+/**
+ * @brief Number of log queue slots, must be power of 2
+ */
+#ifndef EDDY_LOG_SLOTS
+#define EDDY_LOG_SLOTS	16
+#endif
+
+/**
+ * @brief Size of log queue slot, longer messages are truncated
+ */
+#ifndef EDDY_LOG_MSG_LEN
+#define EDDY_LOG_MSG_LEN	80
+#endif
+
+/**
+ * @brief Number of history prefix index buckets
+ */
+#ifndef EDDY_HIST_INDEX_BUCKETS
+#define EDDY_HIST_INDEX_BUCKETS	16
+#endif
+
+/**
+ * @brief Maximal length of reverse history search query
+ */
+#ifndef EDDY_HIST_SEARCH_LEN
+#define EDDY_HIST_SEARCH_LEN	16
+#endif
+
+/**
+ * @brief Maximal number of history entries checked by history search per key
+ * 
+ * When limit is reached reverse search is reported as failing and next
+ * [CTRL+R] continues from the place where it stopped. [PAGE UP/DOWN]
+ * leaves the line unchanged and next press of the same key continues.
+ */
+#ifndef EDDY_HIST_SEARCH_STEPS
+#define EDDY_HIST_SEARCH_STEPS	64
+#endif
+
+/**
+ * @{ \name Layout of history buffer entry.
+ * 
+ * Each entry is stored as length, index link, text and length again, so
+ * history buffer of size bytes holds entries whose EDDY_HIST_ENTRY_SIZE
+ * sum is at most size.
+ */
+#define EDDY_HIST_LEN_SIZE			2	/**< Lenght of history entry length field. */
+#ifdef EDDY_USE_HISTORY_INDEX
+#define EDDY_HIST_LINK_SIZE			2	/**< Lenght of history entry index link field. */
+#else
+#define EDDY_HIST_LINK_SIZE			0
+#endif
+#define EDDY_HIST_HDR_SIZE			(EDDY_HIST_LEN_SIZE + EDDY_HIST_LINK_SIZE)	/**< History entry header size. */
+#define EDDY_HIST_ENTRY_OVERHEAD	(EDDY_HIST_HDR_SIZE + EDDY_HIST_LEN_SIZE)	/**< History entry header and trailer size. */
+#define EDDY_HIST_ENTRY_SIZE(len)	((len) + EDDY_HIST_ENTRY_OVERHEAD)	/**< History buffer bytes taken by entry of len characters. */
+/**
+ * @}
+ */
+
+/**
+ * @brief Size of cache line
+ * 
+ * Private context is placed at cache line boundary, fields used by every
+ * key fit into its first cache line.
+ */
+#ifndef EDDY_CACHE_LINE
+#define EDDY_CACHE_LINE	64
+#endif
+
+/**
+ * @brief Terminal width used until set_term_width or query_term_width
+ */
+#ifndef EDDY_TERM_WIDTH
+#define EDDY_TERM_WIDTH	80
+#endif
+
+/**
+ * @brief Maximal number of arguments of registered command including its name
+ */
+#ifndef EDDY_MAX_ARGS
+#define EDDY_MAX_ARGS	16
+#endif
+
+/**
+ * @brief Maximal number of candidates listed on double [TAB]
+ */
+#ifndef EDDY_COMPLETE_MAX_LIST
+#define EDDY_COMPLETE_MAX_LIST	64
+#endif
+
+/**
+ * @brief Maximal length of completion candidate
+ * 
+ * Bounds buffers on stack used by completion. Longer common prefix is
+ * inserted by following [TAB] presses and longer candidates are not listed.
+ */
+#ifndef EDDY_COMPLETE_MAX_LEN
+#define EDDY_COMPLETE_MAX_LEN	64
+#endif
+
+/**
+ * @brief Size of kill buffer
+ * 
+ * Text removed with [CTRL+U], [CTRL+K] or [CTRL+W] is kept in this buffer
+ * and inserted back with [CTRL+Y]. Of longer text only its beginning is kept.
+ */
+#ifndef EDDY_KILL_BUFF_LEN
+#define EDDY_KILL_BUFF_LEN	EDDY_MAX_LINE_BUFF_LEN
+#endif
+
+/**
+ * @brief Size of type-ahead buffer
+ * 
+ * Input received while command is executed asynchronously is kept in this
+ * buffer and processed after command is done. Characters which do not
+ * fit are dropped.
+ */
+#ifndef EDDY_TYPEAHEAD_LEN
+#define EDDY_TYPEAHEAD_LEN	64
+#endif
+
+/**
+ * @brief Size of output staging buffer
+ * 
+ * Terminal output generated while processing one input event is collected
+ * in this buffer and passed to the print callback with a single call.
+ */
+#ifndef EDDY_OUT_BUFF_LEN
+#define EDDY_OUT_BUFF_LEN	128
+#endif
+
+/**
+ * @brief Output staging buffer fill level which forces flush
+ * 
+ * Must not be greater than EDDY_OUT_BUFF_LEN.
+ */
+#ifndef EDDY_OUT_BUFF_HIGH_WATER
+#define EDDY_OUT_BUFF_HIGH_WATER	EDDY_OUT_BUFF_LEN
+#endif
+
+/**
+ * @brief Maximal number of segments passed to scatter-gather print callback
+ */
+#ifndef EDDY_OUT_MAX_SEGMENTS
+#define EDDY_OUT_MAX_SEGMENTS	8
+#endif
+
 /**
  * @brief Library return type
  */
 typedef enum eddy_retv_e {
     EDDY_RETV_OK,   /**< returned if everyfing is OK */
     EDDY_RETV_ERR,  /**< returned if error */
+    EDDY_RETV_PENDING,  /**< returned by command which is finished later with command_done */
 } eddy_retv_t;
 
 //typedef int eddy_size_t;
@@ -75,45 +296,258 @@ typedef struct eddy_s eddy_t;
  */
 typedef struct eddy_s* eddy_p;
 
+/**
+ * @brief Definition of eddy_ops_s struct type.
+ * @see eddy_ops_s
+ */
+typedef struct eddy_ops_s eddy_ops_t;
+
 /**
  * @brief Pointer on print to terminal callback functrion.
  * @param string Pointer on buffer to print
  */
 typedef void (*eddy_cli_print_clbk)(const char* string);
 
+/**
+ * @brief Output segment passed to scatter-gather print callback.
+ */
+typedef struct eddy_segment_s {
+    const char* data;   /**< Pointer on characters to print (not NUL terminated). */
+    eddy_size_t len;    /**< Number of characters to print. */
+} eddy_segment_t;
+
+/**
+ * @brief Pointer on scatter-gather print to terminal callback function.
+ * 
+ * Receives whole output of one update as list of segments. Segments may
+ * point directly into line buffer and prompt, they are valid only until
+ * the callback returns.
+ * 
+ * @param self Pointer on library context which produced output.
+ * @param segments Array of segments to print in order.
+ * @param count Number of segments in array.
+ */
+typedef void (*eddy_cli_write_clbk)(eddy_p self, const eddy_segment_t* segments, eddy_size_t count);
+
+/**
+ * @brief Runtime statistics of library context.
+ * 
+ * Available when EDDY_USE_STATS is defined.
+ */
+typedef struct eddy_stats_s {
+    unsigned long bytes_in;         /**< Characters passed from terminal. */
+    unsigned long bytes_out;        /**< Characters passed to print callbacks. */
+    unsigned long print_calls;      /**< Calls of print or scatter-gather print callback. */
+    unsigned long esc_decoded;      /**< Recognized escape sequences. */
+    unsigned long esc_rejected;     /**< Unknown escape sequences. */
+    unsigned long insert_drops;     /**< Characters dropped because line buffer was full. */
+    unsigned long typeahead_drops;  /**< Characters dropped because type-ahead buffer was full. */
+    unsigned long line_grows;       /**< Line buffer reallocations to larger size. */
+    unsigned long hint_calls;       /**< Calls of check hint callback. */
+    unsigned long exec_calls;       /**< Calls of execute command callback. */
+    unsigned long max_line_len;     /**< Maximal length of edited line. */
+    unsigned long log_lines;        /**< Log messages printed. */
+    unsigned long log_drops;        /**< Log messages dropped because log queue was full. */
+} eddy_stats_t;
+
+/**
+ * @brief Kind of event passed to recorder callback.
+ */
+typedef enum eddy_record_e {
+    EDDY_RECORD_INPUT,      /**< Characters passed with put_char or put_chars. */
+    EDDY_RECORD_OUTPUT,     /**< Segment of output passed to print callback. */
+    EDDY_RECORD_EXEC,       /**< Status returned by executed command, one byte. */
+    EDDY_RECORD_DONE,       /**< Status passed to command_done, one byte. */
+} eddy_record_t;
+
+/**
+ * @brief Pointer on recorder callback function.
+ * 
+ * Input is reported before it is processed, output before it is passed
+ * to print callback. Data is valid only until the callback returns.
+ * 
+ * @param self Pointer on library context which produced event.
+ * @param kind Kind of event.
+ * @param data Characters of event (not NUL terminated).
+ * @param len Number of characters.
+ */
+typedef void (*eddy_record_clbk)(eddy_p self, eddy_record_t kind, const char* data, eddy_size_t len);
+
+/**
+ * @brief Pointer on line full callback function.
+ * 
+ * Called after input was processed if characters were dropped because
+ * line reached its maximal size.
+ * 
+ * @param self Pointer on library context.
+ * @param dropped Number of dropped characters.
+ */
+typedef void (*eddy_line_full_clbk)(eddy_p self, eddy_size_t dropped);
+
 /**
  * @brief Pointer on log's print callback function.
+ * 
+ * Called by editor thread with each log message printed to terminal,
+ * e.g. to store it. It should not print to terminal itself.
+ * 
  * @param string Pointer on buffer to print.
  */
 typedef void (*eddy_log_print_clbk)(const char* string);
 
 /**
  * @brief Pointer on check and print callback function.
+ * 
+ * Callback prints hints for the line, ending with new line, and may
+ * complete the line in place, up to EDDY_MAX_LINE_BUFF_LEN - 1 characters.
+ * It gets copy of the line, completed part which does not fit into line
+ * buffer is dropped.
+ * Prompt and line are printed again after it. Callback which only completes
+ * the line and does not print can be marked with set_hint_quiet.
+ * 
  * @param cmd_line Pointer on line buffer to check.
  */
 typedef void (*eddy_check_hint_clbk)(char* cmd_line);
 
 /**
  * @brief Piotner on execute command function.
+ * 
+ * Command which can not finish at once returns EDDY_RETV_PENDING and
+ * application calls command_done later, see eddy_s#command_done.
+ * 
  * @param cmd_line Pointer on line buffer to check.
  */
 typedef eddy_retv_t (*eddy_exec_cmd_clbk)(const char* cmd_line);
 
+/**
+ * @brief Node of prefix trie used by completion.
+ * 
+ * Node 0 is root. Children of node are linked through sibling field in
+ * character order, index 0 marks end of list.
+ */
+typedef struct eddy_trie_node_s {
+    unsigned short child;       /**< Index of first child node or 0. */
+    unsigned short sibling;     /**< Index of next sibling node or 0. */
+    char c;                     /**< Character on edge from parent. */
+    unsigned char word;         /**< Path to this node is complete word. */
+} eddy_trie_node_t;
+
+/**
+ * @brief Prefix trie of completion candidates.
+ * 
+ * Built at runtime by eddy_trie_build or generated by tools/eddy_cmdgen.py.
+ */
+typedef struct eddy_trie_s {
+    const eddy_trie_node_t* nodes;  /**< Array of nodes, root first. */
+    unsigned int nodes_cnt;         /**< Number of nodes. */
+} eddy_trie_t;
+
+/**
+ * @brief Pointer on command argument completion provider.
+ * 
+ * @param self Pointer on library context.
+ * @param arg Index of completed argument, 1 for first argument after name.
+ * @return const eddy_trie_t* Trie of candidates or NULL if argument is not completed.
+ */
+typedef const eddy_trie_t* (*eddy_cmd_complete)(eddy_p self, int arg);
+
+/**
+ * @brief Pointer on registered command handler.
+ * 
+ * Arguments point into line buffer which was split in place, they are
+ * valid until the handler returns or, if it returns EDDY_RETV_PENDING,
+ * until command_done is called.
+ * 
+ * @param self Pointer on library context which executes command.
+ * @param argc Number of arguments including command name.
+ * @param argv Arguments, argv[0] is command name, argv[argc] is NULL.
+ */
+typedef eddy_retv_t (*eddy_cmd_handler)(eddy_p self, int argc, char* argv[]);
+
+/**
+ * @brief Registered command.
+ * 
+ * Table passed to set_cmd_table which is not sorted by name is sorted in
+ * place. Table shared by many contexts should be sorted by name, then it
+ * is only read.
+ */
+typedef struct eddy_cmd_s {
+    const char* name;           /**< Command name, first word of line. */
+    eddy_cmd_handler handler;   /**< Function called with split line. */
+    const char* help;           /**< One line description printed by help, may be NULL. */
+    unsigned char min_args;     /**< Minimal number of arguments after name. */
+    unsigned char max_args;     /**< Maximal number of arguments after name. */
+    eddy_cmd_complete complete; /**< Argument completion provider, may be NULL. */
+} eddy_cmd_t;
+
+/**
+ * @brief Const command map with perfect hash lookup.
+ * 
+ * Generated at build time by tools/eddy_cmdgen.py, so it can be placed
+ * in flash. Name is hashed with seed 0 to select bucket, then with seed
+ * of the bucket to select command slot, see eddy_cmd_hash.
+ */
+typedef struct eddy_cmd_map_s {
+    const eddy_cmd_t* cmds;         /**< Commands in slot order. */
+    const unsigned short* seeds;    /**< Hash seed of each bucket. */
+    unsigned int cmds_cnt;          /**< Number of commands. */
+    unsigned int seeds_cnt;         /**< Number of buckets. */
+} eddy_cmd_map_t;
+
 /**
  * @{ \name Pointers on API functions.
  */
 typedef eddy_retv_t (*eddy_set_cli_print_clbk)(eddy_p self, eddy_cli_print_clbk cli_print_clbk);
+typedef eddy_retv_t (*eddy_set_cli_write_clbk)(eddy_p self, eddy_cli_write_clbk cli_write_clbk);
 typedef eddy_retv_t (*eddy_set_log_print_clbk)(eddy_p self, eddy_log_print_clbk log_print_clbk);
 typedef eddy_retv_t (*eddy_set_check_hint_clbk)(eddy_p self, eddy_check_hint_clbk check_hint_clbk);
+typedef eddy_retv_t (*eddy_set_hint_quiet)(eddy_p self, int quiet);
 typedef eddy_retv_t (*eddy_set_exec_cmd_clbk)(eddy_p self, eddy_exec_cmd_clbk exec_cmd_clbk);
+typedef eddy_retv_t (*eddy_set_cmd_table)(eddy_p self, eddy_cmd_t* table, eddy_size_t count);
+typedef eddy_retv_t (*eddy_set_cmd_map)(eddy_p self, const eddy_cmd_map_t* map);
+typedef eddy_retv_t (*eddy_set_completion)(eddy_p self, const eddy_trie_t* trie);
 typedef eddy_retv_t (*eddy_set_prompt)(eddy_p self, char* prompt);
+typedef eddy_retv_t (*eddy_set_history_buff)(eddy_p self, char* buffer, eddy_size_t size);
+typedef eddy_retv_t (*eddy_set_line)(eddy_p self, const char* line);
+typedef eddy_retv_t (*eddy_set_term_width)(eddy_p self, unsigned int cols);
+typedef eddy_retv_t (*eddy_query_term_width)(eddy_p self);
 typedef eddy_retv_t (*eddy_put_char)(eddy_p self, char c);
+typedef eddy_retv_t (*eddy_put_chars)(eddy_p self, const char* buffer, eddy_size_t len);
 typedef eddy_retv_t (*eddy_show_prompt)(eddy_p self);
+typedef eddy_retv_t (*eddy_flush)(eddy_p self);
+typedef eddy_retv_t (*eddy_command_done)(eddy_p self, eddy_retv_t status);
+typedef eddy_retv_t (*eddy_put_log)(eddy_p self, const char* text);
+typedef eddy_retv_t (*eddy_drain_logs)(eddy_p self);
+typedef eddy_retv_t (*eddy_get_stats)(eddy_p self, eddy_stats_t* stats);
+typedef eddy_retv_t (*eddy_reset_stats)(eddy_p self);
+typedef eddy_retv_t (*eddy_set_recorder_clbk)(eddy_p self, eddy_record_clbk record_clbk);
+typedef eddy_retv_t (*eddy_set_batch_mode)(eddy_p self, int enable);
+typedef eddy_retv_t (*eddy_set_line_buff)(eddy_p self, char* buffer, eddy_size_t size);
+typedef eddy_retv_t (*eddy_set_line_limit)(eddy_p self, eddy_size_t limit);
+typedef eddy_retv_t (*eddy_set_line_full_clbk)(eddy_p self, eddy_line_full_clbk line_full_clbk);
 typedef eddy_retv_t (*eddy_destroy)(eddy_p self);
 /**
  * @}
  */
 
+/**
+ * @brief Fixed-block pool of contexts and their history buffers.
+ * 
+ * All blocks are placed in one slab provided by user. Blocks are taken
+ * and returned in O(1), general purpose allocator is not used.
+ */
+typedef struct eddy_pool_s {
+    void* free_list;            /**< First free block. */
+    eddy_size_t block_size;     /**< Size of one block. */
+    eddy_size_t hist_size;      /**< Size of history buffer in block. */
+    eddy_size_t free_cnt;       /**< Number of free blocks. */
+} eddy_pool_t;
+
+/**
+ * @brief Definition of pointer on eddy_pool_s struct type.
+ * @see eddy_pool_s
+ */
+typedef struct eddy_pool_s* eddy_pool_p;
+
 /**
  * @brief Library initialization function
  * 
@@ -124,6 +558,151 @@ typedef eddy_retv_t (*eddy_destroy)(eddy_p self);
  */
 eddy_retv_t init_eddy(eddy_p self);
 
+/**
+ * @brief Size of log queue in private context.
+ */
+#ifdef EDDY_USE_LOG_QUEUE
+#define EDDY_LOG_QUEUE_SIZE	(EDDY_LOG_SLOTS * (EDDY_LOG_MSG_LEN + 2 * sizeof(unsigned int)))
+#else
+#define EDDY_LOG_QUEUE_SIZE	0
+#endif
+
+/**
+ * @brief Size of memory needed for private context
+ * 
+ * Upper bound of eddy_ctx_size() for current configuration, checked when
+ * library is compiled. Memory of this size can be declared statically and
+ * passed to init_eddy_static.
+ */
+#define EDDY_CTX_SIZE	(EDDY_LINE_STORE_LEN + EDDY_OUT_BUFF_LEN + EDDY_HIST_SEARCH_LEN \
+	+ EDDY_KILL_BUFF_LEN + EDDY_TYPEAHEAD_LEN + (EDDY_HIST_SEARCH_LEN + EDDY_HIST_INDEX_BUCKETS) * sizeof(unsigned int) \
+	+ EDDY_OUT_MAX_SEGMENTS * sizeof(eddy_segment_t) + EDDY_LOG_QUEUE_SIZE + sizeof(eddy_stats_t) \
+	+ 64 * sizeof(void*) + EDDY_CACHE_LINE)
+
+/**
+ * @brief Memory for private context with proper alignment.
+ * 
+ * Example of use:
+ * 
+ *     static eddy_ctx_storage_t storage;
+ * 
+ *     init_eddy_static(&eddy, &storage, sizeof(storage));
+ */
+typedef union eddy_ctx_storage_u {
+    char bytes[EDDY_CTX_SIZE];  /**< Context memory. */
+    void* align;                /**< Forces pointer alignment. */
+} eddy_ctx_storage_t;
+
+/**
+ * @brief Size of private context
+ * 
+ * Memory passed to init_eddy_static must have at least this size, it
+ * includes room for aligning context to EDDY_CACHE_LINE.
+ * 
+ * @return eddy_size_t Size of private context for current configuration.
+ */
+eddy_size_t eddy_ctx_size(void);
+
+/**
+ * @brief Size of one pool block
+ * 
+ * Block holds private context followed by history buffer, its size is
+ * multiple of EDDY_CACHE_LINE. Slab passed to eddy_pool_init should have
+ * this size multiplied by number of contexts, plus EDDY_CACHE_LINE - 1 if
+ * it is not aligned to cache line.
+ * 
+ * @param hist_size Size of history buffer of each context, may be 0.
+ * @return eddy_size_t Size of pool block for current configuration.
+ */
+eddy_size_t eddy_pool_block_size(eddy_size_t hist_size);
+
+/**
+ * @brief Library initialization function without memory allocation
+ * 
+ * Initialize library context placed in memory provided by user. Context is
+ * aligned to EDDY_CACHE_LINE inside the memory. Memory must be aligned for
+ * pointer and stay valid until destroy is called. Line stays in buffer
+ * inside context unless set_line_buff or set_line_limit is used.
+ * 
+ * @param self Pointer on library context.
+ * @param storage Memory for private context.
+ * @param size Size of memory, at least eddy_ctx_size(), EDDY_CTX_SIZE is enough.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t init_eddy_static(eddy_p self, void* storage, eddy_size_t size);
+
+/**
+ * @brief Pool initialization function
+ * 
+ * Split slab into blocks of eddy_pool_block_size(hist_size) bytes, the first
+ * one starts at cache line boundary.
+ * 
+ * @param pool Pointer on pool.
+ * @param slab Memory for all blocks, aligned for pointer.
+ * @param size Size of slab.
+ * @param hist_size Size of history buffer of each context, may be 0.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_pool_init(eddy_pool_p pool, void* slab, eddy_size_t size, eddy_size_t hist_size);
+
+/**
+ * @brief Library initialization function with memory from pool
+ * 
+ * Initialize library context and its history buffer in pool block.
+ * Block is returned to pool by destroy. Line stays in buffer inside
+ * context unless set_line_buff or set_line_limit is used.
+ * 
+ * @param self Pointer on library context.
+ * @param pool Pointer on initialized pool.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if pool is empty.
+ */
+eddy_retv_t init_eddy_pool(eddy_p self, eddy_pool_p pool);
+
+/**
+ * @brief Split line into arguments in place
+ * 
+ * Arguments are separated with spaces or tabs. Characters between single
+ * or double quotes form one argument, backslash outside of single quotes
+ * takes next character literally. Quotes and backslashes are removed by
+ * moving characters inside the line and each argument is terminated with
+ * NUL, nothing is allocated.
+ * 
+ * @param line Line to split, modified in place.
+ * @param argv Array for at least max_args + 1 pointers, argv[argc] is set to NULL.
+ * @param max_args Maximal number of arguments.
+ * @return int Number of arguments or -1 if quote is not closed or there are too many arguments.
+ */
+int eddy_split_args(char* line, char* argv[], int max_args);
+
+/**
+ * @brief Hash of command name used by eddy_cmd_map_t
+ * 
+ * 32-bit FNV-1a with seed mixed into offset basis and final bit mixing.
+ * Must give the same values as cmd_hash in tools/eddy_cmdgen.py.
+ * 
+ * @param name Command name, not NUL terminated.
+ * @param len Length of name.
+ * @param seed Hash seed.
+ * @return unsigned long Hash value.
+ */
+unsigned long eddy_cmd_hash(const char* name, unsigned int len, unsigned int seed);
+
+/**
+ * @brief Build prefix trie of words in memory provided by user
+ * 
+ * Words are inserted one by one, common prefixes share nodes. Number of
+ * nodes needed is at most 1 + sum of word lengths.
+ * 
+ * @param trie Pointer on trie.
+ * @param nodes Memory for nodes.
+ * @param nodes_cnt Number of nodes in memory, at most 65535 are used.
+ * @param words Array of NUL terminated words.
+ * @param words_cnt Number of words.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if nodes memory is too small.
+ */
+eddy_retv_t eddy_trie_build(eddy_trie_t* trie, eddy_trie_node_t* nodes, eddy_size_t nodes_cnt,
+    const char* const* words, eddy_size_t words_cnt);
+
 /**
  * @brief Eddy malloc function implementation. [replaceable]
  * 
@@ -145,6 +724,60 @@ void* eddy_malloc(eddy_size_t size);
  */
 void eddy_free(void *ptr);
 
+/**
+ * @brief Library API functions: API(type, name, implementation)
+ * 
+ * Each function is member of eddy_ops_t and, without EDDY_USE_SHARED_OPS,
+ * also member of eddy_t.
+ */
+#define EDDY_API_TABLE(API) \
+    API(eddy_put_char, put_char, eddy_put_char_impl)                             /* Function to passes single character or key code from terminal. */ \
+    API(eddy_put_chars, put_chars, eddy_put_chars_impl)                          /* Function to passes buffer of characters from terminal. */ \
+    API(eddy_set_cli_print_clbk, set_cli_print_clbk, eddy_set_cli_print_impl)    /* To set terminal printing callback function */ \
+    API(eddy_set_cli_write_clbk, set_cli_write_clbk, eddy_set_cli_write_impl)    /* To set scatter-gather terminal printing callback function */ \
+    API(eddy_set_log_print_clbk, set_log_print_clbk, eddy_set_log_print_impl)    /* To set logs printing callback function */ \
+    API(eddy_set_check_hint_clbk, set_check_hint_clbk, eddy_set_check_hint_impl) /* To set check and print hint for command callback */ \
+    API(eddy_set_hint_quiet, set_hint_quiet, eddy_set_hint_quiet_impl)           /* To mark hint callback which only completes line and does not print. */ \
+    API(eddy_set_exec_cmd_clbk, set_exec_cmd_clbk, eddy_set_exec_cmd_impl)       /* To set execute command callback function */ \
+    API(eddy_set_cmd_table, set_cmd_table, eddy_set_cmd_table_impl)              /* To register table of commands. */ \
+    API(eddy_set_cmd_map, set_cmd_map, eddy_set_cmd_map_impl)                    /* To register const generated map of commands. */ \
+    API(eddy_set_completion, set_completion, eddy_set_completion_impl)           /* To set trie of command names completed on [TAB]. */ \
+    API(eddy_set_prompt, set_prompt, eddy_set_prompt_impl)                       /* To set prompt function. */ \
+    API(eddy_set_history_buff, set_history_buff, eddy_set_history_buff_impl)     /* To set memory for commands history. */ \
+    API(eddy_set_line, set_line, eddy_set_line_impl)                             /* To replace edited line. */ \
+    API(eddy_set_term_width, set_term_width, eddy_set_term_width_impl)           /* To set number of terminal columns. */ \
+    API(eddy_query_term_width, query_term_width, eddy_query_term_width_impl)     /* To ask terminal for its width. */ \
+    API(eddy_show_prompt, show_prompt, eddy_show_prompt_impl)                    /* To show prompt first time. */ \
+    API(eddy_flush, flush, eddy_flush_impl)                                      /* Pass staged terminal output to print callback. */ \
+    API(eddy_command_done, command_done, eddy_command_done_impl)                 /* Finish command which returned EDDY_RETV_PENDING. */ \
+    API(eddy_put_log, put_log, eddy_put_log_impl)                                /* Queue log message, may be called from any thread. */ \
+    API(eddy_drain_logs, drain_logs, eddy_drain_logs_impl)                       /* Print queued log messages above edited line. */ \
+    API(eddy_get_stats, get_stats, eddy_get_stats_impl)                          /* Copy runtime statistics. */ \
+    API(eddy_reset_stats, reset_stats, eddy_reset_stats_impl)                    /* Clear runtime statistics. */ \
+    API(eddy_set_recorder_clbk, set_recorder_clbk, eddy_set_recorder_impl)       /* To set callback receiving input and output of session. */ \
+    API(eddy_set_batch_mode, set_batch_mode, eddy_set_batch_mode_impl)           /* To switch between interactive editing and batch execution of lines. */ \
+    API(eddy_set_line_buff, set_line_buff, eddy_set_line_buff_impl)              /* To set memory for line buffer. */ \
+    API(eddy_set_line_limit, set_line_limit, eddy_set_line_limit_impl)           /* To set size up to which line buffer grows. */ \
+    API(eddy_set_line_full_clbk, set_line_full_clbk, eddy_set_line_full_impl)    /* To set callback notified about characters dropped from full line. */ \
+    API(eddy_destroy, destroy, eddy_destroy_impl)                                /* Destroy instance of eddy. */
+
+/**
+ * @brief Declaration of API member generated from EDDY_API_TABLE.
+ */
+#define EDDY_API_MEMBER(type, name, impl)	type name;
+
+/**
+ * @brief Table of API functions
+ */
+struct eddy_ops_s {
+    EDDY_API_TABLE(EDDY_API_MEMBER)
+};
+
+/**
+ * @brief Table of API functions shared by all contexts.
+ */
+extern const eddy_ops_t eddy_ops;
+
 /**
  * @brief Library context with API
  * 
@@ -161,30 +794,93 @@ void eddy_free(void *ptr);
  *         cin = getchar();
  *         eddy.put_char(&eddy, cin);
  *     }
+ * 
+ * Input is UTF-8 encoded: cursor moves and deletes whole characters and
+ * East Asian wide characters take two terminal columns.
+ * 
+ * Lines longer than terminal width wrap. Width is set by application or
+ * read from terminal, its answer arrives with input:
+ * 
+ *     eddy.set_term_width(&eddy, ws.ws_col);  // e.g. from TIOCGWINSZ
+ * 
+ *     eddy.query_term_width(&eddy);           // or on terminals with position reports
+ * 
+ * Input read in chunks can be passed at once:
+ * 
+ *     len = read(fd, buf, sizeof(buf));
+ *     eddy.put_chars(&eddy, buf, len);
+ * 
+ * Commands can be registered instead of parsing line in callback:
+ * 
+ *     static eddy_cmd_t cmds[] = {
+ *         { "set", cmd_set, "set <name> <value>", 2, 2, NULL },
+ *     };
+ * 
+ *     eddy.set_cmd_table(&eddy, cmds, sizeof(cmds) / sizeof(cmds[0]));
+ * 
+ * Fixed command set can be generated at build time into flash resident map:
+ * 
+ *     python3 tools/eddy_cmdgen.py -n app_cmds app_cmds.def app_cmds.c
+ * 
+ * from entries like EDDY_CMD("set", cmd_set, "set <name> <value>", 2, 2),
+ * run by the build so the map follows the definition file (see
+ * eddy_server_demo in CMakeLists.txt):
+ * 
+ *     extern const eddy_cmd_map_t app_cmds;
+ * 
+ *     eddy.set_cmd_map(&eddy, &app_cmds);
+ * 
+ * Generated file contains also trie of command names (app_cmds_trie) which
+ * can be passed to set_completion.
+ * 
+ * With EDDY_USE_LOG_QUEUE other threads print logs without breaking edited
+ * line, editor thread prints them before next input or on drain_logs:
+ * 
+ *     eddy.put_log(&eddy, "link up");     // any thread or interrupt
+ * 
+ *     eddy.drain_logs(&eddy);             // editor thread, e.g. on wakeup
+ * 
+ * With EDDY_USE_RECORDER session can be stored in trace file and replayed
+ * with tools/eddy_replay:
+ * 
+ *     eddy.set_recorder_clbk(&eddy, record);  // e.g. calls eddy_trace_put
+ * 
+ * Input from scripts or other programs can be executed in batch mode,
+ * lines are passed to commands without echo, key decoding and prompt:
+ * 
+ *     eddy.set_batch_mode(&eddy, !isatty(STDIN_FILENO));
+ * 
+ * Line buffer inside context has EDDY_LINE_STORE_LEN bytes. In context
+ * from init_eddy longer lines are moved into memory allocated when line
+ * grows, up to EDDY_MAX_LINE_BUFF_LEN, and released after execution.
+ * Contexts from init_eddy_static and init_eddy_pool do not allocate. Long
+ * lines can be accepted by some contexts only, in memory of application or
+ * with higher limit:
+ * 
+ *     eddy.set_line_buff(&eddy, buffer, sizeof(buffer));
+ * 
+ *     eddy.set_line_limit(&eddy, 16384);
+ *     eddy.set_line_full_clbk(&eddy, line_full);  // e.g. rings the bell
  */
 struct eddy_s {
     /**
      * @{ \name Library context.
     */
     eddy_ctx_p ctx; /**< Internal private context.*/
+    const eddy_ops_t* ops; /**< Table of API functions shared by all contexts. */
     /**
      * @}
      */
 
+#ifndef EDDY_USE_SHARED_OPS
     /**
-     * @{ \name Library API 
+     * @{ \name Library API, the same functions as in ops.
     */
-    eddy_put_char put_char; /**< Function to passes single character or key code from terminal. @see eddy_put_char_impl */
-    eddy_set_cli_print_clbk set_cli_print_clbk; /**< To set terminal printing callback function @see eddy_set_cli_print_impl */
-    eddy_set_log_print_clbk set_log_print_clbk; /**< To set logs printing callback function @see eddy_set_log_print_impl */
-    eddy_set_check_hint_clbk set_check_hint_clbk; /**< To set check and print hint for command callback @see eddy_set_check_hint_impl */
-    eddy_set_exec_cmd_clbk set_exec_cmd_clbk; /**< To set execute command callback function @see eddy_set_exec_cmd_impl */
-    eddy_set_prompt set_prompt; /**< To set prompt function. @see eddy_set_prompt_impl */
-    eddy_show_prompt show_prompt; /**< To show prompt first time. @see eddy_show_prompt_impl */
-    eddy_destroy destroy; /**< Destroy instance of eddy. @see eddy_destroy_impl */
+    EDDY_API_TABLE(EDDY_API_MEMBER)
     /**
      * @}
      */
+#endif
 };
 
 #endif /* __EDDY_H__ */
\ No newline at end of file
@@ -0,0 +1,376 @@
+/**
+ * @file vt_screen.c
+ * @author Rafał Kędzierski (rafal.kedzierski@gmail.com)
+ * @brief VT100 screen model for tests and benchmarks.
+ * @version 0.1
+ * @date 2023-04-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * Writing into the last column leaves the cursor there with pending wrap,
+ * the same way as xterm and VT100 do. Backspace only clears pending wrap
+ * there. Character width is taken from common ranges of wide and combining
+ * characters only.
+ */
+#include "vt_screen.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Range of characters with display width other than 1.
+ */
+typedef struct vt_width_range_s {
+	unsigned long first;	/**< First code point. */
+	unsigned long last;		/**< Last code point. */
+	unsigned int width;		/**< Display width. */
+} vt_width_range_t;
+
+static const vt_width_range_t vt_width_ranges[] = {
+	{ 0x0300, 0x036F, 0 }, { 0x1100, 0x115F, 2 }, { 0x1AB0, 0x1AFF, 0 }, { 0x1DC0, 0x1DFF, 0 },
+	{ 0x200B, 0x200F, 0 }, { 0x20D0, 0x20FF, 0 }, { 0x2E80, 0x3029, 2 }, { 0x302A, 0x302D, 0 },
+	{ 0x302E, 0x3098, 2 }, { 0x3099, 0x309A, 0 }, { 0x309B, 0xA4CF, 2 }, { 0xAC00, 0xD7A3, 2 },
+	{ 0xF900, 0xFAFF, 2 }, { 0xFE00, 0xFE0F, 0 }, { 0xFE20, 0xFE2F, 0 }, { 0xFE30, 0xFE6F, 2 },
+	{ 0xFF00, 0xFF60, 2 }, { 0xFFE0, 0xFFE6, 2 }, { 0x1F300, 0x1F64F, 2 }, { 0x1F900, 0x1F9FF, 2 },
+	{ 0x20000, 0x3FFFD, 2 },
+};
+
+static vt_screen_t* vt_screen_attached;
+
+/**
+ * @brief Get display width of character.
+ */
+static unsigned int vt_screen_width(unsigned long cp)
+{
+	unsigned int idx;
+
+	for(idx = 0; idx < sizeof(vt_width_ranges) / sizeof(vt_width_ranges[0]); idx++) {
+		if(cp < vt_width_ranges[idx].first) {
+			break;
+		}
+
+		if(cp <= vt_width_ranges[idx].last) {
+			return vt_width_ranges[idx].width;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * @brief Decode complete UTF-8 character.
+ */
+static unsigned long vt_screen_decode(const char* text, unsigned int len)
+{
+	static const unsigned char lead_mask[] = { 0x7F, 0x7F, 0x1F, 0x0F, 0x07 };
+	unsigned long cp = (unsigned char)text[0] & lead_mask[len];
+	unsigned int idx;
+
+	for(idx = 1; idx < len; idx++) {
+		cp = (cp << 6) | ((unsigned char)text[idx] & 0x3F);
+	}
+
+	return cp;
+}
+
+static void vt_screen_clear_cells(vt_screen_t* screen, unsigned int row, unsigned int from, unsigned int to)
+{
+	memset(&screen->cells[row][from], 0, (to - from) * sizeof(vt_cell_t));
+}
+
+/**
+ * @brief Move cursor one row down, scrolling screen at its bottom.
+ */
+static void vt_screen_line_feed(vt_screen_t* screen)
+{
+	if(screen->row + 1 < screen->rows) {
+		screen->row++;
+		return;
+	}
+
+	memmove(&screen->cells[0], &screen->cells[1], (screen->rows - 1) * sizeof(screen->cells[0]));
+	vt_screen_clear_cells(screen, screen->rows - 1, 0, screen->cols);
+	screen->scrolls++;
+}
+
+/**
+ * @brief Put character at cursor and advance it.
+ *
+ * Zero width character is appended to character before cursor.
+ */
+static void vt_screen_put(vt_screen_t* screen, const char* text, unsigned int len)
+{
+	unsigned int width = vt_screen_width(vt_screen_decode(text, len));
+	vt_cell_t* cell;
+	unsigned int col;
+
+	if(width == 0) {
+		col = (screen->wrap_pending || screen->col == 0) ? screen->col : screen->col - 1;
+		cell = &screen->cells[screen->row][col];
+
+		while(cell->wide && col > 0) {
+			cell = &screen->cells[screen->row][--col];
+		}
+
+		if(cell->len + len <= VT_SCREEN_CELL_LEN) {
+			memcpy(cell->text + cell->len, text, len);
+			cell->len += len;
+		}
+		return;
+	}
+
+	if(screen->wrap_pending || screen->col + width > screen->cols) {
+		screen->col = 0;
+		screen->wrap_pending = 0;
+		vt_screen_line_feed(screen);
+	}
+
+	cell = &screen->cells[screen->row][screen->col];
+	memcpy(cell->text, text, len);
+	cell->len = len;
+	cell->wide = 0;
+
+	if(width == 2) {
+		screen->cells[screen->row][screen->col + 1].len = 0;
+		screen->cells[screen->row][screen->col + 1].wide = 1;
+	}
+
+	screen->col += width;
+
+	if(screen->col >= screen->cols) {
+		screen->col = screen->cols - 1;
+		screen->wrap_pending = 1;
+	}
+}
+
+/**
+ * @brief Execute complete CSI sequence stored in seq.
+ */
+static void vt_screen_csi(vt_screen_t* screen)
+{
+	char final = screen->seq[screen->seq_len - 1];
+	const char* params = screen->seq + 2;
+	unsigned int arg = (unsigned int)strtoul(params, NULL, 10);
+	unsigned int arg2 = 0;
+	unsigned int count = (arg == 0) ? 1 : arg;
+	const char* sep = strchr(params, ';');
+	unsigned int row;
+
+	if(sep != NULL) {
+		arg2 = (unsigned int)strtoul(sep + 1, NULL, 10);
+	}
+
+	screen->wrap_pending = 0;
+
+	switch(final) {
+	case 'A':
+		screen->row = (count > screen->row) ? 0 : screen->row - count;
+		break;
+	case 'B':
+		screen->row = (screen->row + count >= screen->rows) ? screen->rows - 1 : screen->row + count;
+		break;
+	case 'C':
+		screen->col = (screen->col + count >= screen->cols) ? screen->cols - 1 : screen->col + count;
+		break;
+	case 'D':
+		screen->col = (count > screen->col) ? 0 : screen->col - count;
+		break;
+	case 'H':
+		screen->row = (arg == 0) ? 0 : ((arg > screen->rows) ? screen->rows : arg) - 1;
+		screen->col = (arg2 == 0) ? 0 : ((arg2 > screen->cols) ? screen->cols : arg2) - 1;
+		break;
+	case 'J':
+		if(arg == 0) {
+			vt_screen_clear_cells(screen, screen->row, screen->col, screen->cols);
+			for(row = screen->row + 1; row < screen->rows; row++) {
+				vt_screen_clear_cells(screen, row, 0, screen->cols);
+			}
+		} else if(arg == 1) {
+			vt_screen_clear_cells(screen, screen->row, 0, screen->col + 1);
+			for(row = 0; row < screen->row; row++) {
+				vt_screen_clear_cells(screen, row, 0, screen->cols);
+			}
+		} else {
+			for(row = 0; row < screen->rows; row++) {
+				vt_screen_clear_cells(screen, row, 0, screen->cols);
+			}
+		}
+		return;
+	case 'K':
+		if(arg == 0) {
+			vt_screen_clear_cells(screen, screen->row, screen->col, screen->cols);
+		} else if(arg == 1) {
+			vt_screen_clear_cells(screen, screen->row, 0, screen->col + 1);
+		} else {
+			vt_screen_clear_cells(screen, screen->row, 0, screen->cols);
+		}
+		return;
+	case 's':
+		screen->saved_row = screen->row;
+		screen->saved_col = screen->col;
+		break;
+	case 'u':
+		screen->row = screen->saved_row;
+		screen->col = screen->saved_col;
+		break;
+	case 'n':
+		screen->queries++;
+		return;
+	default:
+		screen->unknown++;
+		return;
+	}
+
+	screen->move_bytes += screen->seq_len;
+}
+
+/**
+ * @brief Interpret next byte of escape sequence.
+ */
+static void vt_screen_seq(vt_screen_t* screen, char c)
+{
+	if(screen->seq_len < VT_SCREEN_MAX_SEQ) {
+		screen->seq[screen->seq_len++] = c;
+		screen->seq[screen->seq_len] = '\0';
+	}
+
+	if(screen->seq_len == 2) {
+		if(c == '[') {
+			return;
+		}
+
+		if(c == '7') {
+			screen->saved_row = screen->row;
+			screen->saved_col = screen->col;
+			screen->move_bytes += 2;
+		} else if(c == '8') {
+			screen->row = screen->saved_row;
+			screen->col = screen->saved_col;
+			screen->wrap_pending = 0;
+			screen->move_bytes += 2;
+		} else {
+			screen->unknown++;
+		}
+
+		screen->seq_len = 0;
+		return;
+	}
+
+	if((unsigned char)c >= 0x40 && (unsigned char)c <= 0x7E) {
+		vt_screen_csi(screen);
+		screen->seq_len = 0;
+	}
+}
+
+void vt_screen_init(vt_screen_t* screen, unsigned int cols, unsigned int rows)
+{
+	memset(screen, 0, sizeof(*screen));
+
+	screen->cols = (cols == 0 || cols > VT_SCREEN_MAX_COLS) ? VT_SCREEN_MAX_COLS : cols;
+	screen->rows = (rows == 0 || rows > VT_SCREEN_MAX_ROWS) ? VT_SCREEN_MAX_ROWS : rows;
+}
+
+void vt_screen_write(vt_screen_t* screen, const char* data, size_t len)
+{
+	unsigned char c;
+	size_t idx;
+
+	screen->bytes += len;
+
+	for(idx = 0; idx < len; idx++) {
+		c = (unsigned char)data[idx];
+
+		if(screen->seq_len > 0) {
+			vt_screen_seq(screen, (char)c);
+		} else if(screen->utf8_need > 0 && (c & 0xC0) == 0x80) {
+			screen->utf8[screen->utf8_len++] = (char)c;
+
+			if(screen->utf8_len == screen->utf8_need) {
+				vt_screen_put(screen, screen->utf8, screen->utf8_len);
+				screen->utf8_need = 0;
+			}
+		} else if(c == 0x1B) {
+			screen->utf8_need = 0;
+			screen->seq[0] = (char)c;
+			screen->seq_len = 1;
+		} else if(c == '\r') {
+			screen->col = 0;
+			screen->wrap_pending = 0;
+			screen->move_bytes++;
+		} else if(c == '\n') {
+			screen->wrap_pending = 0;
+			vt_screen_line_feed(screen);
+			screen->move_bytes++;
+		} else if(c == '\b') {
+			if(screen->col > 0 && !screen->wrap_pending) {
+				screen->col--;
+			}
+			screen->wrap_pending = 0;
+			screen->move_bytes++;
+		} else if(c >= 0xC2 && c <= 0xF4) {
+			screen->utf8[0] = (char)c;
+			screen->utf8_len = 1;
+			screen->utf8_need = (c >= 0xF0) ? 4 : ((c >= 0xE0) ? 3 : 2);
+		} else if(c >= 0x20 && c < 0x7F) {
+			screen->utf8_need = 0;
+			vt_screen_put(screen, data + idx, 1);
+		} else {
+			screen->utf8_need = 0;
+		}
+	}
+}
+
+void vt_screen_reset_counters(vt_screen_t* screen)
+{
+	screen->bytes = 0;
+	screen->move_bytes = 0;
+	screen->prints = 0;
+	screen->queries = 0;
+	screen->scrolls = 0;
+	screen->unknown = 0;
+}
+
+const char* vt_screen_row(vt_screen_t* screen, unsigned int row)
+{
+	const vt_cell_t* cell;
+	unsigned int len = 0;
+	unsigned int end = 0;
+	unsigned int col;
+
+	for(col = 0; row < screen->rows && col < screen->cols; col++) {
+		cell = &screen->cells[row][col];
+
+		if(cell->wide) {
+			continue;
+		}
+
+		if(cell->len == 0) {
+			screen->row_text[len++] = ' ';
+			continue;
+		}
+
+		memcpy(screen->row_text + len, cell->text, cell->len);
+		len += cell->len;
+
+		if(cell->len != 1 || cell->text[0] != ' ') {
+			end = len;
+		}
+	}
+
+	screen->row_text[end] = '\0';
+
+	return screen->row_text;
+}
+
+void vt_screen_attach(vt_screen_t* screen)
+{
+	vt_screen_attached = screen;
+}
+
+void vt_screen_print(const char* string)
+{
+	if(vt_screen_attached != NULL) {
+		vt_screen_attached->prints++;
+		vt_screen_write(vt_screen_attached, string, strlen(string));
+	}
+}
@@ -0,0 +1,145 @@
+/**
+ * @file vt_screen.h
+ * @author Rafał Kędzierski (rafal.kedzierski@gmail.com)
+ * @brief VT100 screen model for tests and benchmarks.
+ * @version 0.1
+ * @date 2023-04-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * Output of the library is interpreted into grid of cells, so tests can
+ * check what terminal shows instead of last printed string. Printed bytes
+ * and bytes spent on cursor movement are counted.
+ *
+ * Example of use:
+ *
+ *     static vt_screen_t screen;
+ *
+ *     vt_screen_init(&screen, 80, 24);
+ *     vt_screen_attach(&screen);
+ *     eddy.set_cli_print_clbk(&eddy, vt_screen_print);
+ *     eddy.put_chars(&eddy, "abc", 3);
+ *     TEST_ASSERT_EQUAL_STRING(">abc", vt_screen_row(&screen, 0));
+ */
+#ifndef __VT_SCREEN_H__
+#define __VT_SCREEN_H__
+
+#include <stddef.h>
+
+/**
+ * @brief Maximal number of screen columns.
+ */
+#ifndef VT_SCREEN_MAX_COLS
+#define VT_SCREEN_MAX_COLS	256
+#endif
+
+/**
+ * @brief Maximal number of screen rows.
+ */
+#ifndef VT_SCREEN_MAX_ROWS
+#define VT_SCREEN_MAX_ROWS	64
+#endif
+
+/**
+ * @brief Maximal number of UTF-8 bytes in cell, character with combining marks.
+ */
+#define VT_SCREEN_CELL_LEN	12
+
+/**
+ * @brief Maximal length of escape sequence.
+ */
+#define VT_SCREEN_MAX_SEQ	16
+
+/**
+ * @brief Screen cell.
+ *
+ * Empty cell holds empty text. Right half of wide character has wide flag set.
+ */
+typedef struct vt_cell_s {
+	char text[VT_SCREEN_CELL_LEN];	/**< UTF-8 encoded character. */
+	unsigned char len;				/**< Number of bytes in text. */
+	unsigned char wide;				/**< Cell is right half of wide character. */
+} vt_cell_t;
+
+/**
+ * @brief Screen model with output counters.
+ */
+typedef struct vt_screen_s {
+	vt_cell_t cells[VT_SCREEN_MAX_ROWS][VT_SCREEN_MAX_COLS];	/**< Screen content. */
+	unsigned int cols;				/**< Screen width. */
+	unsigned int rows;				/**< Screen height. */
+	unsigned int row;				/**< Cursor row, counted from 0. */
+	unsigned int col;				/**< Cursor column, counted from 0. */
+	unsigned char wrap_pending;		/**< Last column was written, next character goes to next row. */
+	unsigned int saved_row;			/**< Row saved with ESC[s or ESC 7. */
+	unsigned int saved_col;			/**< Column saved with ESC[s or ESC 7. */
+	char seq[VT_SCREEN_MAX_SEQ+1];	/**< Received part of escape sequence. */
+	unsigned int seq_len;			/**< Number of bytes of escape sequence, 0 outside of it. */
+	char utf8[4];					/**< Received part of multibyte character. */
+	unsigned char utf8_len;			/**< Number of received bytes of multibyte character. */
+	unsigned char utf8_need;		/**< Length of received multibyte character. */
+	unsigned long bytes;			/**< Number of interpreted bytes. */
+	unsigned long move_bytes;		/**< Bytes of cursor movement: CR, LF, BS and cursor sequences. */
+	unsigned long prints;			/**< Number of vt_screen_print calls. */
+	unsigned long queries;			/**< Number of cursor position queries, not answered. */
+	unsigned long scrolls;			/**< Number of rows scrolled out of screen. */
+	unsigned long unknown;			/**< Number of not recognized escape sequences. */
+	char row_text[VT_SCREEN_MAX_COLS * VT_SCREEN_CELL_LEN + 1];	/**< Buffer for vt_screen_row. */
+} vt_screen_t;
+
+/**
+ * @brief Initialize empty screen with cursor in top left corner.
+ *
+ * Size is limited to VT_SCREEN_MAX_COLS and VT_SCREEN_MAX_ROWS.
+ *
+ * @param screen Pointer on screen.
+ * @param cols Screen width.
+ * @param rows Screen height.
+ */
+void vt_screen_init(vt_screen_t* screen, unsigned int cols, unsigned int rows);
+
+/**
+ * @brief Interpret terminal output.
+ *
+ * @param screen Pointer on screen.
+ * @param data Printed bytes, sequences may be split between calls.
+ * @param len Number of bytes.
+ */
+void vt_screen_write(vt_screen_t* screen, const char* data, size_t len);
+
+/**
+ * @brief Reset output counters, screen content is kept.
+ *
+ * @param screen Pointer on screen.
+ */
+void vt_screen_reset_counters(vt_screen_t* screen);
+
+/**
+ * @brief Get text of screen row.
+ *
+ * Empty cells are returned as spaces, trailing spaces are removed. Text
+ * is valid until next call.
+ *
+ * @param screen Pointer on screen.
+ * @param row Row number, counted from 0.
+ * @return const char* UTF-8 encoded row text.
+ */
+const char* vt_screen_row(vt_screen_t* screen, unsigned int row);
+
+/**
+ * @brief Select screen used by vt_screen_print.
+ *
+ * @param screen Pointer on screen.
+ */
+void vt_screen_attach(vt_screen_t* screen);
+
+/**
+ * @brief Print callback writing to attached screen.
+ *
+ * Matches eddy_cli_print_clbk, so it can be passed to set_cli_print_clbk.
+ *
+ * @param string Printed string.
+ */
+void vt_screen_print(const char* string);
+
+#endif /* __VT_SCREEN_H__ */
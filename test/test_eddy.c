@@ -1,5 +1,6 @@
 #include "unity.h"
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -10,12 +11,13 @@ char test_phrase[] = "Test phrase!";
 char test_print_buffer[256];
 char test_hint_buffer[256];
 char test_exec_buffer[256];
+bool test_malloc_fail;
 
 void* eddy_malloc(eddy_size_t size)
 {
 	static bool first_time = true;
 
-	if(first_time) {
+	if(first_time || test_malloc_fail) {
 		first_time = false;
 		return NULL;
 	} else {
@@ -24,6 +26,7 @@ void* eddy_malloc(eddy_size_t size)
 }
 
 #include "eddy.h"
+#include "vt_screen.h"
 
 void setUp(void) {}
 
@@ -42,6 +45,7 @@ void check_hint(char* cmd_line)
 eddy_retv_t exec_command(const char* cmd_line)
 {
     strcpy(test_exec_buffer, cmd_line);
+    return EDDY_RETV_OK;
 }
 
 void* false_maloc(size_t size, int num_calls){
@@ -129,4 +133,1519 @@ void test_more_chars_printing()
 		expected_string[0] = test_phrase[idx];
 		TEST_ASSERT_EQUAL_STRING(test_print_buffer, expected_string);
 	}
-}
\ No newline at end of file
+}
+int test_print_calls;
+
+void print_console_count(const char* string)
+{
+	test_print_calls++;
+	strcpy(test_print_buffer, string);
+}
+
+void test_mid_line_insert_single_print()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console_count);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	eddy.put_char(&eddy, 'a');
+	eddy.put_char(&eddy, 'b');
+	eddy.put_char(&eddy, 'c');
+	eddy.put_char(&eddy, '\x1b');
+	eddy.put_char(&eddy, '[');
+	eddy.put_char(&eddy, 'D');
+	eddy.put_char(&eddy, '\x1b');
+	eddy.put_char(&eddy, '[');
+	eddy.put_char(&eddy, 'D');
+
+	test_print_calls = 0;
+	eddy.put_char(&eddy, 'X');
+
+	TEST_ASSERT_EQUAL(1, test_print_calls);
+	TEST_ASSERT_EQUAL_STRING("Xbc\x1b[2D", test_print_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_output_high_water_flush()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+	char line[EDDY_OUT_BUFF_LEN + 11];
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console_count);
+	eddy.set_check_hint_clbk(&eddy, check_hint);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	for(int idx = 0; idx < EDDY_OUT_BUFF_LEN + 10; idx++) {
+		eddy.put_char(&eddy, 'a');
+	}
+
+	memset(line, 'b', sizeof(line) - 1);
+	line[sizeof(line) - 1] = '\0';
+
+	test_print_calls = 0;
+	eddy.set_line(&eddy, line);
+
+	/* "\x1b[1A\x1b[58D" and 138 characters wrapped at 80 columns */
+	TEST_ASSERT_EQUAL(2, test_print_calls);
+	TEST_ASSERT_EQUAL(19, strlen(test_print_buffer));
+
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy.flush(&eddy));
+	TEST_ASSERT_EQUAL(2, test_print_calls);
+
+	eddy.destroy(&eddy);
+}
+
+int test_print_bytes;
+
+void print_console_bytes(const char* string)
+{
+	test_print_calls++;
+	test_print_bytes += strlen(string);
+	strcpy(test_print_buffer, string);
+}
+
+void test_put_chars_paste_line()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+	char paste[200];
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console_bytes);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	memset(paste, 'p', sizeof(paste));
+	test_print_calls = 0;
+	test_print_bytes = 0;
+
+	result = eddy.put_chars(&eddy, paste, sizeof(paste));
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+	TEST_ASSERT_EQUAL(sizeof(paste), test_print_bytes);
+	TEST_ASSERT_EQUAL((sizeof(paste) + EDDY_OUT_BUFF_LEN - 1) / EDDY_OUT_BUFF_LEN, test_print_calls);
+
+	eddy.destroy(&eddy);
+}
+
+void test_put_chars_mid_line()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console_count);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	eddy.put_chars(&eddy, "ab\x1b[D", 5);
+
+	test_print_calls = 0;
+	eddy.put_chars(&eddy, "XYZ", 3);
+
+	TEST_ASSERT_EQUAL(1, test_print_calls);
+	TEST_ASSERT_EQUAL_STRING("XYZb\b", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\r", 1);
+
+	TEST_ASSERT_EQUAL_STRING("aXYZb", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_gap_edit()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	/* insert and delete on both sides of cursor moved mid-line */
+	eddy.put_chars(&eddy, "hello world\x1b[D\x1b[D\x1b[D\x1b[D\x1b[Dbig ", 30);
+	eddy.put_chars(&eddy, "\x1b[3~\x7f", 5);
+	eddy.put_chars(&eddy, "\r", 1);
+
+	TEST_ASSERT_EQUAL_STRING("hello bigorld", test_exec_buffer);
+
+	/* move cursor between line ends, kill and yank text after cursor */
+	eddy.put_chars(&eddy, "hello world\x1b[D\x1b[D\x1b[D\x01go \x05!", 26);
+	eddy.put_chars(&eddy, "\x1b[D\x1b[D\x1b[D\x0b\x01\x19", 12);
+	eddy.put_chars(&eddy, "\r", 1);
+
+	TEST_ASSERT_EQUAL_STRING("ld!go hello wor", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_put_chars_command_boundary()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console_count);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	eddy.put_chars(&eddy, "first\rsec", 9);
+
+	TEST_ASSERT_EQUAL_STRING("first", test_exec_buffer);
+	TEST_ASSERT_EQUAL_STRING(">sec", test_print_buffer);
+
+	eddy.put_chars(&eddy, "ond\n", 4);
+
+	TEST_ASSERT_EQUAL_STRING("second", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_esc_seq_decoding()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console_count);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	eddy.put_chars(&eddy, "abc\x1bOD\x1b[D", 9);
+
+	test_print_calls = 0;
+	eddy.put_chars(&eddy, "\x1b[1;5C", 6);
+
+	TEST_ASSERT_EQUAL(1, test_print_calls);
+	TEST_ASSERT_EQUAL_STRING("\x1b[C", test_print_buffer);
+
+	test_print_calls = 0;
+	eddy.put_chars(&eddy, "\x1b[15~\x1b[2~\x1bOP\x1b[6~", 16);
+
+	TEST_ASSERT_EQUAL(0, test_print_calls);
+
+	eddy.put_chars(&eddy, "\x1b[99~", 5);
+
+	TEST_ASSERT_EQUAL(1, test_print_calls);
+	TEST_ASSERT_EQUAL_STRING("\x1b[99~", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\x1b[3~\r", 5);
+
+	TEST_ASSERT_EQUAL_STRING("ab", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_esc_seq_control_char()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	eddy.put_chars(&eddy, "ab\x1b[\rD", 6);
+
+	TEST_ASSERT_EQUAL_STRING("ab", test_exec_buffer);
+
+	eddy.put_chars(&eddy, "xy\x1b[\x01" "C", 6);
+	eddy.put_chars(&eddy, "z\x1b[\x18" "D\r", 6);
+
+	TEST_ASSERT_EQUAL_STRING("xzDy", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+int test_write_calls;
+eddy_size_t test_write_segments;
+
+void write_console(eddy_p self, const eddy_segment_t* segments, eddy_size_t count)
+{
+	eddy_size_t len = 0;
+
+	test_write_calls++;
+	test_write_segments = count;
+
+	for(eddy_size_t idx = 0; idx < count; idx++) {
+		memcpy(test_print_buffer + len, segments[idx].data, segments[idx].len);
+		len += segments[idx].len;
+	}
+
+	test_print_buffer[len] = '\0';
+}
+
+void test_write_clbk_segments()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console_count);
+	eddy.set_cli_write_clbk(&eddy, write_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	eddy.put_chars(&eddy, "abc\x1b[D\x1b[D", 9);
+
+	test_print_calls = 0;
+	test_write_calls = 0;
+	eddy.put_char(&eddy, 'X');
+
+	TEST_ASSERT_EQUAL(0, test_print_calls);
+	TEST_ASSERT_EQUAL(1, test_write_calls);
+	TEST_ASSERT_EQUAL(3, test_write_segments);
+	TEST_ASSERT_EQUAL_STRING("Xbc\x1b[2D", test_print_buffer);
+
+	eddy.put_char(&eddy, '\r');
+
+	TEST_ASSERT_EQUAL_STRING("aXbc", test_exec_buffer);
+	TEST_ASSERT_EQUAL_STRING(">", test_print_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_history_recall()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+	char history[32];
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console_count);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+	result = eddy.set_history_buff(&eddy, history, sizeof(history));
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.put_chars(&eddy, "one\rtwo\rtwo\rthree\r", 18);
+
+	eddy.put_chars(&eddy, "\x1b[A", 3);
+	TEST_ASSERT_EQUAL_STRING("three", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\x1b[A", 3);
+	TEST_ASSERT_EQUAL_STRING("\x1b[4Dwo\x1b[J", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\x1b[A", 3);
+	TEST_ASSERT_EQUAL_STRING("\x1b[3Done", test_print_buffer);
+
+	test_print_calls = 0;
+	eddy.put_chars(&eddy, "\x1b[A", 3);
+	TEST_ASSERT_EQUAL(0, test_print_calls);
+
+	eddy.put_chars(&eddy, "\x1b[B\x1b[B\x1b[B", 9);
+	TEST_ASSERT_EQUAL_STRING("\x1b[3Dtwo\x1b[2Dhree\x1b[5D\x1b[J", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\x1b[A\r", 4);
+	TEST_ASSERT_EQUAL_STRING("three", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_history_evicts_oldest()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+	/* "aaaa" and "bbbb" fill history, "cc" evicts only "aaaa" */
+	char history[EDDY_HIST_ENTRY_SIZE(4) * 2];
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console_count);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+	eddy.set_history_buff(&eddy, history, sizeof(history));
+
+	eddy.put_chars(&eddy, "aaaa\rbbbb\rcc\r", 13);
+
+	eddy.put_chars(&eddy, "\x1b[A\x1b[A\x1b[A\x1b[A\r", 13);
+
+	TEST_ASSERT_EQUAL_STRING("bbbb", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_history_reverse_search()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+	char history[64];
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+	eddy.set_history_buff(&eddy, history, sizeof(history));
+
+	eddy.put_chars(&eddy, "set led on\rget temp\rset led off\r", 32);
+
+	eddy.put_chars(&eddy, "\x12l", 2);
+	eddy.put_char(&eddy, 'e');
+	TEST_ASSERT_EQUAL_STRING("\r(reverse-i-search)`le': set led off\x1b[J", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\x12", 1);
+	TEST_ASSERT_EQUAL_STRING("\r(reverse-i-search)`le': set led on\x1b[J", test_print_buffer);
+
+	eddy.put_chars(&eddy, "x", 1);
+	TEST_ASSERT_EQUAL_STRING("\r(failing reverse-i-search)`lex': set led on\x1b[J", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\x7f\r", 2);
+	TEST_ASSERT_EQUAL_STRING("set led on", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_history_prefix_search()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+	char history[64];
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+	eddy.set_history_buff(&eddy, history, sizeof(history));
+
+	eddy.put_chars(&eddy, "set a\rget b\rset c\r", 18);
+
+	eddy.put_chars(&eddy, "se\x1b[5~", 6);
+	TEST_ASSERT_EQUAL_STRING("set c", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\x1b[5~", 4);
+	TEST_ASSERT_EQUAL_STRING("\ba", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\x1b[6~\x1b[6~", 8);
+	TEST_ASSERT_EQUAL_STRING("\bc\x1b[3D\x1b[J", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\r", 1);
+	TEST_ASSERT_EQUAL_STRING("se", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_history_prefix_search_steps()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+	char history[1024];
+	char cmd[8];
+	int len;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+	eddy.set_history_buff(&eddy, history, sizeof(history));
+
+	eddy.put_chars(&eddy, "set a\r", 6);
+
+	for(int idx = 0; idx < EDDY_HIST_SEARCH_STEPS + 8; idx++) {
+		len = sprintf(cmd, "s%d\r", idx);
+		eddy.put_chars(&eddy, cmd, len);
+	}
+
+	eddy.put_chars(&eddy, "se", 2);
+
+	test_print_buffer[0] = '\0';
+	eddy.put_chars(&eddy, "\x1b[5~", 4);
+	TEST_ASSERT_EQUAL_STRING("", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\x1b[5~", 4);
+	TEST_ASSERT_EQUAL_STRING("t a", test_print_buffer);
+
+	test_print_buffer[0] = '\0';
+	eddy.put_chars(&eddy, "\x1b[6~", 4);
+	TEST_ASSERT_EQUAL_STRING("", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\x1b[6~", 4);
+	TEST_ASSERT_EQUAL_STRING("\x1b[3D\x1b[J", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\r", 1);
+	TEST_ASSERT_EQUAL_STRING("se", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_init_static()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+	static eddy_ctx_storage_t storage;
+
+	TEST_ASSERT_TRUE(eddy_ctx_size() <= sizeof(storage));
+
+	result = init_eddy_static(&eddy, &storage, 16);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_ERR);
+
+	/* context is aligned to cache line inside memory */
+	result = init_eddy_static(&eddy, &storage, sizeof(storage));
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+	TEST_ASSERT_EQUAL(0, (size_t)eddy.ctx % EDDY_CACHE_LINE);
+	TEST_ASSERT_TRUE((char*)eddy.ctx >= storage.bytes);
+
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.put_chars(&eddy, "static\r", 7);
+
+	TEST_ASSERT_EQUAL_STRING("static", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_init_pool()
+{
+	eddy_t eddy[3];
+	eddy_retv_t result;
+	eddy_pool_t pool;
+	void* slab = malloc(2 * eddy_pool_block_size(32) + EDDY_CACHE_LINE - 1);
+	eddy_ctx_p first;
+
+	result = eddy_pool_init(&pool, slab, 2 * eddy_pool_block_size(32) + EDDY_CACHE_LINE - 1, 32);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+	TEST_ASSERT_EQUAL(2, pool.free_cnt);
+
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, init_eddy_pool(&eddy[0], &pool));
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, init_eddy_pool(&eddy[1], &pool));
+	TEST_ASSERT_EQUAL(0, (size_t)eddy[0].ctx % EDDY_CACHE_LINE);
+	TEST_ASSERT_EQUAL(0, (size_t)eddy[1].ctx % EDDY_CACHE_LINE);
+	first = eddy[0].ctx;
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, init_eddy_pool(&eddy[2], &pool));
+
+	eddy[1].set_exec_cmd_clbk(&eddy[1], exec_command);
+	eddy[1].set_cli_print_clbk(&eddy[1], print_console);
+	eddy[1].put_chars(&eddy[1], "pool\r\x1b[A\r", 9);
+
+	TEST_ASSERT_EQUAL_STRING("pool", test_exec_buffer);
+
+	eddy[0].destroy(&eddy[0]);
+	TEST_ASSERT_EQUAL(1, pool.free_cnt);
+
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, init_eddy_pool(&eddy[2], &pool));
+	TEST_ASSERT_EQUAL_PTR(first, eddy[2].ctx);
+
+	eddy[1].destroy(&eddy[1]);
+	eddy[2].destroy(&eddy[2]);
+	TEST_ASSERT_EQUAL(2, pool.free_cnt);
+
+	free(slab);
+}
+
+void test_stats()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+	eddy_stats_t stats;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	result = eddy.get_stats(&eddy, &stats);
+
+#ifdef EDDY_USE_STATS
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, result);
+
+	eddy.put_chars(&eddy, "abc\x1b[D\x1b[9~\r", 12);
+	eddy.put_char(&eddy, 'x');
+	eddy.get_stats(&eddy, &stats);
+
+	TEST_ASSERT_EQUAL(13, stats.bytes_in);
+	TEST_ASSERT_EQUAL(3, stats.print_calls);
+	TEST_ASSERT_EQUAL(1, stats.esc_decoded);
+	TEST_ASSERT_EQUAL(1, stats.esc_rejected);
+	TEST_ASSERT_EQUAL(1, stats.exec_calls);
+	TEST_ASSERT_EQUAL(3, stats.max_line_len);
+
+	eddy.reset_stats(&eddy);
+	eddy.get_stats(&eddy, &stats);
+
+	TEST_ASSERT_EQUAL(0, stats.bytes_in);
+#else
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, result);
+#endif
+
+	eddy.destroy(&eddy);
+}
+
+void complete_hint(char* cmd_line)
+{
+	if(strcmp(cmd_line, "sh") == 0) {
+		strcpy(cmd_line, "show");
+	} else if(strcmp(cmd_line, "show all") == 0) {
+		strcpy(cmd_line, "show");
+	}
+}
+
+void print_hint(char* cmd_line)
+{
+	print_console_count("\r\nshow shut\r\n");
+	complete_hint(cmd_line);
+}
+
+void test_hint_full_redraw()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console_count);
+	eddy.set_check_hint_clbk(&eddy, print_hint);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	eddy.put_chars(&eddy, "sh", 2);
+
+	test_print_calls = 0;
+	eddy.put_char(&eddy, '\t');
+	TEST_ASSERT_EQUAL(2, test_print_calls);
+	TEST_ASSERT_EQUAL_STRING(">show", test_print_buffer);
+
+	eddy.put_char(&eddy, '\r');
+	TEST_ASSERT_EQUAL_STRING("show", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_hint_minimal_redraw()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_check_hint_clbk(&eddy, complete_hint);
+	eddy.set_hint_quiet(&eddy, 1);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	eddy.put_chars(&eddy, "sh", 2);
+	eddy.put_char(&eddy, '\t');
+	TEST_ASSERT_EQUAL_STRING("ow", test_print_buffer);
+
+	eddy.put_chars(&eddy, " all\x1b[D\x1b[D", 10);
+	eddy.put_char(&eddy, '\t');
+	TEST_ASSERT_EQUAL_STRING("\x1b[2D\x1b[J", test_print_buffer);
+
+	eddy.set_line(&eddy, "shut");
+	TEST_ASSERT_EQUAL_STRING("\x1b[2Dut", test_print_buffer);
+
+	eddy.put_char(&eddy, '\r');
+	TEST_ASSERT_EQUAL_STRING("shut", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+int test_cmd_argc;
+
+eddy_retv_t cmd_set(eddy_p self, int argc, char* argv[])
+{
+	test_cmd_argc = argc;
+	strcpy(test_exec_buffer, argv[argc - 1]);
+	return EDDY_RETV_OK;
+}
+
+void test_cmd_table()
+{
+	eddy_cmd_t cmds[] = {
+		{ "show", cmd_set, "show value", 0, 1, NULL },
+		{ "set", cmd_set, "set value", 2, 2, NULL },
+	};
+	eddy_cmd_t dups[] = {
+		{ "show", cmd_set, "show value", 0, 1, NULL },
+		{ "set", cmd_set, "set value", 2, 2, NULL },
+		{ "show", cmd_set, "show value", 0, 1, NULL },
+	};
+	char line[] = " a  'b c'\"d\"\\ e '' ";
+	char args[] = "a b";
+	char* argv[4];
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	TEST_ASSERT_EQUAL(3, eddy_split_args(line, argv, 3));
+	TEST_ASSERT_EQUAL_STRING("a", argv[0]);
+	TEST_ASSERT_EQUAL_STRING("b cd e", argv[1]);
+	TEST_ASSERT_EQUAL_STRING("", argv[2]);
+	TEST_ASSERT_NULL(argv[3]);
+	TEST_ASSERT_EQUAL(-1, eddy_split_args(args, argv, 1));
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, eddy.set_cmd_table(&eddy, dups, 3));
+	TEST_ASSERT_EQUAL_STRING("show", dups[0].name);
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy.set_cmd_table(&eddy, cmds, 2));
+	TEST_ASSERT_EQUAL_STRING("set", cmds[0].name);
+
+	eddy.put_chars(&eddy, "set led \"on now\"\r", 17);
+	TEST_ASSERT_EQUAL(3, test_cmd_argc);
+	TEST_ASSERT_EQUAL_STRING("on now", test_exec_buffer);
+
+	eddy.put_chars(&eddy, "set led\r", 8);
+	TEST_ASSERT_EQUAL_STRING("set: argument count must be 2\r\nERROR\r\n>", test_print_buffer);
+
+	eddy.put_chars(&eddy, "show a b\r", 9);
+	TEST_ASSERT_EQUAL_STRING("show: argument count must be 0..1\r\nERROR\r\n>", test_print_buffer);
+
+	eddy.put_chars(&eddy, "sets x\r", 7);
+	TEST_ASSERT_EQUAL_STRING("sets x", test_exec_buffer);
+
+	eddy.put_chars(&eddy, "help\r", 5);
+	TEST_ASSERT_EQUAL_STRING("help", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+/* generated by tools/eddy_cmdgen.py -n test_cmd_map */
+static const eddy_cmd_t test_cmd_map_cmds[] = {
+	{ "version", cmd_set, "show version", 0, 0, NULL },
+	{ "reboot", cmd_set, NULL, 0, 0, NULL },
+	{ "led", cmd_set, "set led state", 1, 1, NULL },
+};
+
+static const unsigned short test_cmd_map_seeds[] = {
+	4, 0,
+};
+
+const eddy_cmd_map_t test_cmd_map = { test_cmd_map_cmds, test_cmd_map_seeds, 3, 2 };
+
+void test_cmd_map_lookup()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy.set_cmd_map(&eddy, &test_cmd_map));
+
+	eddy.put_chars(&eddy, "led on\r", 7);
+	TEST_ASSERT_EQUAL(2, test_cmd_argc);
+	TEST_ASSERT_EQUAL_STRING("on", test_exec_buffer);
+
+	eddy.put_chars(&eddy, "version\r", 8);
+	TEST_ASSERT_EQUAL(1, test_cmd_argc);
+	TEST_ASSERT_EQUAL_STRING("version", test_exec_buffer);
+
+	eddy.put_chars(&eddy, "le\r", 3);
+	TEST_ASSERT_EQUAL_STRING("ERROR\r\n>", test_print_buffer);
+
+	eddy.put_chars(&eddy, "help\r", 5);
+	TEST_ASSERT_EQUAL_STRING("version  show version\r\nreboot\r\nled      set led state\r\n>", test_print_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+eddy_trie_t test_led_trie;
+
+const eddy_trie_t* complete_led(eddy_p self, int arg)
+{
+	return (arg == 1) ? &test_led_trie : NULL;
+}
+
+void test_completion()
+{
+	static const char* const names[] = { "show", "set", "status", "shutdown" };
+	static const char* const leds[] = { "led", "level" };
+	eddy_cmd_t cmds[] = {
+		{ "set", cmd_set, NULL, 1, 1, complete_led },
+	};
+	eddy_trie_node_t nodes[18];
+	eddy_trie_node_t led_nodes[8];
+	static char long_word[EDDY_COMPLETE_MAX_LEN + 7];
+	static const char* const long_names[] = { long_word };
+	static eddy_trie_node_t long_nodes[EDDY_COMPLETE_MAX_LEN + 7];
+	eddy_trie_t long_trie;
+	eddy_trie_t trie;
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, eddy_trie_build(&trie, nodes, 17, names, 4));
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy_trie_build(&trie, nodes, 18, names, 4));
+	TEST_ASSERT_EQUAL(18, trie.nodes_cnt);
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy_trie_build(&test_led_trie, led_nodes, 8, leds, 2));
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_cmd_table(&eddy, cmds, 1);
+	eddy.set_completion(&eddy, &trie);
+
+	eddy.put_chars(&eddy, "sho", 3);
+	eddy.put_char(&eddy, '\t');
+	TEST_ASSERT_EQUAL_STRING("w ", test_print_buffer);
+
+	eddy.set_line(&eddy, "s");
+	strcpy(test_print_buffer, "");
+	eddy.put_char(&eddy, '\t');
+	TEST_ASSERT_EQUAL_STRING("", test_print_buffer);
+	eddy.put_char(&eddy, '\t');
+	TEST_ASSERT_EQUAL_STRING("\r\nset  show  shutdown  status\r\n>s", test_print_buffer);
+
+	eddy.put_chars(&eddy, "ta\x1b[D", 5);
+	eddy.put_char(&eddy, '\t');
+	TEST_ASSERT_EQUAL_STRING("atusa\b", test_print_buffer);
+
+	eddy.set_line(&eddy, "set l");
+	eddy.put_char(&eddy, '\t');
+	TEST_ASSERT_EQUAL_STRING("e", test_print_buffer);
+	eddy.put_char(&eddy, '\t');
+	eddy.put_char(&eddy, '\t');
+	TEST_ASSERT_EQUAL_STRING("\r\nled  level\r\n>set le", test_print_buffer);
+
+	/* candidate longer than EDDY_COMPLETE_MAX_LEN is completed in two steps */
+	memset(long_word, 'x', sizeof(long_word) - 1);
+	long_word[sizeof(long_word) - 1] = '\0';
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy_trie_build(&long_trie, long_nodes, sizeof(long_word), long_names, 1));
+	eddy.set_completion(&eddy, &long_trie);
+	eddy.set_line(&eddy, "");
+
+	eddy.put_char(&eddy, '\t');
+	TEST_ASSERT_EQUAL(EDDY_COMPLETE_MAX_LEN, strlen(test_print_buffer));
+	eddy.put_char(&eddy, '\t');
+	TEST_ASSERT_EQUAL_STRING("xxxxxx ", test_print_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+eddy_retv_t exec_pending(const char* cmd_line)
+{
+	strcpy(test_exec_buffer, cmd_line);
+	return EDDY_RETV_PENDING;
+}
+
+void test_async_exec()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_pending);
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, eddy.command_done(&eddy, EDDY_RETV_OK));
+
+	eddy.put_chars(&eddy, "flash\rab", 8);
+	TEST_ASSERT_EQUAL_STRING("flash", test_exec_buffer);
+	TEST_ASSERT_EQUAL_STRING("flash\r\n", test_print_buffer);
+
+	eddy.put_char(&eddy, 'c');
+	eddy.put_chars(&eddy, "\rx", 2);
+	TEST_ASSERT_EQUAL_STRING("flash\r\n", test_print_buffer);
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, eddy.set_line(&eddy, "y"));
+
+	/* prompt, type-ahead and second command are handled at once */
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy.command_done(&eddy, EDDY_RETV_ERR));
+	TEST_ASSERT_EQUAL_STRING("abc", test_exec_buffer);
+	TEST_ASSERT_EQUAL_STRING("ERROR\r\n>abc\r\n", test_print_buffer);
+
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy.command_done(&eddy, EDDY_RETV_OK));
+	TEST_ASSERT_EQUAL_STRING(">x", test_print_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_typeahead_overflow()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+	eddy_stats_t stats;
+	char ahead[EDDY_TYPEAHEAD_LEN];
+	char line[EDDY_TYPEAHEAD_LEN + 1];
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_pending);
+	memset(ahead, 'a', sizeof(ahead));
+
+	/* sequence which does not fit is dropped whole with all later input */
+	eddy.put_chars(&eddy, "x\r", 2);
+	eddy.put_chars(&eddy, ahead, EDDY_TYPEAHEAD_LEN - 2);
+	eddy.put_chars(&eddy, "\x1b[D", 3);
+	eddy.put_char(&eddy, 'b');
+	eddy.command_done(&eddy, EDDY_RETV_OK);
+	eddy.put_chars(&eddy, "c\r", 2);
+
+	memset(line, 'a', EDDY_TYPEAHEAD_LEN - 2);
+	strcpy(line + EDDY_TYPEAHEAD_LEN - 2, "c");
+	TEST_ASSERT_EQUAL_STRING(line, test_exec_buffer);
+
+	/* multibyte character is not split */
+	eddy.put_chars(&eddy, ahead, EDDY_TYPEAHEAD_LEN - 1);
+	eddy.put_chars(&eddy, "\xC3\xA9", 2);
+	eddy.command_done(&eddy, EDDY_RETV_OK);
+	eddy.put_chars(&eddy, "\r", 1);
+
+	memset(line, 'a', EDDY_TYPEAHEAD_LEN - 1);
+	line[EDDY_TYPEAHEAD_LEN - 1] = '\0';
+	TEST_ASSERT_EQUAL_STRING(line, test_exec_buffer);
+
+#ifdef EDDY_USE_STATS
+	eddy.get_stats(&eddy, &stats);
+
+	TEST_ASSERT_EQUAL(6, stats.typeahead_drops);
+	TEST_ASSERT_EQUAL(0, stats.insert_drops);
+#else
+	(void)stats;
+#endif
+
+	eddy.destroy(&eddy);
+}
+
+char test_log_buffer[256];
+
+void log_store(const char* string)
+{
+	strcat(test_log_buffer, string);
+}
+
+void test_log_queue()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+#ifdef EDDY_USE_LOG_QUEUE
+	char text[8];
+	int idx;
+#endif
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_log_print_clbk(&eddy, log_store);
+	eddy.put_chars(&eddy, "abc\x1b[D", 6);
+
+	result = eddy.put_log(&eddy, "link up");
+
+#ifdef EDDY_USE_LOG_QUEUE
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, result);
+	eddy.put_log(&eddy, "link down");
+	test_log_buffer[0] = '\0';
+
+	/* both messages and redraw of line with cursor are printed at once */
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy.drain_logs(&eddy));
+	TEST_ASSERT_EQUAL_STRING("\r\x1b[Jlink up\r\nlink down\r\n>abc\b", test_print_buffer);
+	TEST_ASSERT_EQUAL_STRING("link uplink down", test_log_buffer);
+
+	/* queued messages are printed before input */
+	eddy.put_log(&eddy, "x");
+	eddy.put_char(&eddy, 'd');
+	TEST_ASSERT_EQUAL_STRING("\r\x1b[Jx\r\n>abc\bdc\b", test_print_buffer);
+
+	/* overflow is reported once */
+	for(idx = 0; idx <= EDDY_LOG_SLOTS; idx++) {
+		snprintf(text, sizeof(text), "%d", idx);
+		result = eddy.put_log(&eddy, text);
+	}
+
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, result);
+
+	strcpy(test_print_buffer, "none");
+	eddy.set_log_print_clbk(&eddy, log_store);
+	eddy.drain_logs(&eddy);
+	TEST_ASSERT_NOT_NULL(strstr(test_print_buffer, "(1 log messages dropped)\r\n>abdc\b"));
+
+	strcpy(test_print_buffer, "none");
+	eddy.drain_logs(&eddy);
+	TEST_ASSERT_EQUAL_STRING("none", test_print_buffer);
+
+	/* put_char drains queue also while command is pending */
+	eddy.set_exec_cmd_clbk(&eddy, exec_pending);
+	eddy.put_char(&eddy, '\r');
+	eddy.put_log(&eddy, "busy");
+	eddy.put_char(&eddy, 'e');
+	TEST_ASSERT_EQUAL_STRING("\r\x1b[Kbusy\r\n", test_print_buffer);
+	eddy.command_done(&eddy, EDDY_RETV_OK);
+	TEST_ASSERT_EQUAL_STRING(">e", test_print_buffer);
+#else
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, result);
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, eddy.drain_logs(&eddy));
+#endif
+
+	eddy.destroy(&eddy);
+}
+
+void test_utf8_editing()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	/* character split between calls is printed when complete */
+	strcpy(test_print_buffer, "none");
+	eddy.put_char(&eddy, '\xc5');
+	TEST_ASSERT_EQUAL_STRING("none", test_print_buffer);
+	eddy.put_char(&eddy, '\xbc');
+	TEST_ASSERT_EQUAL_STRING("\xc5\xbc", test_print_buffer);
+
+	/* invalid bytes are dropped */
+	eddy.put_char(&eddy, '\xff');
+	eddy.put_char(&eddy, '\x80');
+
+	/* wide characters take two columns */
+	eddy.put_chars(&eddy, "\xe6\x97\xa5\xe6\x9c\xac", 6);
+	TEST_ASSERT_EQUAL_STRING("\xe6\x97\xa5\xe6\x9c\xac", test_print_buffer);
+	eddy.put_chars(&eddy, "\x1b[D", 3);
+	TEST_ASSERT_EQUAL_STRING("\x1b[2D", test_print_buffer);
+	eddy.put_chars(&eddy, "\x7f", 1);
+	TEST_ASSERT_EQUAL_STRING("\x1b[2D\xe6\x9c\xac\x1b[J\x1b[2D", test_print_buffer);
+	eddy.put_chars(&eddy, "\x1b[Dx", 4);
+	TEST_ASSERT_EQUAL_STRING("\bx\xc5\xbc\xe6\x9c\xac\x1b[3D", test_print_buffer);
+
+	/* combining mark moves and is deleted with its base */
+	eddy.put_chars(&eddy, "\x1b[C\x1b[C\x1b[Ce\xcc\x81", 12);
+	eddy.put_chars(&eddy, "\x1b[D\x1b[3~", 7);
+	TEST_ASSERT_EQUAL_STRING("\b\x1b[J", test_print_buffer);
+
+	eddy.put_char(&eddy, '\r');
+	TEST_ASSERT_EQUAL_STRING("x\xc5\xbc\xe6\x9c\xac", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_term_width_wrap()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, eddy.set_term_width(&eddy, 0));
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, eddy.set_term_width(&eddy, 0x10000));
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy.set_term_width(&eddy, 5));
+
+	/* prompt and four characters fill the row, cursor is taken to next row */
+	eddy.put_chars(&eddy, "abcd", 4);
+	TEST_ASSERT_EQUAL_STRING("abcd\r\n", test_print_buffer);
+	eddy.put_chars(&eddy, "ef", 2);
+	TEST_ASSERT_EQUAL_STRING("ef", test_print_buffer);
+
+	/* cursor crosses row boundary with relative moves */
+	eddy.put_chars(&eddy, "\x1b[D\x1b[D\x1b[D", 9);
+	TEST_ASSERT_EQUAL_STRING("\b\r\x1b[1A\x1b[4C", test_print_buffer);
+
+	/* rest of the line is printed again across rows */
+	eddy.put_char(&eddy, 'X');
+	TEST_ASSERT_EQUAL_STRING("Xdef\r", test_print_buffer);
+	eddy.put_chars(&eddy, "\x7f", 1);
+	TEST_ASSERT_EQUAL_STRING("\x1b[1A\x1b[4Cdef\x1b[J\x1b[1A\x1b[2C", test_print_buffer);
+
+	/* enter leaves all rows of the line */
+	eddy.put_char(&eddy, '\r');
+	TEST_ASSERT_EQUAL_STRING("abcdef", test_exec_buffer);
+
+	/* terminal reports cursor column, then column at right edge */
+	eddy.query_term_width(&eddy);
+	TEST_ASSERT_EQUAL_STRING("\x1b[6n", test_print_buffer);
+	eddy.put_chars(&eddy, "\x1b[3;2R", 6);
+	TEST_ASSERT_EQUAL_STRING("\x1b[999C\x1b[6n", test_print_buffer);
+	eddy.put_chars(&eddy, "\x1b[3;40R", 7);
+	TEST_ASSERT_EQUAL_STRING("\x1b[38D", test_print_buffer);
+
+	eddy.put_chars(&eddy, "abcdef", 6);
+	TEST_ASSERT_EQUAL_STRING("abcdef", test_print_buffer);
+
+	/* query without answer ends with next key, Shift-F3 is not a report */
+	eddy.query_term_width(&eddy);
+	eddy.put_char(&eddy, 'g');
+	TEST_ASSERT_EQUAL_STRING("g", test_print_buffer);
+	eddy.put_chars(&eddy, "\x1b[1;2R", 6);
+	TEST_ASSERT_EQUAL_STRING("g", test_print_buffer);
+
+	eddy.query_term_width(&eddy);
+	eddy.put_chars(&eddy, "\x1b[D\x1b[1;5R", 9);
+	TEST_ASSERT_EQUAL_STRING("\b", test_print_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_kill_yank()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	eddy.put_chars(&eddy, "set led on", 10);
+
+	/* each command is one buffer operation with one redraw */
+	eddy.put_char(&eddy, '\x17');
+	TEST_ASSERT_EQUAL_STRING("\x1b[2D\x1b[J", test_print_buffer);
+	eddy.put_char(&eddy, '\x01');
+	TEST_ASSERT_EQUAL_STRING("\x1b[8D", test_print_buffer);
+	eddy.put_chars(&eddy, "\x1b" "f", 2);
+	TEST_ASSERT_EQUAL_STRING("\x1b[3C", test_print_buffer);
+	eddy.put_char(&eddy, '\x0b');
+	TEST_ASSERT_EQUAL_STRING("\x1b[J", test_print_buffer);
+
+	/* last killed text is inserted back */
+	eddy.put_char(&eddy, '\x19');
+	TEST_ASSERT_EQUAL_STRING(" led ", test_print_buffer);
+	eddy.put_char(&eddy, '\x15');
+	TEST_ASSERT_EQUAL_STRING("\x1b[8D\x1b[J", test_print_buffer);
+	eddy.put_char(&eddy, '\x19');
+	TEST_ASSERT_EQUAL_STRING("set led ", test_print_buffer);
+
+	eddy.put_chars(&eddy, "\x1b[H", 3);
+	TEST_ASSERT_EQUAL_STRING("\x1b[8D", test_print_buffer);
+	eddy.put_chars(&eddy, "\x1b[F", 3);
+	TEST_ASSERT_EQUAL_STRING("\x1b[8C", test_print_buffer);
+	eddy.put_chars(&eddy, "\x1b" "b", 2);
+	TEST_ASSERT_EQUAL_STRING("\x1b[4D", test_print_buffer);
+
+	/* rest of the line is printed once after kill */
+	eddy.put_char(&eddy, '\x17');
+	TEST_ASSERT_EQUAL_STRING("\x1b[4Dled \x1b[J\x1b[4D", test_print_buffer);
+
+	eddy.put_char(&eddy, '\r');
+	TEST_ASSERT_EQUAL_STRING("led ", test_exec_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+void test_screen_render()
+{
+	static vt_screen_t screen;
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	vt_screen_init(&screen, 10, 5);
+	vt_screen_attach(&screen);
+	eddy.set_cli_print_clbk(&eddy, vt_screen_print);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+	eddy.set_term_width(&eddy, 10);
+
+	eddy.show_prompt(&eddy);
+	eddy.put_chars(&eddy, "show interfaces", 15);
+	TEST_ASSERT_EQUAL_STRING(">show inte", vt_screen_row(&screen, 0));
+	TEST_ASSERT_EQUAL_STRING("rfaces", vt_screen_row(&screen, 1));
+	TEST_ASSERT_EQUAL(1, screen.row);
+	TEST_ASSERT_EQUAL(6, screen.col);
+
+	/* kill and yank redraw both rows */
+	eddy.put_chars(&eddy, "\x01\x0b", 2);
+	TEST_ASSERT_EQUAL_STRING(">", vt_screen_row(&screen, 0));
+	TEST_ASSERT_EQUAL_STRING("", vt_screen_row(&screen, 1));
+	eddy.put_chars(&eddy, "\x19", 1);
+	TEST_ASSERT_EQUAL_STRING("rfaces", vt_screen_row(&screen, 1));
+
+	/* insert before wrapped word costs its rest and one cursor jump */
+	eddy.put_chars(&eddy, "\x1b" "b", 2);
+	vt_screen_reset_counters(&screen);
+	eddy.put_chars(&eddy, "eth ", 4);
+	TEST_ASSERT_EQUAL_STRING(">show eth", vt_screen_row(&screen, 0));
+	TEST_ASSERT_EQUAL_STRING("interfaces", vt_screen_row(&screen, 1));
+	TEST_ASSERT_EQUAL(1, screen.row);
+	TEST_ASSERT_EQUAL(0, screen.col);
+	TEST_ASSERT_EQUAL(1, screen.prints);
+	TEST_ASSERT_EQUAL(0, screen.unknown);
+	TEST_ASSERT_EQUAL(20, screen.bytes);
+	TEST_ASSERT_EQUAL(6, screen.move_bytes);
+
+	eddy.put_char(&eddy, '\r');
+	TEST_ASSERT_EQUAL_STRING("show eth interfaces", test_exec_buffer);
+	TEST_ASSERT_EQUAL_STRING(">", vt_screen_row(&screen, 2));
+
+	eddy.destroy(&eddy);
+}
+
+void test_screen_wide_edge()
+{
+	static vt_screen_t screen;
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	vt_screen_init(&screen, 9, 5);
+	vt_screen_attach(&screen);
+	eddy.set_cli_print_clbk(&eddy, vt_screen_print);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+	eddy.set_term_width(&eddy, 9);
+	eddy.set_prompt(&eddy, "P#");
+
+	/* wide character does not fit in the last column and leaves it blank */
+	eddy.show_prompt(&eddy);
+	eddy.put_chars(&eddy, "abcd\xE6\x97\xA5\xE6\x9C\xAC", 10);
+	TEST_ASSERT_EQUAL_STRING("P#abcd\xE6\x97\xA5", vt_screen_row(&screen, 0));
+	TEST_ASSERT_EQUAL_STRING("\xE6\x9C\xAC", vt_screen_row(&screen, 1));
+	TEST_ASSERT_EQUAL(1, screen.row);
+	TEST_ASSERT_EQUAL(2, screen.col);
+
+	eddy.put_char(&eddy, '\x01');
+	TEST_ASSERT_EQUAL(0, screen.row);
+	TEST_ASSERT_EQUAL(2, screen.col);
+
+	eddy.put_char(&eddy, '\x05');
+	TEST_ASSERT_EQUAL(1, screen.row);
+	TEST_ASSERT_EQUAL(2, screen.col);
+
+	/* cursor before wrapped character stays on blank cell */
+	eddy.put_chars(&eddy, "\x1b[D", 3);
+	TEST_ASSERT_EQUAL(0, screen.row);
+	TEST_ASSERT_EQUAL(8, screen.col);
+	eddy.put_chars(&eddy, "\x1b[D", 3);
+	TEST_ASSERT_EQUAL(6, screen.col);
+	eddy.put_chars(&eddy, "\x1b[C\x1b[C", 6);
+	TEST_ASSERT_EQUAL(1, screen.row);
+	TEST_ASSERT_EQUAL(2, screen.col);
+
+	/* insert at the beginning fills the last column, delete brings padding back */
+	eddy.put_chars(&eddy, "\x01x", 2);
+	TEST_ASSERT_EQUAL_STRING("P#xabcd\xE6\x97\xA5", vt_screen_row(&screen, 0));
+	TEST_ASSERT_EQUAL_STRING("\xE6\x9C\xAC", vt_screen_row(&screen, 1));
+	TEST_ASSERT_EQUAL(0, screen.row);
+	TEST_ASSERT_EQUAL(3, screen.col);
+
+	eddy.put_chars(&eddy, "\x7f", 1);
+	TEST_ASSERT_EQUAL_STRING("P#abcd\xE6\x97\xA5", vt_screen_row(&screen, 0));
+	TEST_ASSERT_EQUAL_STRING("\xE6\x9C\xAC", vt_screen_row(&screen, 1));
+	TEST_ASSERT_EQUAL(0, screen.row);
+	TEST_ASSERT_EQUAL(2, screen.col);
+
+	eddy.put_char(&eddy, '\r');
+	TEST_ASSERT_EQUAL_STRING("abcd\xE6\x97\xA5\xE6\x9C\xAC", test_exec_buffer);
+	TEST_ASSERT_EQUAL_STRING("P#", vt_screen_row(&screen, 2));
+
+	eddy.destroy(&eddy);
+}
+
+char test_record_buffer[256];
+size_t test_record_len;
+
+void record_session(eddy_p self, eddy_record_t kind, const char* data, eddy_size_t len)
+{
+	static const char kinds[] = "IOXD";
+
+	test_record_buffer[test_record_len++] = kinds[kind];
+	memcpy(test_record_buffer + test_record_len, data, len);
+	test_record_len += len;
+}
+
+void test_recorder()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_command);
+
+	test_record_len = 0;
+	result = eddy.set_recorder_clbk(&eddy, record_session);
+
+#ifdef EDDY_USE_RECORDER
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, result);
+
+	/* split escape sequence is recorded as received */
+	eddy.put_chars(&eddy, "ab\x1b[", 4);
+	eddy.put_char(&eddy, 'D');
+	eddy.put_char(&eddy, '\r');
+
+	/* command status is recorded between output of line end and prompt */
+	TEST_ASSERT_EQUAL(21, test_record_len);
+	TEST_ASSERT_EQUAL_MEMORY("Iab\x1b[" "Oab" "ID" "O\b" "I\r" "O\r\n" "X\0" "O>", test_record_buffer, 21);
+#else
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, result);
+#endif
+
+	eddy.destroy(&eddy);
+}
+
+char test_batch_buffer[256];
+
+eddy_retv_t exec_batch(const char* cmd_line)
+{
+	strcat(test_batch_buffer, cmd_line);
+	strcat(test_batch_buffer, "|");
+	return (strcmp(cmd_line, "bad") == 0) ? EDDY_RETV_ERR : EDDY_RETV_OK;
+}
+
+void test_batch_mode()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console_count);
+	eddy.set_exec_cmd_clbk(&eddy, exec_batch);
+	eddy.put_chars(&eddy, "sh", 2);
+
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy.set_batch_mode(&eddy, 1));
+
+	/* keys are not decoded, empty lines are skipped, nothing is echoed */
+	test_batch_buffer[0] = '\0';
+	test_print_calls = 0;
+	eddy.put_chars(&eddy, "ow\r\nset a\x1b[D 1\n\n", 16);
+	eddy.put_char(&eddy, 'x');
+	eddy.put_chars(&eddy, "y\rlast", 6);
+
+	TEST_ASSERT_EQUAL_STRING("show|set a\x1b[D 1|xy|", test_batch_buffer);
+	TEST_ASSERT_EQUAL(0, test_print_calls);
+
+	/* only error of command is printed */
+	eddy.put_chars(&eddy, "\rbad\n", 5);
+
+	TEST_ASSERT_EQUAL_STRING("show|set a\x1b[D 1|xy|last|bad|", test_batch_buffer);
+	TEST_ASSERT_EQUAL(1, test_print_calls);
+	TEST_ASSERT_EQUAL_STRING("ERROR\r\n", test_print_buffer);
+
+	/* unfinished line is edited after return to interactive mode */
+	eddy.put_chars(&eddy, "ok", 2);
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy.set_batch_mode(&eddy, 0));
+	eddy.put_chars(&eddy, "\x7f" "n\r", 3);
+
+	TEST_ASSERT_EQUAL_STRING("show|set a\x1b[D 1|xy|last|bad|on|", test_batch_buffer);
+	TEST_ASSERT_EQUAL_STRING(">", test_print_buffer);
+
+	eddy.destroy(&eddy);
+}
+
+size_t test_line_dropped;
+size_t test_exec_len;
+
+void line_full(eddy_p self, eddy_size_t dropped)
+{
+	test_line_dropped += dropped;
+}
+
+eddy_retv_t exec_len(const char* cmd_line)
+{
+	test_exec_len = strlen(cmd_line);
+	strncpy(test_exec_buffer, cmd_line, 8);
+	test_exec_buffer[8] = '\0';
+	return EDDY_RETV_OK;
+}
+
+void fill_hint(char* cmd_line)
+{
+	memset(cmd_line, 'h', EDDY_MAX_LINE_BUFF_LEN - 1);
+	cmd_line[EDDY_MAX_LINE_BUFF_LEN - 1] = '\0';
+}
+
+void test_line_growth()
+{
+	static char fill[1200];
+	static char buffer[EDDY_MAX_LINE_BUFF_LEN * 2];
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_len);
+	eddy.set_line_full_clbk(&eddy, line_full);
+	memset(fill, 'a', sizeof(fill));
+
+	/* characters over buffer size are dropped with single notification */
+	test_line_dropped = 0;
+	eddy.put_chars(&eddy, fill, EDDY_MAX_LINE_BUFF_LEN + 44);
+	eddy.put_char(&eddy, '\r');
+
+	TEST_ASSERT_EQUAL(45, test_line_dropped);
+	TEST_ASSERT_EQUAL(EDDY_MAX_LINE_BUFF_LEN - 1, test_exec_len);
+
+	/* short line grows before hint callback can complete it */
+	eddy.set_check_hint_clbk(&eddy, fill_hint);
+	eddy.put_chars(&eddy, "h\t\r", 3);
+
+	TEST_ASSERT_EQUAL(EDDY_MAX_LINE_BUFF_LEN - 1, test_exec_len);
+
+	/* line grows up to limit, text after cursor is kept */
+	test_line_dropped = 0;
+	eddy.set_line_limit(&eddy, EDDY_MAX_LINE_BUFF_LEN * 4);
+	eddy.put_chars(&eddy, "xyz\x1b[D\x1b[D", 9);
+	eddy.put_chars(&eddy, fill, EDDY_MAX_LINE_BUFF_LEN * 2);
+	eddy.put_char(&eddy, '\r');
+
+	TEST_ASSERT_EQUAL(0, test_line_dropped);
+	TEST_ASSERT_EQUAL(EDDY_MAX_LINE_BUFF_LEN * 2 + 3, test_exec_len);
+	TEST_ASSERT_EQUAL_STRING("xaaaaaaa", test_exec_buffer);
+
+	eddy.put_chars(&eddy, fill, EDDY_MAX_LINE_BUFF_LEN * 4 + 10);
+	eddy.put_char(&eddy, '\r');
+
+	TEST_ASSERT_EQUAL(11, test_line_dropped);
+	TEST_ASSERT_EQUAL(EDDY_MAX_LINE_BUFF_LEN * 4 - 1, test_exec_len);
+
+	/* buffer of application, it can be smaller than line limit */
+	test_line_dropped = 0;
+	eddy.set_line_limit(&eddy, 0);
+	eddy.put_chars(&eddy, "abcd", 4);
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, eddy.set_line_buff(&eddy, buffer, 4));
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy.set_line_buff(&eddy, buffer, 8));
+	eddy.put_chars(&eddy, fill, 10);
+	eddy.put_char(&eddy, '\r');
+
+	TEST_ASSERT_EQUAL(7, test_line_dropped);
+	TEST_ASSERT_EQUAL_STRING("abcdaaa", test_exec_buffer);
+
+	test_line_dropped = 0;
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy.set_line_buff(&eddy, buffer, sizeof(buffer)));
+	eddy.put_chars(&eddy, fill, EDDY_MAX_LINE_BUFF_LEN + 10);
+
+	TEST_ASSERT_EQUAL(EDDY_RETV_ERR, eddy.set_line_buff(&eddy, NULL, 0));
+	eddy.put_char(&eddy, '\r');
+
+	TEST_ASSERT_EQUAL(0, test_line_dropped);
+	TEST_ASSERT_EQUAL(EDDY_MAX_LINE_BUFF_LEN + 10, test_exec_len);
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, eddy.set_line_buff(&eddy, NULL, 0));
+
+	/* without growth line stays in buffer inside context */
+	eddy.put_chars(&eddy, fill, EDDY_MAX_LINE_BUFF_LEN);
+	eddy.put_char(&eddy, '\r');
+
+	TEST_ASSERT_EQUAL(EDDY_LINE_STORE_LEN - 1, test_exec_len);
+
+	eddy.destroy(&eddy);
+}
+
+void test_line_static_no_alloc()
+{
+	static eddy_ctx_storage_t storage;
+	static char fill[EDDY_MAX_LINE_BUFF_LEN];
+	eddy_t eddy;
+
+	TEST_ASSERT_EQUAL(EDDY_RETV_OK, init_eddy_static(&eddy, &storage, sizeof(storage)));
+
+	test_malloc_fail = true;
+	eddy.set_cli_print_clbk(&eddy, print_console);
+	eddy.set_exec_cmd_clbk(&eddy, exec_len);
+	eddy.set_line_full_clbk(&eddy, line_full);
+	memset(fill, 'a', sizeof(fill));
+
+	/* line fills buffer inside context, rest is dropped without allocation */
+	test_line_dropped = 0;
+	eddy.put_chars(&eddy, fill, EDDY_LINE_STORE_LEN + 9);
+	eddy.put_char(&eddy, '\r');
+
+	TEST_ASSERT_EQUAL(10, test_line_dropped);
+	TEST_ASSERT_EQUAL(EDDY_LINE_STORE_LEN - 1, test_exec_len);
+
+	/* hint longer than buffer does not overwrite context */
+	eddy.set_check_hint_clbk(&eddy, fill_hint);
+	eddy.put_chars(&eddy, "h\t\t\r", 4);
+
+	TEST_ASSERT_EQUAL(EDDY_LINE_STORE_LEN - 1, test_exec_len);
+	TEST_ASSERT_EQUAL_STRING("hhhhhhhh", test_exec_buffer);
+
+	test_malloc_fail = false;
+	eddy.destroy(&eddy);
+}
+
+void test_shared_ops()
+{
+	eddy_t eddy;
+	eddy_retv_t result;
+
+	result = init_eddy(&eddy);
+
+	TEST_ASSERT_EQUAL(result, EDDY_RETV_OK);
+	TEST_ASSERT_EQUAL_PTR(&eddy_ops, eddy.ops);
+	TEST_ASSERT_EQUAL(0, (size_t)eddy.ctx % EDDY_CACHE_LINE);
+#ifndef EDDY_USE_SHARED_OPS
+	TEST_ASSERT_EQUAL_PTR(eddy_ops.put_chars, eddy.put_chars);
+	TEST_ASSERT_EQUAL_PTR(eddy_ops.destroy, eddy.destroy);
+#endif
+
+	eddy.ops->set_cli_print_clbk(&eddy, print_console);
+	eddy.ops->set_exec_cmd_clbk(&eddy, exec_command);
+	eddy.ops->put_chars(&eddy, "show\r", 5);
+
+	TEST_ASSERT_EQUAL_STRING("show", test_exec_buffer);
+
+	eddy.ops->destroy(&eddy);
+
+	TEST_ASSERT_NULL(eddy.ops);
+}
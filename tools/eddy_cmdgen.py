@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""Generate const eddy command map with perfect hash lookup.
+
+Usage: eddy_cmdgen.py [-n name] [-b buckets] input.def output.c
+
+Input file lists commands with X-macro entries, one per line:
+
+    EDDY_CMD("set", cmd_set, "set <name> <value>", 2, 2)
+    EDDY_CMD("reboot", cmd_reboot, NULL, 0, 0)
+    EDDY_CMD("led", cmd_led, "led <name>", 1, 1, complete_led)
+
+Command name must be quoted string literal without spaces or escapes,
+e.g. EDDY_CMD("set", ...). Optional last field is argument completion
+provider. Entry which can not be parsed is reported as error.
+
+Other lines are ignored, so the same file can be included from C code
+with own EDDY_CMD definition. Output file defines const eddy_cmd_map_t
+with given name (default eddy_cmd_map) which can be passed to
+set_cmd_map. Command table is placed in slot order and every name is
+found with two hashes and one string compare, see eddy_cmd_hash.
+Const prefix trie of command names (name_trie) is generated too, it can
+be passed to set_completion.
+
+Generated file should be rebuilt from the definition file by the build,
+e.g. with CMake add_custom_command as done for eddy_server_demo in
+CMakeLists.txt, so the map can not drift from its source.
+"""
+import argparse
+import re
+import sys
+
+START = re.compile(r'^\s*EDDY_CMD\s*\(')
+ENTRY = re.compile(r'^\s*EDDY_CMD\(\s*"([^"\\\s]+)"\s*,\s*(\w+)\s*,\s*("(?:[^"\\]|\\.)*"|NULL)\s*,\s*(\d+)\s*,\s*(\d+)\s*(?:,\s*(\w+)\s*)?\)')
+MAX_SEED = 0xFFFF
+
+
+def cmd_hash(name, seed):
+    """Same as eddy_cmd_hash in eddy.c (FNV-1a with seeded basis and final mixing)."""
+    value = 2166136261 ^ seed
+    for byte in name.encode():
+        value ^= byte
+        value = (value * 16777619) & 0xFFFFFFFF
+    value ^= value >> 16
+    value = (value * 0x85EBCA6B) & 0xFFFFFFFF
+    value ^= value >> 13
+    return value
+
+
+def build(names, buckets_cnt):
+    """Find seed of each bucket so all names land in distinct slots."""
+    slots_cnt = len(names)
+    buckets = [[] for _ in range(buckets_cnt)]
+    for idx, name in enumerate(names):
+        buckets[cmd_hash(name, 0) % buckets_cnt].append(idx)
+
+    seeds = [0] * buckets_cnt
+    slots = [None] * slots_cnt
+
+    for bucket in sorted(range(buckets_cnt), key=lambda b: -len(buckets[b])):
+        if not buckets[bucket]:
+            break
+        for seed in range(MAX_SEED + 1):
+            taken = [cmd_hash(names[idx], seed) % slots_cnt for idx in buckets[bucket]]
+            if len(set(taken)) == len(taken) and all(slots[slot] is None for slot in taken):
+                break
+        else:
+            return None
+        seeds[bucket] = seed
+        for idx, slot in zip(buckets[bucket], taken):
+            slots[slot] = idx
+
+    return seeds, slots
+
+
+def build_trie(names):
+    """Same layout as eddy_trie_build: [child, sibling, char, word], node 0 is root."""
+    nodes = [[0, 0, 0, 0]]
+    for name in names:
+        node = 0
+        for char in name.encode():
+            prev = None
+            link = nodes[node][0]
+            while link != 0 and nodes[link][2] < char:
+                prev = link
+                link = nodes[link][1]
+            if link == 0 or nodes[link][2] != char:
+                nodes.append([0, link, char, 0])
+                if prev is None:
+                    nodes[node][0] = len(nodes) - 1
+                else:
+                    nodes[prev][1] = len(nodes) - 1
+                link = len(nodes) - 1
+            node = link
+        nodes[node][3] = 1
+    return nodes
+
+
+def char_literal(char):
+    if char == 0:
+        return '0'
+    if char in b'\\\'':
+        return "'\\%c'" % char
+    if 0x20 < char < 0x7F:
+        return "'%c'" % char
+    return '(char)%u' % char
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate const eddy command map.')
+    parser.add_argument('-n', '--name', default='eddy_cmd_map', help='name of generated map')
+    parser.add_argument('-b', '--buckets', type=int, default=0, help='number of seed buckets (default half of commands)')
+    parser.add_argument('input')
+    parser.add_argument('output')
+    args = parser.parse_args()
+
+    cmds = []
+    with open(args.input) as src:
+        for number, line in enumerate(src, 1):
+            match = ENTRY.match(line)
+            if match:
+                cmds.append(match.groups())
+            elif START.match(line):
+                sys.exit('%s:%u: malformed EDDY_CMD entry, name must be quoted' % (args.input, number))
+
+    names = [cmd[0] for cmd in cmds]
+
+    if not cmds:
+        sys.exit('%s: no EDDY_CMD entries' % args.input)
+    if len(set(names)) != len(names):
+        sys.exit('%s: duplicated command name' % args.input)
+
+    result = build(names, args.buckets or (len(cmds) + 1) // 2)
+
+    if result is None:
+        sys.exit('%s: no perfect hash found, change number of buckets' % args.input)
+
+    seeds, slots = result
+    handlers = sorted(set(cmd[1] for cmd in cmds))
+    providers = sorted(set(cmd[5] for cmd in cmds if cmd[5]))
+    trie = build_trie(names)
+
+    if len(trie) > 0xFFFF:
+        sys.exit('%s: too many trie nodes' % args.input)
+
+    with open(args.output, 'w') as out:
+        out.write('/* Generated by eddy_cmdgen.py from %s, do not edit. */\n' % args.input)
+        out.write('#include "eddy.h"\n\n')
+        for handler in handlers:
+            out.write('eddy_retv_t %s(eddy_p self, int argc, char* argv[]);\n' % handler)
+        for provider in providers:
+            out.write('const eddy_trie_t* %s(eddy_p self, int arg);\n' % provider)
+        out.write('\nstatic const eddy_cmd_t %s_cmds[] = {\n' % args.name)
+        for idx in slots:
+            out.write('\t{ "%s", %s, %s, %s, %s, %s },\n' % (cmds[idx][:5] + (cmds[idx][5] or 'NULL',)))
+        out.write('};\n\nstatic const unsigned short %s_seeds[] = {' % args.name)
+        for idx, seed in enumerate(seeds):
+            out.write('%s%u,' % ('\n\t' if idx % 12 == 0 else ' ', seed))
+        out.write('\n};\n\n')
+        out.write('const eddy_cmd_map_t %s = { %s_cmds, %s_seeds, %u, %u };\n'
+                  % (args.name, args.name, args.name, len(cmds), len(seeds)))
+        out.write('\nstatic const eddy_trie_node_t %s_trie_nodes[] = {\n' % args.name)
+        for node in trie:
+            out.write('\t{ %u, %u, %s, %u },\n' % (node[0], node[1], char_literal(node[2]), node[3]))
+        out.write('};\n\n')
+        out.write('const eddy_trie_t %s_trie = { %s_trie_nodes, %u };\n' % (args.name, args.name, len(trie)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,329 @@
+/**
+ * @file eddy_replay.c
+ * @author Rafał Kędzierski (rafal.kedzierski@gmail.com)
+ * @brief Replay of recorded eddy sessions.
+ * @version 0.1
+ * @date 2023-04-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * Usage: eddy_replay [-t] [-v] [-w cols] trace
+ *
+ * Each recorded session gets fresh eddy context. Input chunks are passed
+ * with put_chars as they were received, executed commands return recorded
+ * status and pending commands are finished where command_done was called.
+ * Events are replayed as fast as possible or, with -t, at recorded times.
+ * Commands are not really executed, so only output of the editor itself
+ * is reproduced.
+ *
+ * With -v every input and command_done event is printed:
+ *
+ *     event=12 session=0 kind=input bytes_in=1 ns=412 bytes_out=1 recorded_out=1
+ *
+ * Summary is printed as key=value pairs at the end.
+ */
+#include "eddy_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define REPLAY_HIST_LEN		1024	/**< Size of history buffer of each session. */
+
+/**
+ * @brief Event loaded from trace.
+ */
+typedef struct replay_event_s {
+	eddy_record_t kind;			/**< Kind of event. */
+	unsigned long session;		/**< Session number. */
+	unsigned long long time_us;	/**< Time since trace start. */
+	char* data;					/**< Event data. */
+	size_t len;					/**< Number of data bytes. */
+	unsigned long recorded_out;	/**< Recorded output caused by this input or done event. */
+} replay_event_t;
+
+/**
+ * @brief Replayed session.
+ */
+typedef struct replay_session_s {
+	unsigned long id;			/**< Session number from trace. */
+	eddy_t eddy;				/**< Replaying context. */
+	char history[REPLAY_HIST_LEN];	/**< History buffer. */
+	size_t exec_scan;			/**< Index of event from which next command status is searched. */
+} replay_session_t;
+
+static replay_event_t* replay_events;
+static size_t replay_events_cnt;
+static replay_session_t** replay_sessions;
+static size_t replay_sessions_cnt;
+static replay_session_t* replay_current;
+static size_t replay_pos;
+static unsigned long replay_out;
+static unsigned int replay_cols = 80;
+
+static unsigned long long replay_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int replay_cmp(const void* a, const void* b)
+{
+	unsigned long long x = *(const unsigned long long*)a;
+	unsigned long long y = *(const unsigned long long*)b;
+
+	return (x > y) - (x < y);
+}
+
+static void replay_write(eddy_p self, const eddy_segment_t* segments, eddy_size_t count)
+{
+	eddy_size_t idx;
+
+	(void)self;
+
+	for(idx = 0; idx < count; idx++) {
+		replay_out += segments[idx].len;
+	}
+}
+
+/**
+ * @brief Return status recorded for next command of current session.
+ */
+static eddy_retv_t replay_exec(const char* cmd_line)
+{
+	replay_session_t* session = replay_current;
+	size_t idx;
+
+	(void)cmd_line;
+
+	for(idx = (session->exec_scan > replay_pos) ? session->exec_scan : replay_pos; idx < replay_events_cnt; idx++) {
+		if(replay_events[idx].kind == EDDY_RECORD_EXEC && replay_events[idx].session == session->id
+			&& replay_events[idx].len == 1) {
+			session->exec_scan = idx + 1;
+			return (eddy_retv_t)replay_events[idx].data[0];
+		}
+	}
+
+	return EDDY_RETV_OK;
+}
+
+/**
+ * @brief Find session by number, new session is created on first use.
+ */
+static replay_session_t* replay_session(unsigned long id)
+{
+	replay_session_t** sessions;
+	replay_session_t* session;
+	size_t idx;
+
+	for(idx = 0; idx < replay_sessions_cnt; idx++) {
+		if(replay_sessions[idx]->id == id) {
+			return replay_sessions[idx];
+		}
+	}
+
+	sessions = realloc(replay_sessions, (replay_sessions_cnt + 1) * sizeof(*sessions));
+	session = calloc(1, sizeof(*session));
+
+	if(sessions == NULL || session == NULL || init_eddy(&session->eddy) != EDDY_RETV_OK) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+
+	replay_sessions = sessions;
+	replay_sessions[replay_sessions_cnt++] = session;
+
+	session->id = id;
+	session->eddy.set_cli_write_clbk(&session->eddy, replay_write);
+	session->eddy.set_exec_cmd_clbk(&session->eddy, replay_exec);
+	session->eddy.set_history_buff(&session->eddy, session->history, sizeof(session->history));
+	session->eddy.set_term_width(&session->eddy, replay_cols);
+
+	replay_current = session;
+	session->eddy.show_prompt(&session->eddy);
+
+	return session;
+}
+
+/**
+ * @brief Load whole trace and assign recorded output to events which caused it.
+ */
+static int replay_load(const char* path)
+{
+	eddy_trace_event_t event;
+	replay_event_t* events;
+	eddy_trace_t trace;
+	size_t size = 0;
+	size_t idx;
+	size_t last;
+
+	if(eddy_trace_open(&trace, path) != EDDY_RETV_OK) {
+		fprintf(stderr, "can not read trace %s\n", path);
+		return 0;
+	}
+
+	while(eddy_trace_get(&trace, &event) == EDDY_RETV_OK) {
+		if(replay_events_cnt == size) {
+			size = (size == 0) ? 1024 : size * 2;
+			events = realloc(replay_events, size * sizeof(*events));
+
+			if(events == NULL) {
+				fprintf(stderr, "out of memory\n");
+				exit(1);
+			}
+
+			replay_events = events;
+		}
+
+		replay_events[replay_events_cnt].kind = event.kind;
+		replay_events[replay_events_cnt].session = event.session;
+		replay_events[replay_events_cnt].time_us = event.time_us;
+		replay_events[replay_events_cnt].data = malloc(event.len + 1);
+		replay_events[replay_events_cnt].len = event.len;
+		replay_events[replay_events_cnt].recorded_out = 0;
+
+		if(replay_events[replay_events_cnt].data == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+
+		memcpy(replay_events[replay_events_cnt].data, event.data, event.len);
+		replay_events_cnt++;
+	}
+
+	if(trace.broken) {
+		fprintf(stderr, "trace is truncated after %lu events\n", (unsigned long)replay_events_cnt);
+	}
+
+	eddy_trace_close(&trace);
+
+	for(idx = 0; idx < replay_events_cnt; idx++) {
+		if(replay_events[idx].kind != EDDY_RECORD_OUTPUT) {
+			continue;
+		}
+
+		for(last = idx; last > 0; last--) {
+			if(replay_events[last - 1].session == replay_events[idx].session
+				&& (replay_events[last - 1].kind == EDDY_RECORD_INPUT || replay_events[last - 1].kind == EDDY_RECORD_DONE)) {
+				replay_events[last - 1].recorded_out += replay_events[idx].len;
+				break;
+			}
+		}
+	}
+
+	return 1;
+}
+
+int main(int argc, char** argv)
+{
+	static const char* const kinds[] = { "input", "output", "exec", "done" };
+	unsigned long long* samples;
+	unsigned long long start_ns;
+	unsigned long long wall_ns;
+	unsigned long long ns;
+	unsigned long long total_ns = 0;
+	unsigned long samples_cnt = 0;
+	unsigned long bytes_in = 0;
+	unsigned long bytes_out = 0;
+	unsigned long recorded_out = 0;
+	replay_event_t* event;
+	replay_session_t* session;
+	int realtime = 0;
+	int verbose = 0;
+	int opt;
+
+	while((opt = getopt(argc, argv, "tvw:")) != -1) {
+		switch(opt) {
+		case 't':
+			realtime = 1;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		case 'w':
+			replay_cols = (unsigned int)strtoul(optarg, NULL, 0);
+			break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+
+	if(optind != argc - 1 || replay_cols == 0) {
+		fprintf(stderr, "usage: %s [-t] [-v] [-w cols] trace\n", argv[0]);
+		return 1;
+	}
+
+	if(!replay_load(argv[optind])) {
+		return 1;
+	}
+
+	samples = malloc((replay_events_cnt + 1) * sizeof(*samples));
+
+	if(samples == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	wall_ns = replay_now_ns();
+
+	for(replay_pos = 0; replay_pos < replay_events_cnt; replay_pos++) {
+		event = &replay_events[replay_pos];
+
+		if(event->kind != EDDY_RECORD_INPUT && event->kind != EDDY_RECORD_DONE) {
+			continue;
+		}
+
+		if(realtime) {
+			while((ns = replay_now_ns() - wall_ns) < event->time_us * 1000ULL) {
+				usleep((useconds_t)((event->time_us * 1000ULL - ns) / 1000ULL));
+			}
+		}
+
+		session = replay_session(event->session);
+		replay_current = session;
+		replay_out = 0;
+
+		start_ns = replay_now_ns();
+
+		if(event->kind == EDDY_RECORD_INPUT) {
+			session->eddy.put_chars(&session->eddy, event->data, event->len);
+			bytes_in += event->len;
+		} else if(event->len == 1) {
+			session->eddy.command_done(&session->eddy, (eddy_retv_t)event->data[0]);
+		}
+
+		ns = replay_now_ns() - start_ns;
+		total_ns += ns;
+		samples[samples_cnt++] = ns;
+		bytes_out += replay_out;
+		recorded_out += event->recorded_out;
+
+		if(verbose) {
+			printf("event=%lu session=%lu kind=%s bytes_in=%lu ns=%llu bytes_out=%lu recorded_out=%lu\n",
+				(unsigned long)replay_pos, event->session, kinds[event->kind],
+				(event->kind == EDDY_RECORD_INPUT) ? (unsigned long)event->len : 0UL,
+				ns, replay_out, event->recorded_out);
+		}
+	}
+
+	if(samples_cnt == 0) {
+		samples[samples_cnt++] = 0;
+	}
+
+	qsort(samples, samples_cnt, sizeof(*samples), replay_cmp);
+
+	printf("events=%lu sessions=%lu bytes_in=%lu bytes_out=%lu recorded_out=%lu total_ms=%.3f "
+		"p50_ns=%llu p99_ns=%llu max_ns=%llu\n",
+		samples_cnt, (unsigned long)replay_sessions_cnt, bytes_in, bytes_out, recorded_out, total_ns / 1e6,
+		samples[samples_cnt * 50 / 100], samples[samples_cnt * 99 / 100], samples[samples_cnt - 1]);
+
+	free(samples);
+
+	return 0;
+}
@@ -0,0 +1,196 @@
+/**
+ * @file eddy_trace.c
+ * @author Rafał Kędzierski (rafal.kedzierski@gmail.com)
+ * @brief Binary trace of recorded eddy sessions.
+ * @version 0.1
+ * @date 2023-04-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "eddy_trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define EDDY_TRACE_VARINT_LEN	10	/**< Maximal length of 64-bit varint. */
+
+static unsigned long long eddy_trace_now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (unsigned long long)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Encode varint.
+ *
+ * @return unsigned int Number of bytes.
+ */
+static unsigned int eddy_trace_varint(unsigned char* out, unsigned long long value)
+{
+	unsigned int len = 0;
+
+	while(value >= 0x80) {
+		out[len++] = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+
+	out[len++] = (unsigned char)value;
+
+	return len;
+}
+
+/**
+ * @brief Read varint from file.
+ */
+static eddy_retv_t eddy_trace_read_varint(FILE* file, unsigned long long* value)
+{
+	unsigned int shift;
+	int c;
+
+	*value = 0;
+
+	for(shift = 0; shift < 7 * EDDY_TRACE_VARINT_LEN; shift += 7) {
+		c = fgetc(file);
+
+		if(c == EOF) {
+			return EDDY_RETV_ERR;
+		}
+
+		*value |= (unsigned long long)(c & 0x7F) << shift;
+
+		if((c & 0x80) == 0) {
+			return EDDY_RETV_OK;
+		}
+	}
+
+	return EDDY_RETV_ERR;
+}
+
+eddy_retv_t eddy_trace_create(eddy_trace_t* trace, const char* path)
+{
+	memset(trace, 0, sizeof(*trace));
+
+	trace->file = fopen(path, "wb");
+
+	if(trace->file == NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	if(fwrite(EDDY_TRACE_MAGIC, 1, 8, trace->file) != 8) {
+		eddy_trace_close(trace);
+		return EDDY_RETV_ERR;
+	}
+
+	trace->last_us = eddy_trace_now_us();
+
+	return EDDY_RETV_OK;
+}
+
+eddy_retv_t eddy_trace_open(eddy_trace_t* trace, const char* path)
+{
+	char magic[8];
+
+	memset(trace, 0, sizeof(*trace));
+
+	trace->file = fopen(path, "rb");
+
+	if(trace->file == NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	if(fread(magic, 1, 8, trace->file) != 8 || memcmp(magic, EDDY_TRACE_MAGIC, 8) != 0) {
+		eddy_trace_close(trace);
+		return EDDY_RETV_ERR;
+	}
+
+	return EDDY_RETV_OK;
+}
+
+eddy_retv_t eddy_trace_put(eddy_trace_t* trace, unsigned long session, eddy_record_t kind, const char* data, size_t len)
+{
+	unsigned char head[1 + 3 * EDDY_TRACE_VARINT_LEN];
+	unsigned long long now = eddy_trace_now_us();
+	unsigned int head_len = 0;
+
+	if(trace->file == NULL) {
+		return EDDY_RETV_ERR;
+	}
+
+	head[head_len++] = (unsigned char)kind;
+	head_len += eddy_trace_varint(head + head_len, session);
+	head_len += eddy_trace_varint(head + head_len, now - trace->last_us);
+	head_len += eddy_trace_varint(head + head_len, len);
+	trace->last_us = now;
+
+	if(fwrite(head, 1, head_len, trace->file) != head_len
+		|| (len > 0 && fwrite(data, 1, len, trace->file) != len)) {
+		return EDDY_RETV_ERR;
+	}
+
+	return EDDY_RETV_OK;
+}
+
+eddy_retv_t eddy_trace_get(eddy_trace_t* trace, eddy_trace_event_t* event)
+{
+	unsigned long long session;
+	unsigned long long delta;
+	unsigned long long len;
+	char* data;
+	int kind;
+
+	if(trace->file == NULL || (kind = fgetc(trace->file)) == EOF) {
+		return EDDY_RETV_ERR;
+	}
+
+	if(kind > EDDY_RECORD_DONE
+		|| eddy_trace_read_varint(trace->file, &session) != EDDY_RETV_OK
+		|| eddy_trace_read_varint(trace->file, &delta) != EDDY_RETV_OK
+		|| eddy_trace_read_varint(trace->file, &len) != EDDY_RETV_OK) {
+		trace->broken = 1;
+		return EDDY_RETV_ERR;
+	}
+
+	if(len > trace->data_size) {
+		data = realloc(trace->data, len);
+
+		if(data == NULL) {
+			trace->broken = 1;
+			return EDDY_RETV_ERR;
+		}
+
+		trace->data = data;
+		trace->data_size = len;
+	}
+
+	if(len > 0 && fread(trace->data, 1, len, trace->file) != len) {
+		trace->broken = 1;
+		return EDDY_RETV_ERR;
+	}
+
+	trace->last_us += delta;
+
+	event->kind = (eddy_record_t)kind;
+	event->session = (unsigned long)session;
+	event->time_us = trace->last_us;
+	event->data = trace->data;
+	event->len = len;
+
+	return EDDY_RETV_OK;
+}
+
+void eddy_trace_close(eddy_trace_t* trace)
+{
+	if(trace->file != NULL) {
+		fclose(trace->file);
+		trace->file = NULL;
+	}
+
+	free(trace->data);
+	trace->data = NULL;
+	trace->data_size = 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file eddy_trace.h
+ * @author Rafał Kędzierski (rafal.kedzierski@gmail.com)
+ * @brief Binary trace of recorded eddy sessions.
+ * @version 0.1
+ * @date 2023-04-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ * Events passed to recorder callback (see EDDY_USE_RECORDER) are stored
+ * with time and session number, so session can be replayed by eddy_replay
+ * with the same input chunks. Example of recording:
+ *
+ *     static eddy_trace_t trace;
+ *
+ *     static void record(eddy_p self, eddy_record_t kind, const char* data, eddy_size_t len)
+ *     {
+ *         eddy_trace_put(&trace, session_number(self), kind, data, len);
+ *     }
+ *
+ *     eddy_trace_create(&trace, "console.trace");
+ *     eddy.set_recorder_clbk(&eddy, record);
+ *
+ * Trace starts with magic "EDDYTRC1" followed by events:
+ *
+ *     kind     1 byte, eddy_record_t
+ *     session  varint, number given by recording application
+ *     delta    varint, microseconds since previous event
+ *     len      varint, number of data bytes
+ *     data     len bytes
+ *
+ * Varints hold 7 bits per byte, least significant first, high bit is set
+ * in all bytes except the last one.
+ */
+#ifndef __EDDY_TRACE_H__
+#define __EDDY_TRACE_H__
+
+#include "eddy.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Magic at the beginning of trace file.
+ */
+#define EDDY_TRACE_MAGIC	"EDDYTRC1"
+
+/**
+ * @brief Trace event.
+ */
+typedef struct eddy_trace_event_s {
+	eddy_record_t kind;			/**< Kind of event. */
+	unsigned long session;		/**< Session number. */
+	unsigned long long time_us;	/**< Time since trace start. */
+	const char* data;			/**< Event data, valid until next eddy_trace_get. */
+	size_t len;					/**< Number of data bytes. */
+} eddy_trace_event_t;
+
+/**
+ * @brief Trace file opened for writing or reading.
+ */
+typedef struct eddy_trace_s {
+	FILE* file;					/**< Trace file. */
+	unsigned long long last_us;	/**< Time of previous event. */
+	char* data;					/**< Data of last read event. */
+	size_t data_size;			/**< Size of data buffer. */
+	int broken;					/**< Reading stopped on malformed event. */
+} eddy_trace_t;
+
+/**
+ * @brief Create new trace file.
+ *
+ * @param trace Pointer on trace.
+ * @param path Path of created file.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_trace_create(eddy_trace_t* trace, const char* path);
+
+/**
+ * @brief Open trace file for reading.
+ *
+ * @param trace Pointer on trace.
+ * @param path Path of trace file.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if file can not be read or is not trace.
+ */
+eddy_retv_t eddy_trace_open(eddy_trace_t* trace, const char* path);
+
+/**
+ * @brief Append event stamped with current time.
+ *
+ * @param trace Pointer on trace created with eddy_trace_create.
+ * @param session Session number.
+ * @param kind Kind of event.
+ * @param data Event data.
+ * @param len Number of data bytes.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR if error.
+ */
+eddy_retv_t eddy_trace_put(eddy_trace_t* trace, unsigned long session, eddy_record_t kind, const char* data, size_t len);
+
+/**
+ * @brief Read next event.
+ *
+ * @param trace Pointer on trace opened with eddy_trace_open.
+ * @param event Pointer on structure filled with event.
+ * @return eddy_retv_t Error code: EDDY_RETV_OK if succes or EDDY_RETV_ERR at the end of trace or if event is malformed (broken is set).
+ */
+eddy_retv_t eddy_trace_get(eddy_trace_t* trace, eddy_trace_event_t* event);
+
+/**
+ * @brief Close trace file.
+ *
+ * @param trace Pointer on trace.
+ */
+void eddy_trace_close(eddy_trace_t* trace);
+
+#endif /* __EDDY_TRACE_H__ */